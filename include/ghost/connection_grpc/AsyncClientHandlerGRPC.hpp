@@ -0,0 +1,71 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_ASYNCCLIENTHANDLERGRPC_HPP
+#define GHOST_ASYNCCLIENTHANDLERGRPC_HPP
+
+#include <google/protobuf/any.pb.h>
+
+#include <ghost/connection/ClientHandler.hpp>
+#include <memory>
+
+namespace ghost
+{
+/**
+ *	Message-driven client handler for gRPC servers.
+ *	When an instance of this class is set as the client handler of a gRPC server, no thread
+ *	is reserved for the lifetime of the clients: the server calls "onConnected" when a client
+ *	connected, "onMessage" for every message received from it, and "onDisconnected" once
+ *	the client is gone or was stopped.
+ *
+ *	"onConnected" and "onMessage" are called from the completion queue threads of the server,
+ *	"onDisconnected" from the server's thread pool. The calls are never concurrent for one
+ *	client and the messages of a client are handled in the order they were received.
+ *	The next message of a client is only read once "onMessage" returned: the implementations
+ *	must not block, long operations should be executed elsewhere.
+ *
+ *	The received messages are given to this handler only, the message handlers and readers of
+ *	the clients do not receive them. The clients' writers can be used at any time to answer.
+ */
+class AsyncClientHandlerGRPC : public ghost::ClientHandler
+{
+public:
+	virtual ~AsyncClientHandlerGRPC() = default;
+
+	/// Called once the client is connected and before its first message is handled.
+	virtual void onConnected(const std::shared_ptr<ghost::Client>& /*client*/)
+	{
+	}
+
+	/// Called for every message received from the client.
+	virtual void onMessage(const std::shared_ptr<ghost::Client>& client, const google::protobuf::Any& message) = 0;
+
+	/// Called once after the connection with the client ended, no message follows.
+	virtual void onDisconnected(const std::shared_ptr<ghost::Client>& /*client*/)
+	{
+	}
+
+	/// Not used by the gRPC servers, the clients are kept alive until they disconnect.
+	bool handle(std::shared_ptr<ghost::Client> /*client*/, bool& keepClientAlive) final
+	{
+		keepClientAlive = true;
+		return true;
+	}
+};
+} // namespace ghost
+
+#endif // GHOST_ASYNCCLIENTHANDLERGRPC_HPP
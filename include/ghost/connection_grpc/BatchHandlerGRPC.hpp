@@ -0,0 +1,89 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GHOST_BATCHHANDLERGRPC_HPP
+#define GHOST_BATCHHANDLERGRPC_HPP
+
+#include <google/protobuf/any.pb.h>
+
+#include <chrono>
+#include <functional>
+#include <ghost/connection/Subscriber.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ghost
+{
+/**
+ *	Delivers the messages received by a gRPC subscriber in batches instead of one by one.
+ *	A batch is delivered once it holds "maxMessages" messages, or once its first message waited "maxDelay",
+ *	so that subscribers which process data in bulk pay the cost of a dispatch once per batch.
+ *	A handler is registered per message type with "addHandler": it receives the messages of its type of a batch,
+ *	in the order in which they were received.
+ *
+ *	The batches replace the readers and the message handlers of the subscriber, which do not receive the
+ *	messages anymore. They are delivered one after the other by the thread pool of the connection manager.
+ *	While "maxPendingBatches" batches wait to be delivered, the subscriber stops reading: the flow control of
+ *	the stream slows the publisher down instead of queuing the messages in memory.
+ */
+class BatchHandlerGRPC
+{
+public:
+	/**
+	 *	Delivers the messages of "subscriber" in batches. Must be called before the subscriber is started.
+	 *	@param subscriber	a subscriber created by the connection manager with a gRPC configuration.
+	 *	@param maxMessages	number of messages that completes a batch.
+	 *	@param maxDelay	maximum time that the first message of an incomplete batch waits for the next ones.
+	 *	@param maxPendingBatches	number of complete batches that can wait to be delivered.
+	 *	@return the batch handler, or null if the subscriber is not a gRPC subscriber.
+	 */
+	static std::shared_ptr<BatchHandlerGRPC> create(const std::shared_ptr<ghost::Subscriber>& subscriber,
+							size_t maxMessages, const std::chrono::milliseconds& maxDelay,
+							size_t maxPendingBatches = 16);
+
+	virtual ~BatchHandlerGRPC() = default;
+
+	/// Sets the handler of the messages of type "MessageType". It replaces the previous handler of this type.
+	template <typename MessageType>
+	void addHandler(const std::function<void(const std::vector<MessageType>& messages)>& handler);
+
+protected:
+	using AnyHandler = std::function<void(const std::vector<const google::protobuf::Any*>& messages)>;
+
+	/// Sets the handler of the messages whose type has the full name "typeName".
+	virtual void addAnyHandler(const std::string& typeName, const AnyHandler& handler) = 0;
+};
+
+/////////////////////////// Template definition ///////////////////////////
+
+template <typename MessageType>
+void BatchHandlerGRPC::addHandler(const std::function<void(const std::vector<MessageType>& messages)>& handler)
+{
+	addAnyHandler(MessageType::descriptor()->full_name(),
+		      [handler](const std::vector<const google::protobuf::Any*>& messages) {
+			      std::vector<MessageType> typedMessages(messages.size());
+			      size_t count = 0;
+			      for (const auto& message : messages)
+				      if (message->UnpackTo(&typedMessages[count])) count++;
+
+			      typedMessages.resize(count);
+			      if (!typedMessages.empty()) handler(typedMessages);
+		      });
+}
+} // namespace ghost
+
+#endif // GHOST_BATCHHANDLERGRPC_HPP
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_CALLCLIENTGRPC_HPP
+#define GHOST_CALLCLIENTGRPC_HPP
+
+#include <google/protobuf/any.pb.h>
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <ghost/connection/Client.hpp>
+#include <memory>
+
+namespace ghost
+{
+/**
+ *	Request/response calls over the stream of a client.
+ *	Every request is sent with an id that the server (see ghost::CallHandlerGRPC) copies into the response, so
+ *	that many requests can be in flight on one connection: "call" returns without waiting for the response,
+ *	and the responses complete their futures in any order.
+ *
+ *	The client must be connected to a server whose client handler is a ghost::CallHandlerGRPC. The requests are
+ *	written by the client's writer: the writer watermarks of the configuration limit the number of requests that
+ *	are queued while the stream is busy, they should be raised for deep pipelines.
+ *	The calls that are still pending when the stream of a gRPC client is lost or stopped, or when this object is
+ *	destroyed, complete with a null response: their responses cannot be received anymore.
+ */
+class CallClientGRPC
+{
+public:
+	/**
+	 *	Creates a call client that uses the stream of "client".
+	 *	@param client	a client created by the connection manager, it is started by the caller.
+	 *	@return the call client.
+	 */
+	static std::shared_ptr<CallClientGRPC> create(const std::shared_ptr<ghost::Client>& client);
+
+	virtual ~CallClientGRPC() = default;
+
+	/**
+	 *	Sends a request without waiting for its response.
+	 *	@param request	the request.
+	 *	@param timeout	if positive, the call completes with a null response if its response did not arrive
+	 *	within this time. Only the calls of gRPC clients expire.
+	 *	@return a future holding the response, or null if the request could not be sent, if the server had no
+	 *	handler for it, if the response is not of type "Response", if the call expired, or if the connection was
+	 *	lost or this object was destroyed first.
+	 */
+	template <typename Request, typename Response>
+	std::future<std::shared_ptr<Response>> call(
+	    const Request& request, const std::chrono::milliseconds& timeout = std::chrono::milliseconds(0));
+
+	/// @return the number of requests waiting for their response.
+	virtual size_t countPendingCalls() const = 0;
+
+protected:
+	/// Called with the response of a request, or with nullptr if the call failed.
+	using Completion = std::function<void(const google::protobuf::Any* response)>;
+
+	/// Sends a request and calls "completion" once, at the latest after "timeout" if it is positive. If false is
+	/// returned, "completion" is not called.
+	virtual bool sendCall(const google::protobuf::Any& request, const Completion& completion,
+			      const std::chrono::milliseconds& timeout) = 0;
+};
+
+/////////////////////////// Template definition ///////////////////////////
+
+template <typename Request, typename Response>
+std::future<std::shared_ptr<Response>> CallClientGRPC::call(const Request& request,
+							    const std::chrono::milliseconds& timeout)
+{
+	auto promise = std::make_shared<std::promise<std::shared_ptr<Response>>>();
+	auto result = promise->get_future();
+
+	google::protobuf::Any message;
+	message.PackFrom(request);
+	auto completion = [promise](const google::protobuf::Any* response) {
+		auto typedResponse = std::make_shared<Response>();
+		if (!response || !response->UnpackTo(typedResponse.get())) typedResponse.reset();
+		promise->set_value(typedResponse);
+	};
+
+	bool sent = sendCall(message, completion, timeout);
+
+	if (!sent) promise->set_value(nullptr);
+	return result;
+}
+} // namespace ghost
+
+#endif // GHOST_CALLCLIENTGRPC_HPP
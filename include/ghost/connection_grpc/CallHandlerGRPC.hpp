@@ -0,0 +1,79 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_CALLHANDLERGRPC_HPP
+#define GHOST_CALLHANDLERGRPC_HPP
+
+#include <google/protobuf/any.pb.h>
+
+#include <functional>
+#include <ghost/connection_grpc/AsyncClientHandlerGRPC.hpp>
+#include <memory>
+#include <string>
+
+namespace ghost
+{
+/**
+ *	Client handler for gRPC servers which answers the requests of ghost::CallClientGRPC.
+ *	A handler is registered per request type with "addHandler". Each request is answered with the response
+ *	filled by its handler and the id of the request, so that the clients can have many requests in flight.
+ *	A request without handler, or whose handler returned false, is answered without response.
+ *
+ *	The handlers are called from the completion queue threads of the server (see ghost::AsyncClientHandlerGRPC),
+ *	in the order in which the requests of a client are received: they must not block.
+ */
+class CallHandlerGRPC : public ghost::AsyncClientHandlerGRPC
+{
+public:
+	static std::shared_ptr<CallHandlerGRPC> create();
+
+	virtual ~CallHandlerGRPC() = default;
+
+	/**
+	 *	Sets the handler of the requests of type "Request". It replaces the previous handler of this type.
+	 *	@param handler	fills the response and returns true, or returns false if the request failed.
+	 */
+	template <typename Request, typename Response>
+	void addHandler(const std::function<bool(const Request&, Response&)>& handler);
+
+protected:
+	using AnyHandler = std::function<bool(const google::protobuf::Any& request, google::protobuf::Any& response)>;
+
+	/// Sets the handler of the requests whose type has the full name "requestTypeName".
+	virtual void addAnyHandler(const std::string& requestTypeName, const AnyHandler& handler) = 0;
+};
+
+/////////////////////////// Template definition ///////////////////////////
+
+template <typename Request, typename Response>
+void CallHandlerGRPC::addHandler(const std::function<bool(const Request&, Response&)>& handler)
+{
+	addAnyHandler(Request::descriptor()->full_name(),
+		      [handler](const google::protobuf::Any& request, google::protobuf::Any& response) {
+			      Request typedRequest;
+			      if (!request.UnpackTo(&typedRequest)) return false;
+
+			      Response typedResponse;
+			      if (!handler(typedRequest, typedResponse)) return false;
+
+			      response.PackFrom(typedResponse);
+			      return true;
+		      });
+}
+} // namespace ghost
+
+#endif // GHOST_CALLHANDLERGRPC_HPP
@@ -17,7 +17,11 @@
 #ifndef GHOST_CONNECTIONCONFIGURATIONGRPC_HPP
 #define GHOST_CONNECTIONCONFIGURATIONGRPC_HPP
 
+#include <chrono>
 #include <ghost/connection/NetworkConnectionConfiguration.hpp>
+#include <map>
+#include <string>
+#include <vector>
 
 namespace ghost
 {
@@ -29,6 +33,25 @@ namespace ghost
 class ConnectionConfigurationGRPC : public ghost::NetworkConnectionConfiguration
 {
 public:
+	/// Placement of the streams of clients and subscribers on the server endpoints.
+	enum class LoadBalancingPolicy
+	{
+		/// every stream uses the first endpoint that is reachable, and moves to the next one if it fails
+		PICK_FIRST,
+		/// the streams are placed on the endpoints in turn
+		ROUND_ROBIN,
+		/// a stream is placed on the endpoint with the fewest streams of this process
+		LEAST_OUTSTANDING
+	};
+
+	/// Priority classes of the messages written by a connection, from the highest to the lowest.
+	enum class MessagePriority
+	{
+		CONTROL,
+		NORMAL,
+		BULK
+	};
+
 	/**
 	 * @brief Constructs a new NetworkConnectionConfiguration object with
 	 * default parameters, i.e. any IP address and any remote port number.
@@ -37,6 +60,269 @@ public:
 	 */
 	ConnectionConfigurationGRPC(const std::string& name = "");
 	ConnectionConfigurationGRPC(const std::string& ip, int port);
+	/**
+	 * @brief Constructs a gRPC configuration from the attributes of a network configuration.
+	 * The gRPC specific attributes that are not present in "other" keep their default value.
+	 *
+	 * @param other the network configuration to copy
+	 */
+	explicit ConnectionConfigurationGRPC(const ghost::NetworkConnectionConfiguration& other);
+
+	/**
+	 * @brief Creates a gRPC configuration from any connection configuration.
+	 *
+	 * @param other the configuration to copy
+	 * @return the gRPC configuration containing the attributes of "other"
+	 */
+	static ConnectionConfigurationGRPC initializeFrom(const ghost::ConnectionConfiguration& other);
+
+	/**
+	 * @brief Sets the number of messages that can wait to be sent by a connection, per remote peer.
+	 * When this number is reached, the connection stops accepting messages and its writers block (if the
+	 * operations are blocking) until the number of waiting messages drops to the low watermark.
+	 * Non-blocking writers can observe this state with ghost::ConnectionControlGRPC::awaitWritable.
+	 * A publisher also applies the watermarks to the messages that wait to be written to its shards (see
+	 * "setServerShards").
+	 * A high watermark of 0 removes the limit. Default: 1024 messages, 512 for the low watermark.
+	 *
+	 * @param highWatermark the number of waiting messages at which writers are stopped
+	 * @param lowWatermark the number of waiting messages at which writers are released
+	 */
+	void setWriterWatermarks(size_t highWatermark, size_t lowWatermark);
+	size_t getWriterHighWatermark() const;
+	size_t getWriterLowWatermark() const;
+
+	/**
+	 * @brief Same as "setWriterWatermarks" with the total size in bytes of the waiting messages.
+	 * Default: 0 (no limit).
+	 *
+	 * @param highWatermarkBytes the size of the waiting messages at which writers are stopped
+	 * @param lowWatermarkBytes the size of the waiting messages at which writers are released
+	 */
+	void setWriterWatermarksBytes(size_t highWatermarkBytes, size_t lowWatermarkBytes);
+	size_t getWriterHighWatermarkBytes() const;
+	size_t getWriterLowWatermarkBytes() const;
+
+	/**
+	 * @brief Sets how long consecutive messages may be coalesced before they are flushed to the network.
+	 * When several messages wait to be sent, their writes are buffered and flushed together with the last one.
+	 * This delay bounds the time a message can stay buffered. Default: 0 (only bounded by the waiting messages).
+	 *
+	 * @param delay the maximum coalescing delay
+	 */
+	void setWriterMaxCoalescingDelay(const std::chrono::microseconds& delay);
+	std::chrono::microseconds getWriterMaxCoalescingDelay() const;
+
+	/**
+	 * @brief Enables the automatic reconnection of clients and subscribers.
+	 * When an established connection is lost, the client connects again with an exponential backoff
+	 * instead of stopping. The messages waiting to be sent are kept and sent once the connection is back.
+	 * The first connection attempt ("start") is not retried. Default: false.
+	 *
+	 * @param enabled true to reconnect lost connections
+	 */
+	void setReconnectEnabled(bool enabled);
+	bool isReconnectEnabled() const;
+
+	/**
+	 * @brief Sets the delays between two reconnection attempts.
+	 * The delay starts at "initialBackoff" and doubles after every failed attempt, up to "maxBackoff".
+	 * Every delay is randomized between its half and its full value to spread the reconnections of many
+	 * clients. Default: 50 ms and 5 s.
+	 *
+	 * @param initialBackoff delay before the first reconnection attempt
+	 * @param maxBackoff upper bound of the delay
+	 */
+	void setReconnectBackoff(const std::chrono::milliseconds& initialBackoff,
+				 const std::chrono::milliseconds& maxBackoff);
+	std::chrono::milliseconds getReconnectInitialBackoff() const;
+	std::chrono::milliseconds getReconnectMaxBackoff() const;
+
+	/**
+	 * @brief Sets the interval of the HTTP/2 keepalive pings and how long to wait for their acknowledgement
+	 * before the connection is considered lost. Servers accept the pings of clients configured with the same
+	 * interval. Default: 0 (gRPC default: no keepalive for clients, 2 hours for servers, 20 s timeout).
+	 *
+	 * @param time interval between two keepalive pings
+	 * @param timeout maximum time to wait for the acknowledgement of a ping
+	 */
+	void setKeepalive(const std::chrono::milliseconds& time, const std::chrono::milliseconds& timeout);
+	std::chrono::milliseconds getKeepaliveTime() const;
+	std::chrono::milliseconds getKeepaliveTimeout() const;
+
+	/**
+	 * @brief Sets the maximum size in bytes of the messages that can be sent and received.
+	 * Values that do not fit in an int remove the limit.
+	 * Default: 0 (gRPC default: unlimited to send, 4 MB to receive).
+	 *
+	 * @param maxSendSize maximum size of an outgoing message
+	 * @param maxReceiveSize maximum size of an incoming message
+	 */
+	void setMaxMessageSize(size_t maxSendSize, size_t maxReceiveSize);
+	size_t getMaxSendMessageSize() const;
+	size_t getMaxReceiveMessageSize() const;
+
+	/**
+	 * @brief Sets the initial HTTP/2 flow control window of the streams, in bytes.
+	 * A larger window allows more data in flight on high bandwidth or high latency links.
+	 * Default: 0 (gRPC default).
+	 *
+	 * @param size the initial window size
+	 */
+	void setHTTP2InitialWindowSize(size_t size);
+	size_t getHTTP2InitialWindowSize() const;
+
+	/**
+	 * @brief Enables the bandwidth-delay product probing, with which gRPC grows the flow control window
+	 * according to the measured link. Default: true (gRPC default, the channels are only configured when it is
+	 * disabled).
+	 *
+	 * @param enabled false to keep the window at its initial size
+	 */
+	void setHTTP2BDPProbeEnabled(bool enabled);
+	bool isHTTP2BDPProbeEnabled() const;
+
+	/**
+	 * @brief Sets the maximum number of concurrent streams per HTTP/2 connection accepted by servers and
+	 * publishers. Default: 0 (gRPC default: unlimited).
+	 *
+	 * @param count the maximum number of concurrent streams
+	 */
+	void setMaxConcurrentStreams(size_t count);
+	size_t getMaxConcurrentStreams() const;
+
+	/**
+	 * @brief Sets the size of the HTTP/2 write buffer of the transport, in bytes. Default: 0 (gRPC default).
+	 *
+	 * @param size the write buffer size
+	 */
+	void setWriteBufferSize(size_t size);
+	size_t getWriteBufferSize() const;
+
+	/**
+	 * @brief Sets the bounds of the pool of connection requests that servers and publishers keep posted.
+	 * The pool grows when connections are accepted faster than the requests are replaced, so that bursts of
+	 * connections (for instance subscribers reconnecting to a restarted publisher) do not wait for each other,
+	 * and shrinks back to the minimum when no connection is accepted.
+	 * Default: 0 (the thread pool size) and 1024.
+	 *
+	 * @param minSize number of requests that are always posted, 0 for the thread pool size
+	 * @param maxSize upper bound of the number of posted requests
+	 */
+	void setAcceptPoolSize(size_t minSize, size_t maxSize);
+	size_t getAcceptPoolMinSize() const;
+	size_t getAcceptPoolMaxSize() const;
+
+	/**
+	 * @brief Sets the number of shards of servers and publishers. Each shard has its own completion queue,
+	 * and the connections are spread over the shards. A publisher additionally splits its subscribers across
+	 * the shards, and every shard has a worker that writes the messages to its subscribers, so that the fanout
+	 * uses several cores.
+	 * Default: 1.
+	 *
+	 * @param count the number of shards, 0 is treated as 1
+	 */
+	void setServerShards(size_t count);
+	size_t getServerShards() const;
+
+	/**
+	 * @brief Lets a publisher drop the messages of the subscribers that cannot keep up with it, instead of
+	 * waiting for them. A subscriber whose writer queue stays full during this timeout misses the messages until
+	 * its queue reaches its low watermark again, see ghost::ConnectionControlGRPC::countDroppedMessages.
+	 * Default: 0 (the publisher waits for its slowest subscriber).
+	 *
+	 * @param timeout the time during which a full subscriber is waited for, 0 to always wait
+	 */
+	void setLaggingSubscriberTimeout(const std::chrono::milliseconds& timeout);
+	std::chrono::milliseconds getLaggingSubscriberTimeout() const;
+
+	/**
+	 * @brief Sets the endpoints of a replicated service, as "host:port" strings, for clients and subscribers.
+	 * Every stream is placed on one of the endpoints according to the load balancing policy, and moves to
+	 * another endpoint if its endpoint cannot be reached. When no endpoint is set, the server IP address and
+	 * port number are used: a DNS name with several records is then balanced by gRPC, according to the policy.
+	 * Servers and publishers ignore this setting. Default: empty.
+	 *
+	 * @param endpoints the endpoints of the service
+	 */
+	void setServerEndpoints(const std::vector<std::string>& endpoints);
+	std::vector<std::string> getServerEndpoints() const;
+
+	/**
+	 * @brief Sets how the streams of clients and subscribers are placed on the server endpoints (see
+	 * "setServerEndpoints"). Default: PICK_FIRST.
+	 *
+	 * @param policy the load balancing policy
+	 */
+	void setLoadBalancingPolicy(LoadBalancingPolicy policy);
+	LoadBalancingPolicy getLoadBalancingPolicy() const;
+
+	/**
+	 * @brief Declares the message type of a single-type stream, for instance "google.protobuf.DoubleValue"
+	 * (the full name of the protobuf type).
+	 * The messages of this type are sent without their type URL, which the receiving side restores: for small
+	 * messages, the type URL is often larger than the message itself. Messages of other types can still be
+	 * sent on the stream, they keep their type URL.
+	 * Both sides of the connection must declare the same type. Default: empty (no declared type).
+	 *
+	 * @param typeName the full name of the protobuf message type, or an empty string
+	 */
+	void setStreamMessageType(const std::string& typeName);
+	std::string getStreamMessageType() const;
+
+	/**
+	 * @brief Sets the priority class of the messages of a type, for instance "google.protobuf.DoubleValue" (the
+	 * full name of the protobuf type). The connections always write the next message of the highest class that
+	 * has messages waiting, and CONTROL messages are taken from the writer even when the writer watermarks are
+	 * reached, so that they overtake the data already queued on the connection.
+	 * Default: NORMAL for all types.
+	 *
+	 * @param typeName the full name of the protobuf message type
+	 * @param priority the priority class of the messages of this type
+	 */
+	void setMessagePriority(const std::string& typeName, MessagePriority priority);
+	MessagePriority getMessagePriority(const std::string& typeName) const;
+	/// @return the types whose priority class was set, with their class.
+	std::map<std::string, MessagePriority> getMessagePriorities() const;
+
+	/**
+	 * @brief Protects the lower priority classes from starvation: after this number of consecutive messages of
+	 * higher classes, a waiting message of a lower class is written. Default: 16.
+	 *
+	 * @param count the number of messages, 0 for a strict priority order
+	 */
+	void setPriorityStarvationLimit(size_t count);
+	size_t getPriorityStarvationLimit() const;
+
+	/**
+	 * @brief Sets how long the messages of a type stay useful once they are queued on a connection, for
+	 * instance "google.protobuf.DoubleValue" (the full name of the protobuf type). A message that waited longer
+	 * than this time is dropped instead of being written, so that a backlog built during a network stall does
+	 * not delay fresher data. Default: no time to live.
+	 *
+	 * @param typeName the full name of the protobuf message type
+	 * @param timeToLive the time to live of the messages of this type, 0 to keep them until they are written
+	 */
+	void setMessageTimeToLive(const std::string& typeName, const std::chrono::milliseconds& timeToLive);
+	std::chrono::milliseconds getMessageTimeToLive(const std::string& typeName) const;
+	/// @return the types whose time to live was set, with their time to live.
+	std::map<std::string, std::chrono::milliseconds> getMessageTimesToLive() const;
+
+	/**
+	 * @brief Stamps the written messages with sequence numbers, and checks the numbers of the received messages.
+	 * Each connection numbers the messages it writes, and a publisher numbers the messages it publishes (a
+	 * subscriber that reconnects sees the messages it missed as a gap). The readers count the gaps, the
+	 * duplicates and the messages received out of order. Both sides of a connection must enable it.
+	 * Default: false.
+	 *
+	 * @param enabled true to stamp and check the sequence numbers
+	 */
+	void setSequenceNumbersEnabled(bool enabled);
+	bool isSequenceNumbersEnabled() const;
+
+private:
+	void addAttributes();
+	size_t getSizeAttribute(const std::string& name, size_t defaultValue) const;
 };
 } // namespace ghost
 
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_CONNECTIONCONTROLGRPC_HPP
+#define GHOST_CONNECTIONCONTROLGRPC_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <ghost/connection/Connection.hpp>
+#include <memory>
+
+namespace ghost
+{
+/**
+ *	Gives access to the features of the gRPC connections created by the connection manager that the generic
+ *	ghost::Connection interface does not expose: asynchronous connection, flow control and metrics.
+ */
+class ConnectionControlGRPC
+{
+public:
+	enum class WriterStatus
+	{
+		/// The connection accepts new messages.
+		WRITABLE,
+		/// The connection is full and no timeout was given.
+		WOULD_BLOCK,
+		/// The connection stayed full during the whole timeout.
+		TIMEOUT
+	};
+
+	/// Metrics of the automatic reconnection, see ghost::ConnectionConfigurationGRPC::setReconnectEnabled.
+	struct ReconnectStatistics
+	{
+		/// number of successful reconnections
+		size_t reconnections = 0;
+		/// number of connection attempts that failed during the outages
+		size_t failedAttempts = 0;
+		/// true while the connection is lost and being reestablished
+		bool reconnecting = false;
+		/// duration of the last outage, from the loss of the connection until it was reestablished
+		std::chrono::microseconds lastOutage = std::chrono::microseconds::zero();
+		/// longest outage
+		std::chrono::microseconds maxOutage = std::chrono::microseconds::zero();
+		/// cumulated duration of all the outages
+		std::chrono::microseconds totalOutage = std::chrono::microseconds::zero();
+	};
+
+	/// Metrics of the received sequence numbers, see ghost::ConnectionConfigurationGRPC::setSequenceNumbersEnabled.
+	struct SequenceStatistics
+	{
+		/// number of messages received with a sequence number
+		uint64_t received = 0;
+		/// number of messages that were skipped by the received sequence numbers
+		uint64_t gaps = 0;
+		/// number of messages received twice in a row
+		uint64_t duplicates = 0;
+		/// number of messages received after a message with a higher number
+		uint64_t outOfOrder = 0;
+		/// number of times the writer started numbering again from 1
+		uint64_t restarts = 0;
+	};
+
+	/**
+	 *	Metrics of the pool of connection requests posted by a server or a publisher, see
+	 *	ghost::ConnectionConfigurationGRPC::setAcceptPoolSize.
+	 *	gRPC cannot cancel a posted request: when the pool shrinks, the requests above the target are retired
+	 *	as they are consumed by new connections, instead of being replaced.
+	 */
+	struct AcceptStatistics
+	{
+		/// number of connections accepted since the server started
+		size_t accepted = 0;
+		/// number of connection requests currently posted or about to be posted
+		size_t outstanding = 0;
+		/// size that the pool currently aims at
+		size_t target = 0;
+		/// number of consumed requests that were not replaced because the pool was above its target
+		size_t retired = 0;
+		/// number of times the last posted request was consumed
+		size_t starvations = 0;
+		/// cumulated time during which no request was posted. Connections arriving during that time wait in the
+		/// accept queue of gRPC, this is therefore an upper bound of the accept queue wait.
+		std::chrono::microseconds starvedTime = std::chrono::microseconds::zero();
+	};
+
+	/**
+	 *	@param connection	a connection created by the connection manager with a gRPC configuration, or a
+	 *	client given to a client handler by a gRPC server.
+	 *	@return the control of "connection", or null if it is not a gRPC connection.
+	 */
+	static std::shared_ptr<ConnectionControlGRPC> create(const std::shared_ptr<ghost::Connection>& connection);
+
+	virtual ~ConnectionControlGRPC() = default;
+
+	/**
+	 *	Starts the connection without blocking, which allows many clients or subscribers to be connected
+	 *	concurrently. "start" is the blocking variant. Other connections are started by this call.
+	 *	@param callback	if provided, called with the result from a thread of the thread pool once the
+	 *	connection is started (or could not be), before the returned future is ready.
+	 *	@return the result of the start, true if the connection is running.
+	 */
+	virtual std::shared_future<bool> startAsync(const std::function<void(bool)>& callback = {}) = 0;
+
+	/**
+	 *	Blocks until the connection accepts new messages, or until the timeout expires. A connection stops
+	 *	accepting messages when its writer watermarks are reached, see
+	 *	ghost::ConnectionConfigurationGRPC::setWriterWatermarks. A publisher accepts messages when its internal
+	 *	queues do, which wait for the subscribers unless a lagging subscriber timeout is configured (see
+	 *	ghost::ConnectionConfigurationGRPC::setLaggingSubscriberTimeout). Connections that do not write messages
+	 *	are always writable.
+	 *	@param timeout	maximum waiting time. With a timeout of 0, WOULD_BLOCK is returned right away if the
+	 *	connection is full.
+	 */
+	virtual WriterStatus awaitWritable(const std::chrono::milliseconds& timeout) = 0;
+
+	/// @return the metrics of the reconnections of a client or a subscriber, empty for the other connections.
+	virtual ReconnectStatistics getReconnectStatistics() const = 0;
+	/// @return the number of messages that expired before they were sent, see
+	/// ghost::ConnectionConfigurationGRPC::setMessageTimeToLive. For a publisher, the messages that expired in
+	/// the queues of its current subscribers.
+	virtual size_t countExpiredMessages() const = 0;
+	/// @return the number of messages that a publisher dropped for subscribers that could not keep up with it,
+	/// see ghost::ConnectionConfigurationGRPC::setLaggingSubscriberTimeout. 0 for the other connections.
+	virtual size_t countDroppedMessages() const = 0;
+	/// @return the metrics of the sequence numbers received by a connection, empty for a publisher or a server.
+	virtual SequenceStatistics getSequenceStatistics() const = 0;
+	/// @return the metrics of the connection requests of a server or a publisher, empty for the other connections.
+	virtual AcceptStatistics getAcceptStatistics() const = 0;
+};
+} // namespace ghost
+
+#endif // GHOST_CONNECTIONCONTROLGRPC_HPP
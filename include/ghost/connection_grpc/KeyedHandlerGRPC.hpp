@@ -0,0 +1,98 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GHOST_KEYEDHANDLERGRPC_HPP
+#define GHOST_KEYEDHANDLERGRPC_HPP
+
+#include <google/protobuf/any.pb.h>
+
+#include <functional>
+#include <ghost/connection/Subscriber.hpp>
+#include <memory>
+#include <string>
+
+namespace ghost
+{
+/**
+ *	Dispatches the messages received by a gRPC subscriber to the thread pool of the connection manager, so that
+ *	handlers which do CPU-heavy work run concurrently instead of one after the other.
+ *	Every message has a key, computed from its content by a function registered with its handler. The keys are
+ *	hashed to one of "lanes" lanes: the messages of a lane are handled one at a time and in the order in which
+ *	they were received, while the lanes are handled concurrently. Messages with the same key, for instance the
+ *	updates of the same entity, are therefore never reordered.
+ *
+ *	The lanes replace the readers and the message handlers of the subscriber, which do not receive the
+ *	messages anymore. Messages without a handler are ignored.
+ *	While a lane holds "maxPendingMessages" messages, the subscriber stops reading: the flow control of the stream
+ *	slows the publisher down instead of queuing the messages in memory.
+ */
+class KeyedHandlerGRPC
+{
+public:
+	/**
+	 *	Dispatches the messages of "subscriber" to "lanes" lanes. Must be called before the subscriber is
+	 *	started.
+	 *	@param subscriber	a subscriber created by the connection manager with a gRPC configuration.
+	 *	@param lanes	maximum number of messages handled concurrently, typically the number of threads of
+	 *	the thread pool.
+	 *	@param maxPendingMessages	number of messages that can wait to be handled in a lane.
+	 *	@return the keyed handler, or null if the subscriber is not a gRPC subscriber.
+	 */
+	static std::shared_ptr<KeyedHandlerGRPC> create(const std::shared_ptr<ghost::Subscriber>& subscriber,
+							size_t lanes, size_t maxPendingMessages = 1024);
+
+	virtual ~KeyedHandlerGRPC() = default;
+
+	/**
+	 *	Sets the handler of the messages of type "MessageType". It replaces the previous handler of this type.
+	 *	@param handler	called from the thread pool with each message.
+	 *	@param getKey	returns the key of a message, called from the thread that received it. "KeyType"
+	 *	must be hashable with std::hash.
+	 */
+	template <typename MessageType, typename KeyType>
+	void addHandler(const std::function<void(const MessageType& message)>& handler,
+			const std::function<KeyType(const MessageType& message)>& getKey);
+
+protected:
+	/// Unpacks "message" and returns the hash of its key and the task that handles it; false if it cannot be
+	/// unpacked.
+	using AnyHandler = std::function<bool(const google::protobuf::Any& message, size_t& keyHash,
+					      std::function<void()>& task)>;
+
+	/// Sets the handler of the messages whose type has the full name "typeName".
+	virtual void addAnyHandler(const std::string& typeName, const AnyHandler& handler) = 0;
+};
+
+/////////////////////////// Template definition ///////////////////////////
+
+template <typename MessageType, typename KeyType>
+void KeyedHandlerGRPC::addHandler(const std::function<void(const MessageType& message)>& handler,
+				  const std::function<KeyType(const MessageType& message)>& getKey)
+{
+	addAnyHandler(MessageType::descriptor()->full_name(),
+		      [handler, getKey](const google::protobuf::Any& message, size_t& keyHash,
+					std::function<void()>& task) {
+			      auto typedMessage = std::make_shared<MessageType>();
+			      if (!message.UnpackTo(typedMessage.get())) return false;
+
+			      keyHash = std::hash<KeyType>()(getKey(*typedMessage));
+			      task = [handler, typedMessage] { handler(*typedMessage); };
+			      return true;
+		      });
+}
+} // namespace ghost
+
+#endif // GHOST_KEYEDHANDLERGRPC_HPP
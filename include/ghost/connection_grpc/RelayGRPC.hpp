@@ -0,0 +1,72 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_RELAYGRPC_HPP
+#define GHOST_RELAYGRPC_HPP
+
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
+#include <ghost/module/ThreadPool.hpp>
+#include <memory>
+
+namespace ghost
+{
+/**
+ *	Forwards the messages of a gRPC publisher to its own subscribers.
+ *	The relay subscribes once to the upstream publisher, and republishes every received message
+ *	downstream without decoding it: the received bytes are shared by the writer queues of all
+ *	the downstream subscribers.
+ *
+ *	The upstream of a relay can be a publisher or another relay, which allows building fanout trees
+ *	that spread the distribution cost across processes and hosts. The subscribers of a relay are
+ *	regular gRPC subscribers.
+ *
+ *	Since the messages are forwarded as they were received, the upstream and the downstream
+ *	configurations must declare the same stream message type
+ *	(see ghost::ConnectionConfigurationGRPC::setStreamMessageType), if any.
+ *
+ *	The priorities and the times to live of the downstream configuration apply to the forwarded messages. The
+ *	messages waiting to be forwarded are bounded by the writer watermarks of the downstream configuration: while
+ *	the downstream subscribers cannot keep up, the relay stops reading from its upstream, which slows it down.
+ */
+class RelayGRPC
+{
+public:
+	/**
+	 *	Creates a relay.
+	 *	@param upstream	configuration of the subscription: address of the upstream publisher or relay.
+	 *	@param downstream	configuration of the publisher of this relay: address to listen to.
+	 *	@param threadPool	the thread pool used by the connections of the relay.
+	 *	@return the relay, which is not started yet.
+	 */
+	static std::shared_ptr<RelayGRPC> create(const ghost::ConnectionConfigurationGRPC& upstream,
+						 const ghost::ConnectionConfigurationGRPC& downstream,
+						 const std::shared_ptr<ghost::ThreadPool>& threadPool);
+
+	virtual ~RelayGRPC() = default;
+
+	/// Starts listening for subscribers, then subscribes to the upstream publisher.
+	/// @return false if one of the two could not be started.
+	virtual bool start() = 0;
+	/// Unsubscribes from the upstream publisher and stops the downstream subscribers.
+	virtual bool stop() = 0;
+	virtual bool isRunning() const = 0;
+	/// @return the number of subscribers currently connected to this relay.
+	virtual size_t countSubscribers() const = 0;
+};
+} // namespace ghost
+
+#endif // GHOST_RELAYGRPC_HPP
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BatchHandlerGRPC.hpp"
+
+#include "BatchReaderSink.hpp"
+#include "SubscriberGRPC.hpp"
+
+using namespace ghost::internal;
+
+std::shared_ptr<ghost::BatchHandlerGRPC> ghost::BatchHandlerGRPC::create(
+    const std::shared_ptr<ghost::Subscriber>& subscriber, size_t maxMessages, const std::chrono::milliseconds& maxDelay,
+    size_t maxPendingBatches)
+{
+	auto subscriberGRPC = std::dynamic_pointer_cast<ghost::internal::SubscriberGRPC>(subscriber);
+	if (!subscriberGRPC) return nullptr;
+
+	auto batchHandler = std::make_shared<ghost::internal::BatchHandlerGRPC>();
+
+	// the sink stays in the subscriber, which may outlive the batch handler
+	std::weak_ptr<ghost::internal::BatchHandlerGRPC> weakBatchHandler = batchHandler;
+	subscriberGRPC->setManagedReaderSink(std::make_shared<BatchReaderSink>(
+	    subscriberGRPC->getThreadPool(), maxMessages, maxDelay, maxPendingBatches,
+	    [weakBatchHandler](const std::vector<google::protobuf::Any>& messages) {
+		    auto batchHandler = weakBatchHandler.lock();
+		    if (batchHandler) batchHandler->onBatch(messages);
+	    }));
+
+	return batchHandler;
+}
+
+void BatchHandlerGRPC::onBatch(const std::vector<google::protobuf::Any>& messages)
+{
+	// the messages of a type keep their order, batches usually hold a single type
+	std::map<std::string, std::vector<const google::protobuf::Any*>> groups;
+	for (const auto& message : messages)
+	{
+		// the full name of the type follows the last '/' of the URL
+		const std::string& typeUrl = message.type_url();
+		groups[typeUrl.substr(typeUrl.find_last_of('/') + 1)].push_back(&message);
+	}
+
+	for (const auto& group : groups)
+	{
+		AnyHandler handler;
+		{
+			std::lock_guard<std::mutex> lock(_handlersMutex);
+			auto it = _handlers.find(group.first);
+			if (it == _handlers.end()) continue;
+
+			handler = it->second;
+		}
+		handler(group.second);
+	}
+}
+
+void BatchHandlerGRPC::addAnyHandler(const std::string& typeName, const AnyHandler& handler)
+{
+	std::lock_guard<std::mutex> lock(_handlersMutex);
+	_handlers[typeName] = handler;
+}
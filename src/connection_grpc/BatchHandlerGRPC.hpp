@@ -0,0 +1,49 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GHOST_INTERNAL_NETWORK_BATCHHANDLERGRPC_HPP
+#define GHOST_INTERNAL_NETWORK_BATCHHANDLERGRPC_HPP
+
+#include <ghost/connection_grpc/BatchHandlerGRPC.hpp>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Implementation of ghost::BatchHandlerGRPC. The messages of a batch are grouped by type, and each group is
+ *	passed to the handler of its type; the messages without handler are ignored.
+ */
+class BatchHandlerGRPC : public ghost::BatchHandlerGRPC
+{
+public:
+	void onBatch(const std::vector<google::protobuf::Any>& messages);
+
+protected:
+	void addAnyHandler(const std::string& typeName, const AnyHandler& handler) override;
+
+private:
+	mutable std::mutex _handlersMutex;
+	std::map<std::string, AnyHandler> _handlers;
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_BATCHHANDLERGRPC_HPP
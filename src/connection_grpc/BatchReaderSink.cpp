@@ -0,0 +1,186 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BatchReaderSink.hpp"
+
+#include <algorithm>
+
+using namespace ghost::internal;
+
+const std::chrono::milliseconds BatchReaderSink::TIMER_PERIOD = std::chrono::milliseconds(100);
+
+BatchReaderSink::BatchReaderSink(const std::shared_ptr<ghost::ThreadPool>& threadPool, size_t maxMessages,
+				 const std::chrono::milliseconds& maxDelay, size_t maxClosedBatches,
+				 const Handler& handler)
+    : _threadPool(threadPool)
+    , _maxMessages(std::max<size_t>(maxMessages, 1))
+    , _maxDelay(maxDelay)
+    , _maxClosedBatches(std::max<size_t>(maxClosedBatches, 1))
+    , _handler(handler)
+    , _batchNumber(0)
+    , _delivering(false)
+    , _stopping(false)
+{
+}
+
+BatchReaderSink::~BatchReaderSink()
+{
+	stopTimer();
+}
+
+bool BatchReaderSink::put(const google::protobuf::Any& message)
+{
+	bool startDeliveryTask = false;
+	{
+		// the reads of the stream wait for the handler
+		std::unique_lock<std::mutex> lock(_mutex);
+		_condition.wait(lock, [this] { return _closedBatches.size() < _maxClosedBatches; });
+
+		if (_batch.empty())
+		{
+			_batch.reserve(_maxMessages);
+			_batchStart = std::chrono::steady_clock::now();
+			_condition.notify_all(); // arms the timer
+		}
+		_batch.push_back(message);
+
+		if (_batch.size() >= _maxMessages) startDeliveryTask = closeBatch();
+	}
+
+	if (startDeliveryTask) startDelivery();
+	return true;
+}
+
+void BatchReaderSink::drain()
+{
+	bool startDeliveryTask = false;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		startDeliveryTask = closeBatch();
+	}
+
+	if (startDeliveryTask) startDelivery();
+}
+
+void BatchReaderSink::start()
+{
+	if (_executor) return;
+
+	_weakSelf = shared_from_this();
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = false;
+	}
+
+	_executor = _threadPool->makeScheduledExecutor();
+	_executor->scheduleAtFixedRate(std::bind(&BatchReaderSink::closeExpiredBatches, this), TIMER_PERIOD);
+}
+
+void BatchReaderSink::stop()
+{
+	stopTimer();
+	drain();
+
+	// the last delivery task may have been started by the completion queue: wait until nothing is left
+	std::unique_lock<std::mutex> lock(_mutex);
+	_condition.wait(lock, [this] { return !_delivering; });
+}
+
+bool BatchReaderSink::closeBatch()
+{
+	if (_batch.empty()) return false;
+
+	_closedBatches.push_back(std::move(_batch));
+	_batch.clear();
+	_batchNumber++;
+
+	if (_delivering) return false; // the running task delivers it
+	_delivering = true;
+	return true;
+}
+
+void BatchReaderSink::closeExpiredBatches()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (!_stopping)
+	{
+		if (_batch.empty())
+		{
+			_condition.wait(lock, [this] { return _stopping || !_batch.empty(); });
+			continue;
+		}
+
+		// the batch may be closed by "put" before its deadline
+		uint64_t batchNumber = _batchNumber;
+		bool closed = _condition.wait_until(lock, _batchStart + _maxDelay, [this, batchNumber] {
+			return _stopping || _batchNumber != batchNumber;
+		});
+		if (closed) continue;
+
+		bool startDeliveryTask = closeBatch();
+		lock.unlock();
+		if (startDeliveryTask) startDelivery();
+		lock.lock();
+	}
+}
+
+void BatchReaderSink::stopTimer()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_condition.notify_all();
+
+	if (_executor) _executor->stop();
+	_executor.reset();
+}
+
+void BatchReaderSink::startDelivery()
+{
+	// the sink keeps the future of the task, which must not keep the sink alive
+	std::weak_ptr<BatchReaderSink> weakSelf = _weakSelf;
+	auto delivery = _threadPool->execute([weakSelf] {
+		auto self = weakSelf.lock();
+		if (self) self->deliver();
+	});
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_delivery = std::move(delivery);
+}
+
+void BatchReaderSink::deliver()
+{
+	while (true)
+	{
+		std::vector<google::protobuf::Any> batch;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_closedBatches.empty())
+			{
+				_delivering = false;
+				_condition.notify_all();
+				return;
+			}
+
+			batch = std::move(_closedBatches.front());
+			_closedBatches.pop_front();
+		}
+		_condition.notify_all(); // a waiting "put" can continue
+
+		_handler(batch);
+	}
+}
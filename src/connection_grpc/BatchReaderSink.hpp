@@ -0,0 +1,102 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GHOST_INTERNAL_NETWORK_BATCHREADERSINK_HPP
+#define GHOST_INTERNAL_NETWORK_BATCHREADERSINK_HPP
+
+#include <google/protobuf/any.pb.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <ghost/module/ThreadPool.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ManagedReaderSink.hpp"
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Replaces the reader sink of a subscriber to deliver the received messages in batches (see
+ *	ghost::BatchHandlerGRPC).
+ *	The messages are appended to the current batch from the completion queue thread that read them. A batch is
+ *	closed when it is full, or by a timer task when its first message is older than the maximum delay: the task
+ *	waits for the deadline of the open batch, and for a batch to open otherwise. The closed batches are delivered
+ *	in order by a single task of the thread pool.
+ *	"put" blocks the completion queue thread while the closed batches reach their maximum number, so that the
+ *	stream is not read until the handler caught up.
+ */
+class BatchReaderSink : public ManagedReaderSink, public std::enable_shared_from_this<BatchReaderSink>
+{
+public:
+	using Handler = std::function<void(const std::vector<google::protobuf::Any>& messages)>;
+
+	BatchReaderSink(const std::shared_ptr<ghost::ThreadPool>& threadPool, size_t maxMessages,
+			const std::chrono::milliseconds& maxDelay, size_t maxClosedBatches, const Handler& handler);
+	~BatchReaderSink();
+
+	bool put(const google::protobuf::Any& message) override;
+	/// Delivers the incomplete batch, the connection was lost.
+	void drain() override;
+
+	/// Starts the timer task that closes the batches that waited for the maximum delay. Must be called before
+	/// the first message is put.
+	void start() override;
+	/// Stops the timer task, and waits until the pending messages are delivered.
+	void stop() override;
+
+private:
+	/// Rate of the timer task, which only returns when the sink is stopped.
+	static const std::chrono::milliseconds TIMER_PERIOD;
+
+	/// Moves the current batch to the closed batches, "_mutex" is locked by the caller.
+	/// @return true if a delivery task must be started.
+	bool closeBatch();
+	/// Task of the timer: closes the open batch at its deadline, until the sink is stopped.
+	void closeExpiredBatches();
+	void stopTimer();
+	void startDelivery();
+	void deliver();
+
+	std::shared_ptr<ghost::ThreadPool> _threadPool;
+	const size_t _maxMessages;
+	const std::chrono::milliseconds _maxDelay;
+	const size_t _maxClosedBatches;
+	Handler _handler;
+	std::shared_ptr<ghost::ScheduledExecutor> _executor;
+	std::weak_ptr<BatchReaderSink> _weakSelf; // set by "start", the tasks must not keep the sink alive
+
+	std::mutex _mutex;
+	std::condition_variable _condition; // a batch opened or was delivered, the delivery ended, or the timer stops
+	std::vector<google::protobuf::Any> _batch;
+	std::chrono::steady_clock::time_point _batchStart; // reception of the first message of "_batch"
+	uint64_t _batchNumber;                              // incremented when a batch is closed
+	std::deque<std::vector<google::protobuf::Any>> _closedBatches;
+	bool _delivering; // true while a delivery task is running
+	bool _stopping;   // the timer task returns
+	std::future<void> _delivery;
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_BATCHREADERSINK_HPP
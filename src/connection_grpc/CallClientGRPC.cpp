@@ -0,0 +1,189 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "CallClientGRPC.hpp"
+
+#include <ghost/connection/MessageHandler.hpp>
+#include <utility>
+#include <vector>
+
+#include "ClientGRPC.hpp"
+
+using namespace ghost::internal;
+
+const std::chrono::milliseconds CallClientGRPC::EXPIRY_PERIOD = std::chrono::milliseconds(100);
+
+std::shared_ptr<ghost::CallClientGRPC> ghost::CallClientGRPC::create(const std::shared_ptr<ghost::Client>& client)
+{
+	// the calls of a gRPC client fail with its stream, and expire with the tasks of its thread pool
+	auto grpcClient = std::dynamic_pointer_cast<ghost::internal::ClientGRPC>(client);
+	auto callClient = std::make_shared<ghost::internal::CallClientGRPC>(
+	    client, grpcClient ? grpcClient->getThreadPool() : nullptr);
+
+	// the handler stays registered in the client, which may outlive the call client
+	std::weak_ptr<ghost::internal::CallClientGRPC> weakCallClient = callClient;
+	client->addMessageHandler()->addHandler<ghost::protobuf::connectiongrpc::CallMessage>(
+	    [weakCallClient](const ghost::protobuf::connectiongrpc::CallMessage& response) {
+		    auto callClient = weakCallClient.lock();
+		    if (callClient) callClient->onResponse(response);
+	    });
+
+	if (grpcClient)
+	{
+		grpcClient->addDisconnectedCallback([weakCallClient] {
+			auto callClient = weakCallClient.lock();
+			if (callClient) callClient->failCalls();
+		});
+	}
+
+	return callClient;
+}
+
+CallClientGRPC::CallClientGRPC(const std::shared_ptr<ghost::Client>& client,
+			       const std::shared_ptr<ghost::ThreadPool>& threadPool)
+    : _client(client)
+    , _threadPool(threadPool)
+    , _writer(client->getWriter<ghost::protobuf::connectiongrpc::CallMessage>())
+    , _nextId(0)
+    , _stopping(false)
+{
+}
+
+CallClientGRPC::~CallClientGRPC()
+{
+	{
+		std::lock_guard<std::mutex> lock(_callsMutex);
+		_stopping = true;
+	}
+	_callsCondition.notify_all();
+	if (_executor) _executor->stop();
+
+	failCalls();
+}
+
+size_t CallClientGRPC::countPendingCalls() const
+{
+	std::lock_guard<std::mutex> lock(_callsMutex);
+	return _calls.size();
+}
+
+void CallClientGRPC::onResponse(const ghost::protobuf::connectiongrpc::CallMessage& response)
+{
+	Completion completion;
+	{
+		std::lock_guard<std::mutex> lock(_callsMutex);
+		auto it = _calls.find(response.id());
+		if (it == _calls.end()) return;
+
+		completion = std::move(it->second.completion);
+		_deadlines.erase(std::make_pair(it->second.deadline, it->first));
+		_calls.erase(it);
+	}
+
+	completion(response.has_payload() ? &response.payload() : nullptr);
+}
+
+void CallClientGRPC::failCalls()
+{
+	std::unordered_map<uint64_t, Call> calls;
+	{
+		std::lock_guard<std::mutex> lock(_callsMutex);
+		calls.swap(_calls);
+		_deadlines.clear();
+	}
+
+	for (auto& call : calls) call.second.completion(nullptr);
+}
+
+bool CallClientGRPC::sendCall(const google::protobuf::Any& request, const Completion& completion,
+			      const std::chrono::milliseconds& timeout)
+{
+	ghost::protobuf::connectiongrpc::CallMessage message;
+	message.set_id(_nextId++);
+	*message.mutable_payload() = request;
+
+	Call call;
+	call.completion = completion;
+	call.deadline = Deadline::max();
+	bool expires = timeout.count() > 0 && _threadPool;
+
+	// registered before it is written, the response can arrive right away
+	{
+		std::lock_guard<std::mutex> lock(_callsMutex);
+		if (expires)
+		{
+			call.deadline = std::chrono::steady_clock::now() + timeout;
+			_deadlines.emplace(call.deadline, message.id());
+
+			if (!_executor)
+			{
+				_executor = _threadPool->makeScheduledExecutor();
+				_executor->scheduleAtFixedRate(std::bind(&CallClientGRPC::expireCalls, this),
+							       EXPIRY_PERIOD);
+			}
+		}
+		_calls[message.id()] = call;
+	}
+	if (expires) _callsCondition.notify_all();
+
+	if (!_writer->write(message))
+	{
+		std::lock_guard<std::mutex> lock(_callsMutex);
+		_deadlines.erase(std::make_pair(call.deadline, message.id()));
+		_calls.erase(message.id());
+		return false;
+	}
+
+	return true;
+}
+
+void CallClientGRPC::expireCalls()
+{
+	auto firstDeadline = [this] { return _deadlines.empty() ? Deadline::max() : _deadlines.begin()->first; };
+
+	std::unique_lock<std::mutex> lock(_callsMutex);
+	while (!_stopping)
+	{
+		// woken up by the earliest deadline, or by a call that expires before it
+		Deadline deadline = firstDeadline();
+		auto deadlineChanged = [this, &firstDeadline, deadline] {
+			return _stopping || firstDeadline() != deadline;
+		};
+		if (deadline == Deadline::max())
+			_callsCondition.wait(lock, deadlineChanged);
+		else
+			_callsCondition.wait_until(lock, deadline, deadlineChanged);
+
+		std::vector<Completion> expired;
+		auto now = std::chrono::steady_clock::now();
+		while (!_deadlines.empty() && _deadlines.begin()->first <= now)
+		{
+			auto it = _calls.find(_deadlines.begin()->second);
+			if (it != _calls.end())
+			{
+				expired.push_back(std::move(it->second.completion));
+				_calls.erase(it);
+			}
+			_deadlines.erase(_deadlines.begin());
+		}
+
+		// the completions are called without the lock, like the responses
+		lock.unlock();
+		for (auto& completion : expired) completion(nullptr);
+		lock.lock();
+	}
+}
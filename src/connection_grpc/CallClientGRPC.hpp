@@ -0,0 +1,95 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_INTERNAL_NETWORK_CALLCLIENTGRPC_HPP
+#define GHOST_INTERNAL_NETWORK_CALLCLIENTGRPC_HPP
+
+#include <ghost/connection_grpc/ServerClientService.pb.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ghost/connection/Client.hpp>
+#include <ghost/connection/Writer.hpp>
+#include <ghost/connection_grpc/CallClientGRPC.hpp>
+#include <ghost/module/ThreadPool.hpp>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Implementation of ghost::CallClientGRPC. The requests are wrapped in a CallMessage with a new id and written
+ *	by the writer of the client, the completions of the pending requests are kept by id until the CallMessage
+ *	with the same id is read.
+ *	The calls with a timeout are expired by a task of the thread pool, which is started by the first of them and
+ *	waits for the earliest deadline.
+ */
+class CallClientGRPC : public ghost::CallClientGRPC
+{
+public:
+	/// @param threadPool	runs the task that expires the calls, the calls do not expire if it is null.
+	CallClientGRPC(const std::shared_ptr<ghost::Client>& client,
+		       const std::shared_ptr<ghost::ThreadPool>& threadPool);
+	~CallClientGRPC();
+
+	size_t countPendingCalls() const override;
+	/// Completes the request of the response, called by the message handler of the client.
+	void onResponse(const ghost::protobuf::connectiongrpc::CallMessage& response);
+	/// Completes all the pending calls with a null response, called when the stream of the client is lost.
+	void failCalls();
+
+protected:
+	bool sendCall(const google::protobuf::Any& request, const Completion& completion,
+		      const std::chrono::milliseconds& timeout) override;
+
+private:
+	/// Rate of the expiry task, which only returns when this object is destroyed.
+	static const std::chrono::milliseconds EXPIRY_PERIOD;
+
+	using Deadline = std::chrono::steady_clock::time_point;
+
+	struct Call
+	{
+		Completion completion;
+		Deadline deadline; // max if the call does not expire
+	};
+
+	/// Task of the expiry executor: completes the calls whose deadline passed, until this object is destroyed.
+	void expireCalls();
+
+	std::shared_ptr<ghost::Client> _client;
+	std::shared_ptr<ghost::ThreadPool> _threadPool;
+	std::shared_ptr<ghost::Writer<ghost::protobuf::connectiongrpc::CallMessage>> _writer;
+	std::atomic<uint64_t> _nextId;
+	mutable std::mutex _callsMutex;
+	std::condition_variable _callsCondition; // a call that expires was sent, or this object is destroyed
+	std::unordered_map<uint64_t, Call> _calls;
+	std::set<std::pair<Deadline, uint64_t>> _deadlines; // of the pending calls that expire, by deadline
+	bool _stopping;
+	std::shared_ptr<ghost::ScheduledExecutor> _executor; // started by the first call with a timeout
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_CALLCLIENTGRPC_HPP
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "CallHandlerGRPC.hpp"
+
+#include <ghost/connection_grpc/ServerClientService.pb.h>
+
+#include <ghost/connection/Writer.hpp>
+
+using namespace ghost::internal;
+
+std::shared_ptr<ghost::CallHandlerGRPC> ghost::CallHandlerGRPC::create()
+{
+	return std::make_shared<ghost::internal::CallHandlerGRPC>();
+}
+
+void CallHandlerGRPC::onMessage(const std::shared_ptr<ghost::Client>& client, const google::protobuf::Any& message)
+{
+	ghost::protobuf::connectiongrpc::CallMessage request;
+	if (!message.UnpackTo(&request)) return; // not a call
+
+	// the response keeps the id of the request, its payload is left empty if the request failed
+	ghost::protobuf::connectiongrpc::CallMessage response;
+	response.set_id(request.id());
+
+	auto handler = getHandler(request.payload().type_url());
+	if (!handler || !handler(request.payload(), *response.mutable_payload())) response.clear_payload();
+
+	client->getWriter<ghost::protobuf::connectiongrpc::CallMessage>()->write(response);
+}
+
+void CallHandlerGRPC::addAnyHandler(const std::string& requestTypeName, const AnyHandler& handler)
+{
+	std::lock_guard<std::mutex> lock(_handlersMutex);
+	_handlers[requestTypeName] = handler;
+}
+
+CallHandlerGRPC::AnyHandler CallHandlerGRPC::getHandler(const std::string& typeUrl) const
+{
+	// the full name of the type follows the last '/' of the URL
+	std::string typeName = typeUrl.substr(typeUrl.find_last_of('/') + 1);
+
+	std::lock_guard<std::mutex> lock(_handlersMutex);
+	auto it = _handlers.find(typeName);
+	if (it == _handlers.end()) return AnyHandler();
+
+	return it->second;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_INTERNAL_NETWORK_CALLHANDLERGRPC_HPP
+#define GHOST_INTERNAL_NETWORK_CALLHANDLERGRPC_HPP
+
+#include <ghost/connection_grpc/CallHandlerGRPC.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Implementation of ghost::CallHandlerGRPC. The handlers are selected with the type URL of the request carried
+ *	by the received CallMessage, and the response is written by the writer of the client.
+ */
+class CallHandlerGRPC : public ghost::CallHandlerGRPC
+{
+public:
+	void onMessage(const std::shared_ptr<ghost::Client>& client, const google::protobuf::Any& message) override;
+
+protected:
+	void addAnyHandler(const std::string& requestTypeName, const AnyHandler& handler) override;
+
+private:
+	AnyHandler getHandler(const std::string& typeUrl) const;
+
+	mutable std::mutex _handlersMutex;
+	std::map<std::string, AnyHandler> _handlers;
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_CALLHANDLERGRPC_HPP
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ChannelArgumentsGRPC.hpp"
+
+#include <grpc/grpc.h>
+
+#include <algorithm>
+#include <limits>
+
+using namespace ghost::internal;
+
+void ChannelArgumentsGRPC::applyTo(const ghost::ConnectionConfigurationGRPC& configuration,
+				   grpc::ServerBuilder& builder)
+{
+	for (const auto& argument : collect(configuration, true))
+		builder.AddChannelArgument(argument.first, argument.second);
+}
+
+grpc::ChannelArguments ChannelArgumentsGRPC::makeClientArguments(
+    const ghost::ConnectionConfigurationGRPC& configuration)
+{
+	grpc::ChannelArguments arguments;
+	for (const auto& argument : collect(configuration, false))
+		arguments.SetInt(argument.first, argument.second);
+
+	if (configuration.isReconnectEnabled())
+	{
+		// The channel reconnects its transport with its own backoff (1 s by default), which must not delay the
+		// reconnection attempts of the client.
+		auto initialBackoff = std::max<long long>(configuration.getReconnectInitialBackoff().count(), 1);
+		auto maxBackoff = std::max<long long>(configuration.getReconnectMaxBackoff().count(), initialBackoff);
+		arguments.SetInt(GRPC_ARG_INITIAL_RECONNECT_BACKOFF_MS, toArgument(initialBackoff));
+		arguments.SetInt(GRPC_ARG_MIN_RECONNECT_BACKOFF_MS, toArgument(initialBackoff));
+		arguments.SetInt(GRPC_ARG_MAX_RECONNECT_BACKOFF_MS, toArgument(maxBackoff));
+	}
+
+	// The addresses resolved for one endpoint (a DNS name with several records) are balanced by gRPC, which
+	// keeps its default "pick_first" policy unless the streams must be spread.
+	using LoadBalancingPolicy = ghost::ConnectionConfigurationGRPC::LoadBalancingPolicy;
+	if (configuration.getLoadBalancingPolicy() != LoadBalancingPolicy::PICK_FIRST)
+		arguments.SetLoadBalancingPolicyName("round_robin");
+
+	return arguments;
+}
+
+std::vector<std::pair<std::string, int>> ChannelArgumentsGRPC::collect(
+    const ghost::ConnectionConfigurationGRPC& configuration, bool server)
+{
+	// the settings left to 0 keep the default value of gRPC
+	std::vector<std::pair<std::string, int>> arguments;
+
+	auto keepaliveTime = configuration.getKeepaliveTime().count();
+	if (keepaliveTime > 0)
+	{
+		arguments.emplace_back(GRPC_ARG_KEEPALIVE_TIME_MS, toArgument(keepaliveTime));
+		// the streams of ghost connections may stay idle for a long time, keep pinging anyway
+		arguments.emplace_back(GRPC_ARG_HTTP2_MAX_PINGS_WITHOUT_DATA, 0);
+		// accept the pings of the peers configured like this one instead of closing their connection
+		if (server)
+			arguments.emplace_back(GRPC_ARG_HTTP2_MIN_RECV_PING_INTERVAL_WITHOUT_DATA_MS,
+					       toArgument(keepaliveTime));
+	}
+
+	auto keepaliveTimeout = configuration.getKeepaliveTimeout().count();
+	if (keepaliveTimeout > 0) arguments.emplace_back(GRPC_ARG_KEEPALIVE_TIMEOUT_MS, toArgument(keepaliveTimeout));
+
+	if (configuration.getMaxSendMessageSize() > 0)
+		arguments.emplace_back(GRPC_ARG_MAX_SEND_MESSAGE_LENGTH,
+				       toArgument(configuration.getMaxSendMessageSize()));
+	if (configuration.getMaxReceiveMessageSize() > 0)
+		arguments.emplace_back(GRPC_ARG_MAX_RECEIVE_MESSAGE_LENGTH,
+				       toArgument(configuration.getMaxReceiveMessageSize()));
+
+	// without BDP probing, the lookahead is the window announced to the peer
+	if (configuration.getHTTP2InitialWindowSize() > 0)
+		arguments.emplace_back(GRPC_ARG_HTTP2_STREAM_LOOKAHEAD_BYTES,
+				       toArgument(configuration.getHTTP2InitialWindowSize()));
+	// gRPC probes by default: the argument is only needed to disable it
+	if (!configuration.isHTTP2BDPProbeEnabled()) arguments.emplace_back(GRPC_ARG_HTTP2_BDP_PROBE, 0);
+
+	// streams are opened by the clients, the limit is announced by the servers
+	if (server && configuration.getMaxConcurrentStreams() > 0)
+		arguments.emplace_back(GRPC_ARG_MAX_CONCURRENT_STREAMS,
+				       toArgument(configuration.getMaxConcurrentStreams()));
+
+	if (configuration.getWriteBufferSize() > 0)
+		arguments.emplace_back(GRPC_ARG_HTTP2_WRITE_BUFFER_SIZE,
+				       toArgument(configuration.getWriteBufferSize()));
+
+	return arguments;
+}
+
+int ChannelArgumentsGRPC::toArgument(size_t value)
+{
+	// some arguments give -1 a special meaning (unlimited, disabled...), the largest value is the closest one
+	return static_cast<int>(std::min(value, static_cast<size_t>(std::numeric_limits<int>::max())));
+}
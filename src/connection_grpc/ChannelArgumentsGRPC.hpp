@@ -0,0 +1,55 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GHOST_INTERNAL_NETWORK_CHANNELARGUMENTSGRPC_HPP
+#define GHOST_INTERNAL_NETWORK_CHANNELARGUMENTSGRPC_HPP
+
+#include <grpcpp/server_builder.h>
+#include <grpcpp/support/channel_arguments.h>
+
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Translates the transport settings of a ghost::ConnectionConfigurationGRPC (keepalive, message sizes,
+ *	HTTP/2 flow control...) into gRPC channel arguments.
+ *	The same arguments are applied to the grpc::ServerBuilder of servers and publishers, and to the
+ *	grpc::ChannelArguments of clients and subscribers, so that both ends of a connection agree.
+ */
+class ChannelArgumentsGRPC
+{
+public:
+	/// Adds the channel arguments of "configuration" to a server builder.
+	static void applyTo(const ghost::ConnectionConfigurationGRPC& configuration, grpc::ServerBuilder& builder);
+	/// @return the channel arguments of "configuration" for an outgoing channel.
+	static grpc::ChannelArguments makeClientArguments(const ghost::ConnectionConfigurationGRPC& configuration);
+
+private:
+	static std::vector<std::pair<std::string, int>> collect(const ghost::ConnectionConfigurationGRPC& configuration,
+								 bool server);
+	/// Converts a size to a channel argument value, sizes that do not fit in an int are clamped to INT_MAX.
+	static int toArgument(size_t value);
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_CHANNELARGUMENTSGRPC_HPP
@@ -20,14 +20,13 @@ using namespace ghost::internal;
 
 ClientGRPC::ClientGRPC(const ghost::ConnectionConfiguration& config,
 		       const std::shared_ptr<ghost::ThreadPool>& threadPool)
-    : ClientGRPC(ghost::NetworkConnectionConfiguration::initializeFrom(config), threadPool)
+    : ClientGRPC(ghost::ConnectionConfigurationGRPC::initializeFrom(config), threadPool)
 {
 }
 
-ClientGRPC::ClientGRPC(const ghost::NetworkConnectionConfiguration& config,
+ClientGRPC::ClientGRPC(const ghost::ConnectionConfigurationGRPC& config,
 		       const std::shared_ptr<ghost::ThreadPool>& threadPool)
-    : ghost::Client(config)
-    , _client(threadPool, config.getServerIpAddress(), config.getServerPortNumber(), config.getThreadPoolSize())
+    : ghost::Client(config), _threadPool(threadPool), _client(threadPool, config)
 {
 	_client.setReaderSink(getReaderSink());
 	_client.setWriterSink(getWriterSink());
@@ -38,6 +37,11 @@ bool ClientGRPC::start()
 	return _client.start();
 }
 
+std::shared_future<bool> ClientGRPC::startAsync(const std::function<void(bool)>& callback)
+{
+	return _client.startAsync(callback);
+}
+
 bool ClientGRPC::stop()
 {
 	return _client.stop();
@@ -47,3 +51,33 @@ bool ClientGRPC::isRunning() const
 {
 	return _client.isRunning();
 }
+
+WriterQueue::Status ClientGRPC::awaitWritable(const std::chrono::milliseconds& timeout)
+{
+	return _client.awaitWritable(timeout);
+}
+
+size_t ClientGRPC::countExpiredMessages() const
+{
+	return _client.getWriterQueue()->countExpired();
+}
+
+OutgoingRPC::ReconnectStatistics ClientGRPC::getReconnectStatistics() const
+{
+	return _client.getReconnectStatistics();
+}
+
+SequenceChecker::Statistics ClientGRPC::getSequenceStatistics() const
+{
+	return _client.getSequenceStatistics();
+}
+
+void ClientGRPC::addDisconnectedCallback(const std::function<void()>& callback)
+{
+	_client.addDisconnectedCallback(callback);
+}
+
+const std::shared_ptr<ghost::ThreadPool>& ClientGRPC::getThreadPool() const
+{
+	return _threadPool;
+}
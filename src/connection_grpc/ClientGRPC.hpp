@@ -17,8 +17,10 @@
 #ifndef GHOST_INTERNAL_NETWORK_CLIENTGRPC_HPP
 #define GHOST_INTERNAL_NETWORK_CLIENTGRPC_HPP
 
+#include <chrono>
+#include <functional>
 #include <ghost/connection/Client.hpp>
-#include <ghost/connection/NetworkConnectionConfiguration.hpp>
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
 #include <ghost/module/ThreadPool.hpp>
 
 #include "rpc/OutgoingRPC.hpp"
@@ -31,19 +33,40 @@ namespace internal
  *	Utilizes an ghost::internal::OutgoingRPC to fulfill the ghost::Client interface.
  *	Initialized the RPC with a writerSink and a readerSink from the ghost::ReabableConnection
  *	and ghost::WritableConnection.
+ *
+ *	The messages waiting to be sent are bounded by the writer watermarks of the configuration, see
+ *	ghost::ConnectionConfigurationGRPC::setWriterWatermarks.
  */
 class ClientGRPC : public ghost::Client
 {
 public:
 	ClientGRPC(const ghost::ConnectionConfiguration& config, const std::shared_ptr<ghost::ThreadPool>& threadPool);
-	ClientGRPC(const ghost::NetworkConnectionConfiguration& config,
+	ClientGRPC(const ghost::ConnectionConfigurationGRPC& config,
 		   const std::shared_ptr<ghost::ThreadPool>& threadPool);
 
 	bool start() override;
+	/// Connects without blocking, see ghost::internal::OutgoingRPC::startAsync.
+	std::shared_future<bool> startAsync(const std::function<void(bool)>& callback = {});
 	bool stop() override;
 	bool isRunning() const override;
 
+	/// Blocks until the connection accepts new messages, or until the timeout expires.
+	/// With a timeout of 0, returns WriterQueue::Status::WOULD_BLOCK immediately if the queue is full.
+	WriterQueue::Status awaitWritable(const std::chrono::milliseconds& timeout);
+	/// @return the number of messages that expired before they were sent, see
+	/// ghost::ConnectionConfigurationGRPC::setMessageTimeToLive.
+	size_t countExpiredMessages() const;
+
+	/// Metrics of the automatic reconnection, see ghost::ConnectionConfigurationGRPC::setReconnectEnabled.
+	OutgoingRPC::ReconnectStatistics getReconnectStatistics() const;
+	/// Metrics of the received sequence numbers, see ghost::ConnectionConfigurationGRPC::setSequenceNumbersEnabled.
+	SequenceChecker::Statistics getSequenceStatistics() const;
+	/// See ghost::internal::OutgoingRPC::addDisconnectedCallback.
+	void addDisconnectedCallback(const std::function<void()>& callback);
+	const std::shared_ptr<ghost::ThreadPool>& getThreadPool() const;
+
 private:
+	std::shared_ptr<ghost::ThreadPool> _threadPool;
 	OutgoingRPC _client;
 };
 } // namespace internal
@@ -22,12 +22,16 @@
 
 using namespace ghost::internal;
 
-ClientManager::ClientManager(const std::shared_ptr<ghost::ThreadPool>& threadPool) : _threadPool(threadPool)
+const std::chrono::milliseconds ClientManager::RETRY_PERIOD = std::chrono::milliseconds(100);
+
+ClientManager::ClientManager(const std::shared_ptr<ghost::ThreadPool>& threadPool)
+    : _threadPool(threadPool), _stopping(false)
 {
 }
 
 ClientManager::~ClientManager()
 {
+	stopManagement();
 	deleteAllClients();
 }
 
@@ -35,17 +39,20 @@ void ClientManager::start()
 {
 	if (!_executor)
 	{
+		{
+			std::lock_guard<std::mutex> lock(_finishedClientsMutex);
+			_stopping = false;
+		}
 		_executor = _threadPool->makeScheduledExecutor();
-		_executor->scheduleAtFixedRate(std::bind(&ClientManager::manageClients, this),
-					       std::chrono::milliseconds(100));
+		// the management pass runs until "stop" and sleeps while no client finished
+		_executor->scheduleAtFixedRate(std::bind(&ClientManager::manageClients, this), RETRY_PERIOD);
 	}
 }
 
 void ClientManager::stop()
 {
 	stopClients();
-
-	if (_executor) _executor->stop();
+	stopManagement();
 
 	// do not delete the clients -> this might be called by a client's thread shutting down the server. In that
 	// case, its executor thread would try to join itself
@@ -53,48 +60,103 @@ void ClientManager::stop()
 
 void ClientManager::addClient(std::shared_ptr<RemoteClientGRPC> client)
 {
-	std::lock_guard<std::mutex> lock(_mutex);
-	_allClients.push_back(client);
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_allClients[client.get()] = client;
+	}
+
+	// the raw pointer is only used as a key, the client is looked up in _allClients before it is used
+	client->getRPC()->setFinishedCallback(std::bind(&ClientManager::onClientFinished, this, client.get()));
 }
 
 void ClientManager::stopClients()
 {
-	std::deque<std::shared_ptr<RemoteClientGRPC>> allClients;
-	{
-		std::lock_guard<std::mutex> lock(_mutex);
-		allClients = _allClients;
-	}
+	auto allClients = copyClients();
+
+	// The running clients are all told to stop before the first one is awaited: their executions finish in
+	// parallel, and the stop takes as long as the slowest client instead of the sum of all of them.
+	auto stoppingClients = requestStop(allClients);
 
 	for (auto it = allClients.begin(); it != allClients.end(); ++it) (*it)->stop();
+	for (auto it = stoppingClients.begin(); it != stoppingClients.end(); ++it) (*it)->getRPC()->dispose();
 }
 
 void ClientManager::shutdownClients()
 {
-	std::deque<std::shared_ptr<RemoteClientGRPC>> allClients;
+	// All the RPCs start finishing before the first one is awaited, their completions are processed in
+	// parallel by the completion queue instead of one client after the other.
+	auto stoppingClients = requestStop(copyClients());
+
+	for (auto it = stoppingClients.begin(); it != stoppingClients.end(); ++it) (*it)->getRPC()->dispose();
+}
+
+size_t ClientManager::countClients() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _allClients.size();
+}
+
+std::vector<std::shared_ptr<RemoteClientGRPC>> ClientManager::copyClients() const
+{
+	std::vector<std::shared_ptr<RemoteClientGRPC>> allClients;
+	std::lock_guard<std::mutex> lock(_mutex);
+	allClients.reserve(_allClients.size());
+	for (const auto& client : _allClients) allClients.push_back(client.second);
+	return allClients;
+}
+
+std::vector<std::shared_ptr<RemoteClientGRPC>> ClientManager::requestStop(
+    const std::vector<std::shared_ptr<RemoteClientGRPC>>& clients)
+{
+	std::vector<std::shared_ptr<RemoteClientGRPC>> stoppingClients;
+	stoppingClients.reserve(clients.size());
+	for (auto it = clients.begin(); it != clients.end(); ++it)
 	{
-		std::lock_guard<std::mutex> lock(_mutex);
-		allClients = _allClients;
+		if ((*it)->getRPC()->requestStop()) stoppingClients.push_back(*it);
 	}
+	return stoppingClients;
+}
 
-	for (auto it = allClients.begin(); it != allClients.end(); ++it) (*it)->shutdown();
+void ClientManager::onClientFinished(const RemoteClientGRPC* client)
+{
+	{
+		std::lock_guard<std::mutex> lock(_finishedClientsMutex);
+		_finishedClients.push_back(client);
+	}
+	_finishedClientsCondition.notify_one();
 }
 
 void ClientManager::deleteDisposableClients()
 {
+	{
+		std::lock_guard<std::mutex> lock(_finishedClientsMutex);
+		_disposableClients.insert(_finishedClients.begin(), _finishedClients.end());
+		_finishedClients.clear();
+	}
+
+	if (_disposableClients.empty()) return;
+
 	std::list<std::shared_ptr<RemoteClientGRPC>> clientsToStop;
 	{
 		std::lock_guard<std::mutex> lock(_mutex);
-		auto it = _allClients.begin();
-		while (it != _allClients.end())
+		auto it = _disposableClients.begin();
+		while (it != _disposableClients.end())
 		{
-			// remember the client to delete it once the mutex is released
-			if (!(*it)->isRunning() && it->use_count() == 1)
+			auto client = _allClients.find(*it);
+			if (client == _allClients.end())
 			{
-				clientsToStop.push_back(*it);
-				it = _allClients.erase(it);
+				// already deleted
+				it = _disposableClients.erase(it);
+			}
+			else if (!client->second->isRunning() && client->second.use_count() == 1)
+			{
+				// remember the client to delete it once the mutex is released
+				clientsToStop.push_back(client->second);
+				_allClients.erase(client);
+				it = _disposableClients.erase(it);
 			}
 			else
-				++it;
+				++it; // still executing or used somewhere else, checked again during the next pass
 		}
 	}
 
@@ -104,15 +166,48 @@ void ClientManager::deleteDisposableClients()
 
 void ClientManager::deleteAllClients()
 {
-	for (auto it = _allClients.begin(); it != _allClients.end(); ++it)
-	{
-		(*it)->getRPC()->dispose();
-	}
+	auto allClients = copyClients();
+	for (auto it = allClients.begin(); it != allClients.end(); ++it) (*it)->getRPC()->setFinishedCallback({});
+
+	// as in "shutdownClients", the RPCs finish in parallel
+	requestStop(allClients);
+	for (auto it = allClients.begin(); it != allClients.end(); ++it) (*it)->getRPC()->dispose();
 	_allClients.clear();
+	_disposableClients.clear();
+	_finishedClients.clear();
 }
 
 void ClientManager::manageClients()
 {
-	// stop, dispose grpc and delete all clients whose shared_ptr has a counter of 1
-	deleteDisposableClients();
+	std::unique_lock<std::mutex> lock(_finishedClientsMutex);
+	while (!_stopping)
+	{
+		// woken up by a finished client, the clients that could not be deleted yet are checked periodically
+		auto clientFinished = [this] { return _stopping || !_finishedClients.empty(); };
+		if (_disposableClients.empty())
+			_finishedClientsCondition.wait(lock, clientFinished);
+		else
+			_finishedClientsCondition.wait_for(lock, RETRY_PERIOD, clientFinished);
+		if (_stopping) break;
+
+		// stop, dispose grpc and delete all clients whose shared_ptr has a counter of 1
+		lock.unlock();
+		deleteDisposableClients();
+		lock.lock();
+	}
+}
+
+void ClientManager::stopManagement()
+{
+	{
+		std::lock_guard<std::mutex> lock(_finishedClientsMutex);
+		_stopping = true;
+	}
+	_finishedClientsCondition.notify_all();
+
+	if (_executor)
+	{
+		_executor->stop();
+		_executor.reset();
+	}
 }
@@ -18,10 +18,14 @@
 #define GHOST_INTERNAL_NETWORK_CLIENTMANAGER_HPP
 
 #include <atomic>
-#include <deque>
+#include <chrono>
+#include <condition_variable>
 #include <ghost/module/ThreadPool.hpp>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace ghost
 {
@@ -33,7 +37,9 @@ class RemoteClientGRPC;
  *	Manager for gRPC clients represented by a RemoteClientGRPC (internally containing
  *	ghost::internal::IncomingRPC objects).
  *	Acts as a collection of clients and can shut down all clients.
- *	Periodically deletes clients that are shut down and not used anymore.
+ *	Clients report themselves to the manager when their RPC finishes, which wakes up the management pass: it
+ *	deletes the reported clients that are shut down and not used anymore, without walking through the other
+ *	clients. The reported clients that are still executing or used are checked again periodically.
  */
 class ClientManager
 {
@@ -41,30 +47,52 @@ public:
 	ClientManager(const std::shared_ptr<ghost::ThreadPool>& threadPool);
 	~ClientManager();
 
-	/// Starts a thread periodically deleting old clients
+	/// Starts a thread deleting the finished clients
 	void start();
-	/// stops the thread periodically deleting old clients, and deletes all the clients after disposing them
+	/// stops the thread deleting the finished clients, and deletes all the clients after disposing them
 	/// this call might be blocking while the clients are disposing
 	void stop();
 
 	/// Adds a client to the manager
 	void addClient(std::shared_ptr<RemoteClientGRPC> client);
-	/// Stops currently running clients.
+	/// Stops currently running clients. All of them are told to stop before the first one is awaited.
 	void stopClients();
 	void shutdownClients();
+	/// Returns the number of managed clients, including the ones waiting for a connection and the ones not
+	/// deleted yet.
+	size_t countClients() const;
 
 private:
-	/// dispose and delete clients that are in finished state and owned solely by this manager
+	/// Returns a copy of the managed clients, to be used without the lock.
+	std::vector<std::shared_ptr<RemoteClientGRPC>> copyClients() const;
+	/// Starts finishing the RPCs of "clients" without waiting for them. @return the clients whose RPC was active.
+	static std::vector<std::shared_ptr<RemoteClientGRPC>> requestStop(
+	    const std::vector<std::shared_ptr<RemoteClientGRPC>>& clients);
+	/// called by the RPC of a client when it finished, the client is checked during the next management pass
+	void onClientFinished(const RemoteClientGRPC* client);
+	/// dispose and delete reported clients that are in finished state and owned solely by this manager
 	void deleteDisposableClients();
 	/// Deletes all managed clients. Should not be called concurrently with "add"
 	void deleteAllClients();
-	/// loops over the managed clients and tries to delte unused clients with "deleteDisposableClients"
+	/// waits for finished clients and tries to delete them with "deleteDisposableClients", until "stop" is called
 	void manageClients();
+	void stopManagement();
+
+	static const std::chrono::milliseconds RETRY_PERIOD;
 
 	std::shared_ptr<ghost::ThreadPool> _threadPool;
 	std::shared_ptr<ghost::ScheduledExecutor> _executor;
-	std::mutex _mutex;
-	std::deque<std::shared_ptr<RemoteClientGRPC>> _allClients;
+	mutable std::mutex _mutex;
+	std::unordered_map<const RemoteClientGRPC*, std::shared_ptr<RemoteClientGRPC>> _allClients;
+
+	// clients whose RPC finished, reported by the completion queue threads
+	std::mutex _finishedClientsMutex;
+	std::condition_variable _finishedClientsCondition; // notified when a client finished, or by "stop"
+	std::vector<const RemoteClientGRPC*> _finishedClients;
+	bool _stopping;
+	// reported clients that could not be deleted yet (still used or still executing), only used by the
+	// management pass
+	std::unordered_set<const RemoteClientGRPC*> _disposableClients;
 };
 } // namespace internal
 } // namespace ghost
@@ -16,8 +16,28 @@
 
 #include "CompletionQueueExecutor.hpp"
 
+#include <map>
+
 using namespace ghost::internal;
 
+std::shared_ptr<CompletionQueueExecutor> CompletionQueueExecutor::getClientExecutor(
+    const std::shared_ptr<ghost::ThreadPool>& threadPool, size_t threadsCount)
+{
+	static std::mutex executorsMutex;
+	static std::map<const ghost::ThreadPool*, std::weak_ptr<CompletionQueueExecutor>> executors;
+
+	std::lock_guard<std::mutex> lock(executorsMutex);
+	auto executor = executors[threadPool.get()].lock();
+	if (!executor)
+	{
+		// the executor holds the thread pool: the entry cannot be reused by another pool while it exists
+		executor = std::make_shared<CompletionQueueExecutor>(new grpc::CompletionQueue(), threadPool);
+		executor->start(threadsCount);
+		executors[threadPool.get()] = executor;
+	}
+	return executor;
+}
+
 CompletionQueueExecutor::CompletionQueueExecutor(const std::shared_ptr<ghost::ThreadPool>& threadPool)
     : _threadPool(threadPool)
 {
@@ -59,7 +79,10 @@ void CompletionQueueExecutor::stop()
 {
 	if (_completionQueue) _completionQueue->Shutdown();
 
-	while (!_completionQueueShutdown) _threadPool->yield(std::chrono::milliseconds(10));
+	// Signaled by the executor that reads the end of the queue.
+	std::unique_lock<std::mutex> lock(_shutdownMutex);
+	_shutdownCondition.wait(lock, [this] { return _completionQueueShutdown.load(); });
+	lock.unlock();
 
 	for (auto& t : _executors) t->stop();
 }
@@ -79,7 +102,13 @@ void CompletionQueueExecutor::handleRpcs()
 
 		// Update the state of the completion queue
 		if (status == grpc::CompletionQueue::NextStatus::SHUTDOWN)
-			_completionQueueShutdown = true;
+		{
+			{
+				std::lock_guard<std::mutex> lock(_shutdownMutex);
+				_completionQueueShutdown = true;
+			}
+			_shutdownCondition.notify_all();
+		}
 		else
 			_completionQueueShutdown = false;
 
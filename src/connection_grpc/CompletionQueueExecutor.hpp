@@ -19,9 +19,12 @@
 
 #include <grpcpp/completion_queue.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <ghost/module/ThreadPool.hpp>
 #include <list>
+#include <mutex>
 
 namespace ghost
 {
@@ -31,10 +34,16 @@ namespace internal
  *	Starts concurrently listening to RPCs with the help of the provided
  *	ghost::ThreadPool.
  *	Manages the gRPC completion queue and processes tags that have been updated.
+ *	The clients share one executor per thread pool, obtained with "getClientExecutor".
  */
 class CompletionQueueExecutor
 {
 public:
+	/// Returns the started executor shared by the clients using this thread pool, and creates it if it does
+	/// not exist. It is stopped and deleted with the last client that uses it.
+	static std::shared_ptr<CompletionQueueExecutor> getClientExecutor(
+	    const std::shared_ptr<ghost::ThreadPool>& threadPool, size_t threadsCount);
+
 	CompletionQueueExecutor(const std::shared_ptr<ghost::ThreadPool>& threadPool);
 	CompletionQueueExecutor(grpc::CompletionQueue* completion,
 				const std::shared_ptr<ghost::ThreadPool>& threadPool);
@@ -53,6 +62,8 @@ private:
 	std::shared_ptr<ghost::ThreadPool> _threadPool;
 	std::list<std::shared_ptr<ghost::ScheduledExecutor>> _executors;
 	std::atomic_bool _completionQueueShutdown{true};
+	std::mutex _shutdownMutex;
+	std::condition_variable _shutdownCondition;
 };
 
 /**
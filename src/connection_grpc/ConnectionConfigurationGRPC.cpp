@@ -16,6 +16,8 @@
 
 #include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
 
+#include <algorithm>
+
 using namespace ghost;
 
 namespace ghost
@@ -23,13 +25,117 @@ namespace ghost
 namespace internal
 {
 static std::string CONNECTIONCONFIGURATIONGRPC_TECHNOLOGY = "CONNECTIONCONFIGURATIONGRPC_TECHNOLOGY";
+// The following attributes are left empty until they are set, so that they match any value in the rules of the
+// ghost::ConnectionFactory. Their getters return the default value in that case.
+static std::string CONNECTIONCONFIGURATIONGRPC_WRITER_HIGH_WATERMARK =
+    "CONNECTIONCONFIGURATIONGRPC_WRITER_HIGH_WATERMARK";
+static std::string CONNECTIONCONFIGURATIONGRPC_WRITER_LOW_WATERMARK =
+    "CONNECTIONCONFIGURATIONGRPC_WRITER_LOW_WATERMARK";
+static std::string CONNECTIONCONFIGURATIONGRPC_WRITER_HIGH_WATERMARK_BYTES =
+    "CONNECTIONCONFIGURATIONGRPC_WRITER_HIGH_WATERMARK_BYTES";
+static std::string CONNECTIONCONFIGURATIONGRPC_WRITER_LOW_WATERMARK_BYTES =
+    "CONNECTIONCONFIGURATIONGRPC_WRITER_LOW_WATERMARK_BYTES";
+static std::string CONNECTIONCONFIGURATIONGRPC_WRITER_MAX_COALESCING_DELAY =
+    "CONNECTIONCONFIGURATIONGRPC_WRITER_MAX_COALESCING_DELAY";
+static std::string CONNECTIONCONFIGURATIONGRPC_RECONNECT_ENABLED = "CONNECTIONCONFIGURATIONGRPC_RECONNECT_ENABLED";
+static std::string CONNECTIONCONFIGURATIONGRPC_RECONNECT_INITIAL_BACKOFF =
+    "CONNECTIONCONFIGURATIONGRPC_RECONNECT_INITIAL_BACKOFF";
+static std::string CONNECTIONCONFIGURATIONGRPC_RECONNECT_MAX_BACKOFF =
+    "CONNECTIONCONFIGURATIONGRPC_RECONNECT_MAX_BACKOFF";
+static std::string CONNECTIONCONFIGURATIONGRPC_KEEPALIVE_TIME = "CONNECTIONCONFIGURATIONGRPC_KEEPALIVE_TIME";
+static std::string CONNECTIONCONFIGURATIONGRPC_KEEPALIVE_TIMEOUT = "CONNECTIONCONFIGURATIONGRPC_KEEPALIVE_TIMEOUT";
+static std::string CONNECTIONCONFIGURATIONGRPC_MAX_SEND_MESSAGE_SIZE =
+    "CONNECTIONCONFIGURATIONGRPC_MAX_SEND_MESSAGE_SIZE";
+static std::string CONNECTIONCONFIGURATIONGRPC_MAX_RECEIVE_MESSAGE_SIZE =
+    "CONNECTIONCONFIGURATIONGRPC_MAX_RECEIVE_MESSAGE_SIZE";
+static std::string CONNECTIONCONFIGURATIONGRPC_HTTP2_INITIAL_WINDOW_SIZE =
+    "CONNECTIONCONFIGURATIONGRPC_HTTP2_INITIAL_WINDOW_SIZE";
+static std::string CONNECTIONCONFIGURATIONGRPC_HTTP2_BDP_PROBE = "CONNECTIONCONFIGURATIONGRPC_HTTP2_BDP_PROBE";
+static std::string CONNECTIONCONFIGURATIONGRPC_MAX_CONCURRENT_STREAMS =
+    "CONNECTIONCONFIGURATIONGRPC_MAX_CONCURRENT_STREAMS";
+static std::string CONNECTIONCONFIGURATIONGRPC_ACCEPT_POOL_MIN_SIZE =
+    "CONNECTIONCONFIGURATIONGRPC_ACCEPT_POOL_MIN_SIZE";
+static std::string CONNECTIONCONFIGURATIONGRPC_ACCEPT_POOL_MAX_SIZE =
+    "CONNECTIONCONFIGURATIONGRPC_ACCEPT_POOL_MAX_SIZE";
+static std::string CONNECTIONCONFIGURATIONGRPC_SERVER_SHARDS = "CONNECTIONCONFIGURATIONGRPC_SERVER_SHARDS";
+static std::string CONNECTIONCONFIGURATIONGRPC_LAGGING_SUBSCRIBER_TIMEOUT =
+    "CONNECTIONCONFIGURATIONGRPC_LAGGING_SUBSCRIBER_TIMEOUT";
+static std::string CONNECTIONCONFIGURATIONGRPC_SERVER_ENDPOINTS = "CONNECTIONCONFIGURATIONGRPC_SERVER_ENDPOINTS";
+static std::string CONNECTIONCONFIGURATIONGRPC_LOAD_BALANCING_POLICY =
+    "CONNECTIONCONFIGURATIONGRPC_LOAD_BALANCING_POLICY";
+static std::string CONNECTIONCONFIGURATIONGRPC_MESSAGE_PRIORITIES = "CONNECTIONCONFIGURATIONGRPC_MESSAGE_PRIORITIES";
+static std::string CONNECTIONCONFIGURATIONGRPC_PRIORITY_STARVATION_LIMIT =
+    "CONNECTIONCONFIGURATIONGRPC_PRIORITY_STARVATION_LIMIT";
+static std::string CONNECTIONCONFIGURATIONGRPC_MESSAGE_TIMES_TO_LIVE =
+    "CONNECTIONCONFIGURATIONGRPC_MESSAGE_TIMES_TO_LIVE";
+static std::string CONNECTIONCONFIGURATIONGRPC_SEQUENCE_NUMBERS_ENABLED =
+    "CONNECTIONCONFIGURATIONGRPC_SEQUENCE_NUMBERS_ENABLED";
+static std::string CONNECTIONCONFIGURATIONGRPC_WRITE_BUFFER_SIZE = "CONNECTIONCONFIGURATIONGRPC_WRITE_BUFFER_SIZE";
+static std::string CONNECTIONCONFIGURATIONGRPC_STREAM_MESSAGE_TYPE =
+    "CONNECTIONCONFIGURATIONGRPC_STREAM_MESSAGE_TYPE";
+
+static const size_t DEFAULT_WRITER_HIGH_WATERMARK = 1024;
+static const size_t DEFAULT_WRITER_LOW_WATERMARK = 512;
+static const size_t DEFAULT_WRITER_HIGH_WATERMARK_BYTES = 0;
+static const size_t DEFAULT_WRITER_LOW_WATERMARK_BYTES = 0;
+static const size_t DEFAULT_WRITER_MAX_COALESCING_DELAY_US = 0;
+static const bool DEFAULT_RECONNECT_ENABLED = false;
+static const size_t DEFAULT_RECONNECT_INITIAL_BACKOFF_MS = 50;
+static const size_t DEFAULT_RECONNECT_MAX_BACKOFF_MS = 5000;
+// 0 keeps the default value of gRPC
+static const size_t DEFAULT_KEEPALIVE_TIME_MS = 0;
+static const size_t DEFAULT_KEEPALIVE_TIMEOUT_MS = 0;
+static const size_t DEFAULT_MAX_SEND_MESSAGE_SIZE = 0;
+static const size_t DEFAULT_MAX_RECEIVE_MESSAGE_SIZE = 0;
+static const size_t DEFAULT_HTTP2_INITIAL_WINDOW_SIZE = 0;
+static const bool DEFAULT_HTTP2_BDP_PROBE = true;
+static const size_t DEFAULT_MAX_CONCURRENT_STREAMS = 0;
+static const size_t DEFAULT_WRITE_BUFFER_SIZE = 0;
+static const size_t DEFAULT_ACCEPT_POOL_MIN_SIZE = 0;
+static const size_t DEFAULT_ACCEPT_POOL_MAX_SIZE = 1024;
+static const size_t DEFAULT_SERVER_SHARDS = 1;
+static const size_t DEFAULT_LAGGING_SUBSCRIBER_TIMEOUT_MS = 0;
+static const ConnectionConfigurationGRPC::LoadBalancingPolicy DEFAULT_LOAD_BALANCING_POLICY =
+    ConnectionConfigurationGRPC::LoadBalancingPolicy::PICK_FIRST;
+static const size_t DEFAULT_PRIORITY_STARVATION_LIMIT = 16;
+static const bool DEFAULT_SEQUENCE_NUMBERS_ENABLED = false;
+
+// the per-type attributes are stored as a comma separated list of "type=value"
+static std::string writeTypeValues(const std::map<std::string, size_t>& values)
+{
+	std::string list;
+	for (const auto& entry : values)
+	{
+		if (!list.empty()) list += ",";
+		list += entry.first + "=" + std::to_string(entry.second);
+	}
+	return list;
+}
+
+static std::map<std::string, size_t> readTypeValues(const std::string& list)
+{
+	std::map<std::string, size_t> values;
+	size_t start = 0;
+	while (start < list.size())
+	{
+		size_t end = list.find(',', start);
+		if (end == std::string::npos) end = list.size();
+
+		std::string entry = list.substr(start, end - start);
+		size_t separator = entry.find('=');
+		if (separator != std::string::npos && separator + 1 < entry.size() &&
+		    entry.find_first_not_of("0123456789", separator + 1) == std::string::npos)
+			values[entry.substr(0, separator)] = std::stoul(entry.substr(separator + 1));
+		start = end + 1;
+	}
+	return values;
 }
+} // namespace internal
 } // namespace ghost
 
 ConnectionConfigurationGRPC::ConnectionConfigurationGRPC(const std::string& name) : NetworkConnectionConfiguration(name)
 {
-	ghost::ConfigurationValue techonologyAttribute;
-	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_TECHNOLOGY, techonologyAttribute);
+	addAttributes();
 }
 
 ConnectionConfigurationGRPC::ConnectionConfigurationGRPC(const std::string& ip, int port)
@@ -38,3 +144,456 @@ ConnectionConfigurationGRPC::ConnectionConfigurationGRPC(const std::string& ip,
 	setServerIpAddress(ip);
 	setServerPortNumber(port);
 }
+
+ConnectionConfigurationGRPC::ConnectionConfigurationGRPC(const ghost::NetworkConnectionConfiguration& other)
+    : NetworkConnectionConfiguration(other)
+{
+	addAttributes();
+}
+
+ConnectionConfigurationGRPC ConnectionConfigurationGRPC::initializeFrom(const ghost::ConnectionConfiguration& other)
+{
+	return ConnectionConfigurationGRPC(ghost::NetworkConnectionConfiguration::initializeFrom(other));
+}
+
+void ConnectionConfigurationGRPC::setWriterWatermarks(size_t highWatermark, size_t lowWatermark)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_HIGH_WATERMARK, highWatermark);
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_LOW_WATERMARK, lowWatermark);
+}
+
+size_t ConnectionConfigurationGRPC::getWriterHighWatermark() const
+{
+	return getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_HIGH_WATERMARK,
+				internal::DEFAULT_WRITER_HIGH_WATERMARK);
+}
+
+size_t ConnectionConfigurationGRPC::getWriterLowWatermark() const
+{
+	return getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_LOW_WATERMARK,
+				internal::DEFAULT_WRITER_LOW_WATERMARK);
+}
+
+void ConnectionConfigurationGRPC::setWriterWatermarksBytes(size_t highWatermarkBytes, size_t lowWatermarkBytes)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_HIGH_WATERMARK_BYTES,
+					highWatermarkBytes);
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_LOW_WATERMARK_BYTES,
+					lowWatermarkBytes);
+}
+
+size_t ConnectionConfigurationGRPC::getWriterHighWatermarkBytes() const
+{
+	return getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_HIGH_WATERMARK_BYTES,
+				internal::DEFAULT_WRITER_HIGH_WATERMARK_BYTES);
+}
+
+size_t ConnectionConfigurationGRPC::getWriterLowWatermarkBytes() const
+{
+	return getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_LOW_WATERMARK_BYTES,
+				internal::DEFAULT_WRITER_LOW_WATERMARK_BYTES);
+}
+
+void ConnectionConfigurationGRPC::setWriterMaxCoalescingDelay(const std::chrono::microseconds& delay)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_MAX_COALESCING_DELAY,
+					static_cast<size_t>(std::max<long long>(0, delay.count())));
+}
+
+std::chrono::microseconds ConnectionConfigurationGRPC::getWriterMaxCoalescingDelay() const
+{
+	size_t delay = getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_MAX_COALESCING_DELAY,
+					internal::DEFAULT_WRITER_MAX_COALESCING_DELAY_US);
+	return std::chrono::microseconds(delay);
+}
+
+void ConnectionConfigurationGRPC::setReconnectEnabled(bool enabled)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_RECONNECT_ENABLED, enabled);
+}
+
+bool ConnectionConfigurationGRPC::isReconnectEnabled() const
+{
+	bool enabled;
+	if (_configuration->getAttribute<bool>(internal::CONNECTIONCONFIGURATIONGRPC_RECONNECT_ENABLED, enabled))
+		return enabled;
+
+	return internal::DEFAULT_RECONNECT_ENABLED;
+}
+
+void ConnectionConfigurationGRPC::setReconnectBackoff(const std::chrono::milliseconds& initialBackoff,
+						      const std::chrono::milliseconds& maxBackoff)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_RECONNECT_INITIAL_BACKOFF,
+					static_cast<size_t>(std::max<long long>(0, initialBackoff.count())));
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_RECONNECT_MAX_BACKOFF,
+					static_cast<size_t>(std::max<long long>(0, maxBackoff.count())));
+}
+
+std::chrono::milliseconds ConnectionConfigurationGRPC::getReconnectInitialBackoff() const
+{
+	size_t backoff = getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_RECONNECT_INITIAL_BACKOFF,
+					  internal::DEFAULT_RECONNECT_INITIAL_BACKOFF_MS);
+	return std::chrono::milliseconds(backoff);
+}
+
+std::chrono::milliseconds ConnectionConfigurationGRPC::getReconnectMaxBackoff() const
+{
+	size_t backoff = getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_RECONNECT_MAX_BACKOFF,
+					  internal::DEFAULT_RECONNECT_MAX_BACKOFF_MS);
+	return std::chrono::milliseconds(backoff);
+}
+
+void ConnectionConfigurationGRPC::setKeepalive(const std::chrono::milliseconds& time,
+					       const std::chrono::milliseconds& timeout)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_KEEPALIVE_TIME,
+					static_cast<size_t>(std::max<long long>(0, time.count())));
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_KEEPALIVE_TIMEOUT,
+					static_cast<size_t>(std::max<long long>(0, timeout.count())));
+}
+
+std::chrono::milliseconds ConnectionConfigurationGRPC::getKeepaliveTime() const
+{
+	return std::chrono::milliseconds(getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_KEEPALIVE_TIME,
+							  internal::DEFAULT_KEEPALIVE_TIME_MS));
+}
+
+std::chrono::milliseconds ConnectionConfigurationGRPC::getKeepaliveTimeout() const
+{
+	return std::chrono::milliseconds(getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_KEEPALIVE_TIMEOUT,
+							  internal::DEFAULT_KEEPALIVE_TIMEOUT_MS));
+}
+
+void ConnectionConfigurationGRPC::setMaxMessageSize(size_t maxSendSize, size_t maxReceiveSize)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_MAX_SEND_MESSAGE_SIZE, maxSendSize);
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_MAX_RECEIVE_MESSAGE_SIZE, maxReceiveSize);
+}
+
+size_t ConnectionConfigurationGRPC::getMaxSendMessageSize() const
+{
+	return getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_MAX_SEND_MESSAGE_SIZE,
+				internal::DEFAULT_MAX_SEND_MESSAGE_SIZE);
+}
+
+size_t ConnectionConfigurationGRPC::getMaxReceiveMessageSize() const
+{
+	return getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_MAX_RECEIVE_MESSAGE_SIZE,
+				internal::DEFAULT_MAX_RECEIVE_MESSAGE_SIZE);
+}
+
+void ConnectionConfigurationGRPC::setHTTP2InitialWindowSize(size_t size)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_HTTP2_INITIAL_WINDOW_SIZE, size);
+}
+
+size_t ConnectionConfigurationGRPC::getHTTP2InitialWindowSize() const
+{
+	return getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_HTTP2_INITIAL_WINDOW_SIZE,
+				internal::DEFAULT_HTTP2_INITIAL_WINDOW_SIZE);
+}
+
+void ConnectionConfigurationGRPC::setHTTP2BDPProbeEnabled(bool enabled)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_HTTP2_BDP_PROBE, enabled);
+}
+
+bool ConnectionConfigurationGRPC::isHTTP2BDPProbeEnabled() const
+{
+	bool enabled;
+	if (_configuration->getAttribute<bool>(internal::CONNECTIONCONFIGURATIONGRPC_HTTP2_BDP_PROBE, enabled))
+		return enabled;
+
+	return internal::DEFAULT_HTTP2_BDP_PROBE;
+}
+
+void ConnectionConfigurationGRPC::setMaxConcurrentStreams(size_t count)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_MAX_CONCURRENT_STREAMS, count);
+}
+
+size_t ConnectionConfigurationGRPC::getMaxConcurrentStreams() const
+{
+	return getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_MAX_CONCURRENT_STREAMS,
+				internal::DEFAULT_MAX_CONCURRENT_STREAMS);
+}
+
+void ConnectionConfigurationGRPC::setWriteBufferSize(size_t size)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITE_BUFFER_SIZE, size);
+}
+
+size_t ConnectionConfigurationGRPC::getWriteBufferSize() const
+{
+	return getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITE_BUFFER_SIZE,
+				internal::DEFAULT_WRITE_BUFFER_SIZE);
+}
+
+void ConnectionConfigurationGRPC::setAcceptPoolSize(size_t minSize, size_t maxSize)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_ACCEPT_POOL_MIN_SIZE, minSize);
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_ACCEPT_POOL_MAX_SIZE, maxSize);
+}
+
+size_t ConnectionConfigurationGRPC::getAcceptPoolMinSize() const
+{
+	return getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_ACCEPT_POOL_MIN_SIZE,
+				internal::DEFAULT_ACCEPT_POOL_MIN_SIZE);
+}
+
+size_t ConnectionConfigurationGRPC::getAcceptPoolMaxSize() const
+{
+	return getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_ACCEPT_POOL_MAX_SIZE,
+				internal::DEFAULT_ACCEPT_POOL_MAX_SIZE);
+}
+
+void ConnectionConfigurationGRPC::setServerShards(size_t count)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_SERVER_SHARDS, count);
+}
+
+size_t ConnectionConfigurationGRPC::getServerShards() const
+{
+	size_t count =
+	    getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_SERVER_SHARDS, internal::DEFAULT_SERVER_SHARDS);
+	return count > 0 ? count : 1;
+}
+
+void ConnectionConfigurationGRPC::setLaggingSubscriberTimeout(const std::chrono::milliseconds& timeout)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_LAGGING_SUBSCRIBER_TIMEOUT,
+					static_cast<size_t>(std::max<long long>(0, timeout.count())));
+}
+
+std::chrono::milliseconds ConnectionConfigurationGRPC::getLaggingSubscriberTimeout() const
+{
+	size_t timeout = getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_LAGGING_SUBSCRIBER_TIMEOUT,
+					  internal::DEFAULT_LAGGING_SUBSCRIBER_TIMEOUT_MS);
+	return std::chrono::milliseconds(timeout);
+}
+
+void ConnectionConfigurationGRPC::setServerEndpoints(const std::vector<std::string>& endpoints)
+{
+	// stored as a comma separated list
+	std::string list;
+	for (const auto& endpoint : endpoints)
+	{
+		if (endpoint.empty()) continue;
+		if (!list.empty()) list += ",";
+		list += endpoint;
+	}
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_SERVER_ENDPOINTS, list);
+}
+
+std::vector<std::string> ConnectionConfigurationGRPC::getServerEndpoints() const
+{
+	std::vector<std::string> endpoints;
+	std::string list;
+	if (!_configuration->getAttribute<std::string>(internal::CONNECTIONCONFIGURATIONGRPC_SERVER_ENDPOINTS, list))
+		return endpoints;
+
+	size_t start = 0;
+	while (start < list.size())
+	{
+		size_t end = list.find(',', start);
+		if (end == std::string::npos) end = list.size();
+		if (end > start) endpoints.push_back(list.substr(start, end - start));
+		start = end + 1;
+	}
+	return endpoints;
+}
+
+void ConnectionConfigurationGRPC::setLoadBalancingPolicy(LoadBalancingPolicy policy)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_LOAD_BALANCING_POLICY,
+					static_cast<size_t>(policy));
+}
+
+ConnectionConfigurationGRPC::LoadBalancingPolicy ConnectionConfigurationGRPC::getLoadBalancingPolicy() const
+{
+	size_t policy = getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_LOAD_BALANCING_POLICY,
+					 static_cast<size_t>(internal::DEFAULT_LOAD_BALANCING_POLICY));
+	if (policy > static_cast<size_t>(LoadBalancingPolicy::LEAST_OUTSTANDING))
+		return internal::DEFAULT_LOAD_BALANCING_POLICY;
+
+	return static_cast<LoadBalancingPolicy>(policy);
+}
+
+void ConnectionConfigurationGRPC::setStreamMessageType(const std::string& typeName)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_STREAM_MESSAGE_TYPE, typeName);
+}
+
+std::string ConnectionConfigurationGRPC::getStreamMessageType() const
+{
+	std::string typeName;
+	if (_configuration->getAttribute<std::string>(internal::CONNECTIONCONFIGURATIONGRPC_STREAM_MESSAGE_TYPE,
+						      typeName))
+		return typeName;
+
+	return "";
+}
+
+void ConnectionConfigurationGRPC::setMessagePriority(const std::string& typeName, MessagePriority priority)
+{
+	std::map<std::string, size_t> priorities;
+	for (const auto& entry : getMessagePriorities()) priorities[entry.first] = static_cast<size_t>(entry.second);
+	priorities[typeName] = static_cast<size_t>(priority);
+
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_MESSAGE_PRIORITIES,
+					internal::writeTypeValues(priorities));
+}
+
+ConnectionConfigurationGRPC::MessagePriority ConnectionConfigurationGRPC::getMessagePriority(
+    const std::string& typeName) const
+{
+	auto priorities = getMessagePriorities();
+	auto it = priorities.find(typeName);
+	if (it == priorities.end()) return MessagePriority::NORMAL;
+
+	return it->second;
+}
+
+std::map<std::string, ConnectionConfigurationGRPC::MessagePriority> ConnectionConfigurationGRPC::getMessagePriorities()
+    const
+{
+	std::map<std::string, MessagePriority> priorities;
+	std::string list;
+	if (!_configuration->getAttribute<std::string>(internal::CONNECTIONCONFIGURATIONGRPC_MESSAGE_PRIORITIES, list))
+		return priorities;
+
+	for (const auto& entry : internal::readTypeValues(list))
+		priorities[entry.first] = static_cast<MessagePriority>(
+		    std::min<size_t>(entry.second, static_cast<size_t>(MessagePriority::BULK)));
+	return priorities;
+}
+
+void ConnectionConfigurationGRPC::setPriorityStarvationLimit(size_t count)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_PRIORITY_STARVATION_LIMIT, count);
+}
+
+size_t ConnectionConfigurationGRPC::getPriorityStarvationLimit() const
+{
+	return getSizeAttribute(internal::CONNECTIONCONFIGURATIONGRPC_PRIORITY_STARVATION_LIMIT,
+				internal::DEFAULT_PRIORITY_STARVATION_LIMIT);
+}
+
+void ConnectionConfigurationGRPC::setMessageTimeToLive(const std::string& typeName,
+						       const std::chrono::milliseconds& timeToLive)
+{
+	std::map<std::string, size_t> timesToLive;
+	for (const auto& entry : getMessageTimesToLive()) timesToLive[entry.first] = entry.second.count();
+	if (timeToLive.count() > 0)
+		timesToLive[typeName] = timeToLive.count();
+	else
+		timesToLive.erase(typeName);
+
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_MESSAGE_TIMES_TO_LIVE,
+					internal::writeTypeValues(timesToLive));
+}
+
+std::chrono::milliseconds ConnectionConfigurationGRPC::getMessageTimeToLive(const std::string& typeName) const
+{
+	auto timesToLive = getMessageTimesToLive();
+	auto it = timesToLive.find(typeName);
+	if (it == timesToLive.end()) return std::chrono::milliseconds(0);
+
+	return it->second;
+}
+
+std::map<std::string, std::chrono::milliseconds> ConnectionConfigurationGRPC::getMessageTimesToLive() const
+{
+	std::map<std::string, std::chrono::milliseconds> timesToLive;
+	std::string list;
+	if (!_configuration->getAttribute<std::string>(internal::CONNECTIONCONFIGURATIONGRPC_MESSAGE_TIMES_TO_LIVE,
+						       list))
+		return timesToLive;
+
+	for (const auto& entry : internal::readTypeValues(list))
+		timesToLive[entry.first] = std::chrono::milliseconds(entry.second);
+	return timesToLive;
+}
+
+void ConnectionConfigurationGRPC::setSequenceNumbersEnabled(bool enabled)
+{
+	_configuration->updateAttribute(internal::CONNECTIONCONFIGURATIONGRPC_SEQUENCE_NUMBERS_ENABLED, enabled);
+}
+
+bool ConnectionConfigurationGRPC::isSequenceNumbersEnabled() const
+{
+	bool enabled;
+	if (_configuration->getAttribute<bool>(internal::CONNECTIONCONFIGURATIONGRPC_SEQUENCE_NUMBERS_ENABLED, enabled))
+		return enabled;
+
+	return internal::DEFAULT_SEQUENCE_NUMBERS_ENABLED;
+}
+
+void ConnectionConfigurationGRPC::addAttributes()
+{
+	// attributes that already exist (copied from another configuration) are not overwritten
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_TECHNOLOGY, ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_HIGH_WATERMARK,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_LOW_WATERMARK,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_HIGH_WATERMARK_BYTES,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_LOW_WATERMARK_BYTES,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITER_MAX_COALESCING_DELAY,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_RECONNECT_ENABLED,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_RECONNECT_INITIAL_BACKOFF,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_RECONNECT_MAX_BACKOFF,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_KEEPALIVE_TIME,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_KEEPALIVE_TIMEOUT,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_MAX_SEND_MESSAGE_SIZE,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_MAX_RECEIVE_MESSAGE_SIZE,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_HTTP2_INITIAL_WINDOW_SIZE,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_HTTP2_BDP_PROBE,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_MAX_CONCURRENT_STREAMS,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_WRITE_BUFFER_SIZE,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_ACCEPT_POOL_MIN_SIZE,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_ACCEPT_POOL_MAX_SIZE,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_SERVER_SHARDS,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_LAGGING_SUBSCRIBER_TIMEOUT,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_SERVER_ENDPOINTS,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_LOAD_BALANCING_POLICY,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_STREAM_MESSAGE_TYPE,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_MESSAGE_PRIORITIES,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_PRIORITY_STARVATION_LIMIT,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_MESSAGE_TIMES_TO_LIVE,
+				     ghost::ConfigurationValue());
+	_configuration->addAttribute(internal::CONNECTIONCONFIGURATIONGRPC_SEQUENCE_NUMBERS_ENABLED,
+				     ghost::ConfigurationValue());
+}
+
+size_t ConnectionConfigurationGRPC::getSizeAttribute(const std::string& name, size_t defaultValue) const
+{
+	size_t value;
+	if (_configuration->getAttribute<size_t>(name, value)) return value;
+
+	return defaultValue;
+}
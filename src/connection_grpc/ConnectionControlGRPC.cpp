@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ConnectionControlGRPC.hpp"
+
+#include "ClientGRPC.hpp"
+#include "PublisherGRPC.hpp"
+#include "RemoteClientGRPC.hpp"
+#include "ServerGRPC.hpp"
+#include "SubscriberGRPC.hpp"
+
+using namespace ghost::internal;
+
+std::shared_ptr<ghost::ConnectionControlGRPC> ghost::ConnectionControlGRPC::create(
+    const std::shared_ptr<ghost::Connection>& connection)
+{
+	auto control = std::make_shared<ghost::internal::ConnectionControlGRPC>(connection);
+	if (!control->isValid()) return nullptr;
+
+	return control;
+}
+
+ConnectionControlGRPC::ConnectionControlGRPC(const std::shared_ptr<ghost::Connection>& connection)
+    : _connection(connection)
+    , _client(std::dynamic_pointer_cast<ClientGRPC>(connection))
+    , _publisher(std::dynamic_pointer_cast<PublisherGRPC>(connection))
+    , _remoteClient(std::dynamic_pointer_cast<RemoteClientGRPC>(connection))
+    , _subscriber(std::dynamic_pointer_cast<SubscriberGRPC>(connection))
+    , _server(std::dynamic_pointer_cast<ServerGRPC>(connection))
+{
+	_valid = _client || _publisher || _remoteClient || _subscriber || _server;
+}
+
+bool ConnectionControlGRPC::isValid() const
+{
+	return _valid;
+}
+
+std::shared_future<bool> ConnectionControlGRPC::startAsync(const std::function<void(bool)>& callback)
+{
+	if (_client) return _client->startAsync(callback);
+	if (_subscriber) return _subscriber->startAsync(callback);
+
+	// the other connections do not dial a remote peer, their start does not wait for the network
+	bool result = _connection->start();
+	if (callback) callback(result);
+
+	std::promise<bool> promise;
+	promise.set_value(result);
+	return promise.get_future().share();
+}
+
+ghost::ConnectionControlGRPC::WriterStatus ConnectionControlGRPC::awaitWritable(
+    const std::chrono::milliseconds& timeout)
+{
+	if (_client) return _client->awaitWritable(timeout);
+	if (_publisher) return _publisher->awaitWritable(timeout);
+	if (_remoteClient) return _remoteClient->getRPC()->awaitWritable(timeout);
+
+	return WriterStatus::WRITABLE;
+}
+
+ghost::ConnectionControlGRPC::ReconnectStatistics ConnectionControlGRPC::getReconnectStatistics() const
+{
+	if (_client) return _client->getReconnectStatistics();
+	if (_subscriber) return _subscriber->getReconnectStatistics();
+
+	return ReconnectStatistics();
+}
+
+size_t ConnectionControlGRPC::countExpiredMessages() const
+{
+	if (_client) return _client->countExpiredMessages();
+	if (_publisher) return _publisher->countExpiredMessages();
+	if (_remoteClient) return _remoteClient->getRPC()->getWriterQueue()->countExpired();
+
+	return 0;
+}
+
+size_t ConnectionControlGRPC::countDroppedMessages() const
+{
+	if (_publisher) return _publisher->countDroppedMessages();
+
+	return 0;
+}
+
+ghost::ConnectionControlGRPC::SequenceStatistics ConnectionControlGRPC::getSequenceStatistics() const
+{
+	if (_client) return _client->getSequenceStatistics();
+	if (_subscriber) return _subscriber->getSequenceStatistics();
+	if (_remoteClient) return _remoteClient->getRPC()->getSequenceStatistics();
+
+	return SequenceStatistics();
+}
+
+ghost::ConnectionControlGRPC::AcceptStatistics ConnectionControlGRPC::getAcceptStatistics() const
+{
+	if (_server) return _server->getAcceptStatistics();
+	if (_publisher) return _publisher->getAcceptStatistics();
+
+	return AcceptStatistics();
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_INTERNAL_NETWORK_CONNECTIONCONTROLGRPC_HPP
+#define GHOST_INTERNAL_NETWORK_CONNECTIONCONTROLGRPC_HPP
+
+#include <ghost/connection_grpc/ConnectionControlGRPC.hpp>
+#include <memory>
+
+namespace ghost
+{
+namespace internal
+{
+class ClientGRPC;
+class PublisherGRPC;
+class RemoteClientGRPC;
+class ServerGRPC;
+class SubscriberGRPC;
+
+/**
+ *	Implementation of ghost::ConnectionControlGRPC. Forwards the calls to the gRPC connection it was created for,
+ *	the members of the other connection types are null.
+ */
+class ConnectionControlGRPC : public ghost::ConnectionControlGRPC
+{
+public:
+	ConnectionControlGRPC(const std::shared_ptr<ghost::Connection>& connection);
+
+	/// @return true if the connection is one of the gRPC connections.
+	bool isValid() const;
+
+	std::shared_future<bool> startAsync(const std::function<void(bool)>& callback) override;
+	WriterStatus awaitWritable(const std::chrono::milliseconds& timeout) override;
+	ReconnectStatistics getReconnectStatistics() const override;
+	size_t countExpiredMessages() const override;
+	size_t countDroppedMessages() const override;
+	SequenceStatistics getSequenceStatistics() const override;
+	AcceptStatistics getAcceptStatistics() const override;
+
+private:
+	std::shared_ptr<ghost::Connection> _connection;
+	std::shared_ptr<ClientGRPC> _client;
+	std::shared_ptr<PublisherGRPC> _publisher;
+	std::shared_ptr<RemoteClientGRPC> _remoteClient;
+	std::shared_ptr<SubscriberGRPC> _subscriber;
+	std::shared_ptr<ServerGRPC> _server;
+	bool _valid;
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_CONNECTIONCONTROLGRPC_HPP
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "EndpointBalancer.hpp"
+
+#include <map>
+#include <utility>
+
+using namespace ghost::internal;
+
+const size_t EndpointBalancer::NONE = static_cast<size_t>(-1);
+
+std::shared_ptr<EndpointBalancer> EndpointBalancer::get(const std::vector<std::string>& endpoints, Policy policy)
+{
+	static std::mutex balancersMutex;
+	static std::map<std::pair<std::vector<std::string>, Policy>, std::weak_ptr<EndpointBalancer>> balancers;
+
+	std::lock_guard<std::mutex> lock(balancersMutex);
+	auto& entry = balancers[std::make_pair(endpoints, policy)];
+	auto balancer = entry.lock();
+	if (!balancer)
+	{
+		balancer = std::make_shared<EndpointBalancer>(endpoints, policy);
+		entry = balancer;
+	}
+	return balancer;
+}
+
+EndpointBalancer::EndpointBalancer(const std::vector<std::string>& endpoints, Policy policy)
+    : _endpoints(endpoints), _policy(policy), _streams(endpoints.size(), 0), _next(0)
+{
+}
+
+size_t EndpointBalancer::countEndpoints() const
+{
+	return _endpoints.size();
+}
+
+const std::string& EndpointBalancer::getEndpoint(size_t index) const
+{
+	return _endpoints[index];
+}
+
+size_t EndpointBalancer::countStreams(size_t index) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _streams[index];
+}
+
+size_t EndpointBalancer::acquire(size_t failed)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	size_t count = _endpoints.size();
+	// a single endpoint is used even if it failed
+	if (count < 2) failed = NONE;
+
+	size_t index = _next;
+	switch (_policy)
+	{
+		case Policy::PICK_FIRST:
+			// the streams placed from now on use the next endpoint as well
+			if (_next == failed) _next = (_next + 1) % count;
+			index = _next;
+			break;
+		case Policy::ROUND_ROBIN:
+			if (index == failed) index = (index + 1) % count;
+			_next = (index + 1) % count;
+			break;
+		case Policy::LEAST_OUTSTANDING:
+			// ties are broken in turn, starting from the rotation
+			for (size_t i = 0; i < count; ++i)
+			{
+				size_t candidate = (_next + i) % count;
+				if (candidate == failed) continue;
+				if (index == failed || _streams[candidate] < _streams[index]) index = candidate;
+			}
+			_next = (_next + 1) % count;
+			break;
+	}
+
+	_streams[index]++;
+	return index;
+}
+
+void EndpointBalancer::release(size_t index)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (index < _streams.size() && _streams[index] > 0) _streams[index]--;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_INTERNAL_NETWORK_ENDPOINTBALANCER_HPP
+#define GHOST_INTERNAL_NETWORK_ENDPOINTBALANCER_HPP
+
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Places the streams of clients and subscribers on the endpoints of a replicated service, according to a
+ *	ghost::ConnectionConfigurationGRPC::LoadBalancingPolicy.
+ *	The streams of this process that target the same endpoints with the same policy share one balancer, obtained
+ *	with "get", so that they are spread over the endpoints together.
+ */
+class EndpointBalancer
+{
+public:
+	using Policy = ghost::ConnectionConfigurationGRPC::LoadBalancingPolicy;
+
+	/// Value of "failed" for a stream that is placed for the first time.
+	static const size_t NONE;
+
+	/// Returns the balancer shared by the streams using these endpoints and policy, and creates it if it does not
+	/// exist. It is deleted with the last stream that uses it.
+	static std::shared_ptr<EndpointBalancer> get(const std::vector<std::string>& endpoints, Policy policy);
+
+	EndpointBalancer(const std::vector<std::string>& endpoints, Policy policy);
+
+	size_t countEndpoints() const;
+	const std::string& getEndpoint(size_t index) const;
+	/// @return the number of streams currently placed on the endpoint.
+	size_t countStreams(size_t index) const;
+
+	/// Places a stream on an endpoint, it counts as outstanding on this endpoint until "release" is called.
+	/// @param failed	the endpoint that the stream could not use, if any. It is avoided when possible.
+	/// @return the index of the endpoint.
+	size_t acquire(size_t failed = NONE);
+	void release(size_t index);
+
+private:
+	std::vector<std::string> _endpoints;
+	Policy _policy;
+	mutable std::mutex _mutex;
+	std::vector<size_t> _streams;
+	size_t _next; // next endpoint of the rotation, or endpoint in use with PICK_FIRST
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_ENDPOINTBALANCER_HPP
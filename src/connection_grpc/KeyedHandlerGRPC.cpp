@@ -0,0 +1,66 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "KeyedHandlerGRPC.hpp"
+
+#include "KeyedReaderSink.hpp"
+#include "SubscriberGRPC.hpp"
+
+using namespace ghost::internal;
+
+std::shared_ptr<ghost::KeyedHandlerGRPC> ghost::KeyedHandlerGRPC::create(
+    const std::shared_ptr<ghost::Subscriber>& subscriber, size_t lanes, size_t maxPendingMessages)
+{
+	auto subscriberGRPC = std::dynamic_pointer_cast<ghost::internal::SubscriberGRPC>(subscriber);
+	if (!subscriberGRPC) return nullptr;
+
+	auto keyedHandler = std::make_shared<ghost::internal::KeyedHandlerGRPC>();
+
+	// the sink stays in the subscriber, which may outlive the keyed handler
+	std::weak_ptr<ghost::internal::KeyedHandlerGRPC> weakKeyedHandler = keyedHandler;
+	subscriberGRPC->setManagedReaderSink(std::make_shared<KeyedReaderSink>(
+	    subscriberGRPC->getThreadPool(), lanes, maxPendingMessages,
+	    [weakKeyedHandler](const google::protobuf::Any& message, size_t& keyHash, std::function<void()>& task) {
+		    auto keyedHandler = weakKeyedHandler.lock();
+		    return keyedHandler && keyedHandler->prepare(message, keyHash, task);
+	    }));
+
+	return keyedHandler;
+}
+
+bool KeyedHandlerGRPC::prepare(const google::protobuf::Any& message, size_t& keyHash,
+			       std::function<void()>& task) const
+{
+	// the full name of the type follows the last '/' of the URL
+	const std::string& typeUrl = message.type_url();
+	std::string typeName = typeUrl.substr(typeUrl.find_last_of('/') + 1);
+
+	AnyHandler handler;
+	{
+		std::lock_guard<std::mutex> lock(_handlersMutex);
+		auto it = _handlers.find(typeName);
+		if (it == _handlers.end()) return false;
+
+		handler = it->second;
+	}
+	return handler(message, keyHash, task);
+}
+
+void KeyedHandlerGRPC::addAnyHandler(const std::string& typeName, const AnyHandler& handler)
+{
+	std::lock_guard<std::mutex> lock(_handlersMutex);
+	_handlers[typeName] = handler;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GHOST_INTERNAL_NETWORK_KEYEDHANDLERGRPC_HPP
+#define GHOST_INTERNAL_NETWORK_KEYEDHANDLERGRPC_HPP
+
+#include <ghost/connection_grpc/KeyedHandlerGRPC.hpp>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Implementation of ghost::KeyedHandlerGRPC. Finds the handler of the type of the received messages, and
+ *	prepares the task that the reader sink runs in the lane of the message's key.
+ */
+class KeyedHandlerGRPC : public ghost::KeyedHandlerGRPC
+{
+public:
+	/// @return false if "message" has no handler or cannot be unpacked.
+	bool prepare(const google::protobuf::Any& message, size_t& keyHash, std::function<void()>& task) const;
+
+protected:
+	void addAnyHandler(const std::string& typeName, const AnyHandler& handler) override;
+
+private:
+	mutable std::mutex _handlersMutex;
+	std::map<std::string, AnyHandler> _handlers;
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_KEYEDHANDLERGRPC_HPP
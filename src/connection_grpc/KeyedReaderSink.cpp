@@ -0,0 +1,106 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "KeyedReaderSink.hpp"
+
+#include <algorithm>
+
+using namespace ghost::internal;
+
+KeyedReaderSink::KeyedReaderSink(const std::shared_ptr<ghost::ThreadPool>& threadPool, size_t lanes,
+				 size_t maxLaneTasks, const Dispatcher& dispatcher)
+    : _threadPool(threadPool), _maxLaneTasks(std::max<size_t>(maxLaneTasks, 1)), _dispatcher(dispatcher)
+{
+	for (size_t i = 0; i < std::max<size_t>(lanes, 1); ++i) _lanes.emplace_back(new Lane());
+}
+
+bool KeyedReaderSink::put(const google::protobuf::Any& message)
+{
+	size_t keyHash = 0;
+	std::function<void()> task;
+	if (!_dispatcher(message, keyHash, task)) return true; // ignored, as messages without reader
+
+	size_t index = keyHash % _lanes.size();
+	auto& lane = *_lanes[index];
+	{
+		// the reads of the stream wait for the lane
+		std::unique_lock<std::mutex> lock(lane.mutex);
+		lane.condition.wait(lock, [this, &lane] { return lane.tasks.size() < _maxLaneTasks; });
+		lane.tasks.push_back(std::move(task));
+
+		if (lane.running) return true; // the running task handles it
+		lane.running = true;
+	}
+
+	startLane(index);
+	return true;
+}
+
+void KeyedReaderSink::drain()
+{
+}
+
+void KeyedReaderSink::start()
+{
+}
+
+void KeyedReaderSink::stop()
+{
+	// the last tasks may have been started by the completion queue: wait until nothing is left
+	for (auto& lane : _lanes)
+	{
+		std::unique_lock<std::mutex> lock(lane->mutex);
+		lane->condition.wait(lock, [&lane] { return !lane->running; });
+	}
+}
+
+void KeyedReaderSink::startLane(size_t index)
+{
+	// the sink keeps the future of the task, which must not keep the sink alive
+	std::weak_ptr<KeyedReaderSink> weakSelf = shared_from_this();
+	auto execution = _threadPool->execute([weakSelf, index] {
+		auto self = weakSelf.lock();
+		if (self) self->runLane(index);
+	});
+
+	auto& lane = *_lanes[index];
+	std::lock_guard<std::mutex> lock(lane.mutex);
+	lane.execution = std::move(execution);
+}
+
+void KeyedReaderSink::runLane(size_t index)
+{
+	auto& lane = *_lanes[index];
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::lock_guard<std::mutex> lock(lane.mutex);
+			if (lane.tasks.empty())
+			{
+				lane.running = false;
+				lane.condition.notify_all();
+				return;
+			}
+
+			task = std::move(lane.tasks.front());
+			lane.tasks.pop_front();
+		}
+		lane.condition.notify_all(); // a waiting "put" can continue
+
+		task();
+	}
+}
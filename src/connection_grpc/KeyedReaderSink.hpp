@@ -0,0 +1,89 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GHOST_INTERNAL_NETWORK_KEYEDREADERSINK_HPP
+#define GHOST_INTERNAL_NETWORK_KEYEDREADERSINK_HPP
+
+#include <google/protobuf/any.pb.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <ghost/module/ThreadPool.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ManagedReaderSink.hpp"
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Replaces the reader sink of a subscriber to handle the received messages concurrently (see
+ *	ghost::KeyedHandlerGRPC).
+ *	The completion queue thread that read a message unpacks it and appends its task to the lane of its key.
+ *	Each lane with pending tasks has a single task of the thread pool that runs them in order, so that the
+ *	lanes are handled concurrently while the messages of a lane are not reordered.
+ *	"put" blocks the completion queue thread while the lane of the message is full, so that the stream is not read
+ *	until the lane caught up.
+ */
+class KeyedReaderSink : public ManagedReaderSink, public std::enable_shared_from_this<KeyedReaderSink>
+{
+public:
+	/// Returns the hash of the key of "message" and the task that handles it; false if it must be ignored.
+	using Dispatcher =
+	    std::function<bool(const google::protobuf::Any& message, size_t& keyHash, std::function<void()>& task)>;
+
+	KeyedReaderSink(const std::shared_ptr<ghost::ThreadPool>& threadPool, size_t lanes, size_t maxLaneTasks,
+			const Dispatcher& dispatcher);
+
+	bool put(const google::protobuf::Any& message) override;
+	/// Nothing to do: the tasks of the lanes already run.
+	void drain() override;
+
+	void start() override;
+	/// Waits until the pending tasks of all the lanes ran.
+	void stop() override;
+
+private:
+	struct Lane
+	{
+		Lane() : running(false)
+		{
+		}
+
+		std::mutex mutex;
+		std::condition_variable condition; // a task was taken, or the lane stopped running
+		std::deque<std::function<void()>> tasks;
+		bool running; // true while a task of the thread pool handles this lane
+		std::future<void> execution;
+	};
+
+	void startLane(size_t index);
+	void runLane(size_t index);
+
+	std::shared_ptr<ghost::ThreadPool> _threadPool;
+	const size_t _maxLaneTasks;
+	Dispatcher _dispatcher;
+	std::vector<std::unique_ptr<Lane>> _lanes;
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_KEYEDREADERSINK_HPP
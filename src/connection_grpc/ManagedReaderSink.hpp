@@ -0,0 +1,42 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GHOST_INTERNAL_NETWORK_MANAGEDREADERSINK_HPP
+#define GHOST_INTERNAL_NETWORK_MANAGEDREADERSINK_HPP
+
+#include <ghost/connection/ReaderSink.hpp>
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Reader sink that replaces the readers of a subscriber to dispatch the received messages itself (see
+ *	ghost::internal::BatchReaderSink and ghost::internal::KeyedReaderSink).
+ *	The subscriber starts it before connecting, and stops it once the connection is stopped so that the
+ *	messages already received are dispatched.
+ */
+class ManagedReaderSink : public ghost::ReaderSink
+{
+public:
+	virtual void start() = 0;
+	/// Returns once the received messages are dispatched.
+	virtual void stop() = 0;
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_MANAGEDREADERSINK_HPP
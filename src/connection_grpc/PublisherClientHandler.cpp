@@ -16,10 +16,57 @@
 
 #include "PublisherClientHandler.hpp"
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "RemoteClientGRPC.hpp"
+#include "rpc/StreamType.hpp"
+
 using namespace ghost::internal;
 
+const std::chrono::milliseconds PublisherClientHandler::WORKER_PERIOD = std::chrono::milliseconds(10);
+
+PublisherClientHandler::PublisherClientHandler(const ghost::ConnectionConfigurationGRPC& configuration,
+					       const std::shared_ptr<ghost::ThreadPool>& threadPool)
+    : _threadPool(threadPool)
+    , _streamTypeUrl(makeStreamTypeUrl(configuration))
+    , _priorities(configuration.getMessagePriorities())
+    , _timesToLive(configuration.getMessageTimesToLive())
+    , _highWatermark(configuration.getWriterHighWatermark())
+    , _lowWatermark(_highWatermark == 0 ? 0 : std::min(configuration.getWriterLowWatermark(), _highWatermark - 1))
+    , _highWatermarkBytes(configuration.getWriterHighWatermarkBytes())
+    , _lowWatermarkBytes(_highWatermarkBytes == 0
+			     ? 0
+			     : std::min(configuration.getWriterLowWatermarkBytes(), _highWatermarkBytes - 1))
+    , _laggingTimeout(configuration.getLaggingSubscriberTimeout())
+    , _sequenceNumbers(configuration.isSequenceNumbersEnabled())
+    , _sequenceNumber(0)
+    , _droppedMessages(0)
+    , _expiredMessages(0)
+{
+	for (size_t i = 0; i < configuration.getServerShards(); ++i)
+	{
+		_shards.emplace_back(new Shard());
+		Shard* shard = _shards.back().get();
+		shard->worker = _threadPool->makeScheduledExecutor();
+		shard->worker->scheduleAtFixedRate(std::bind(&PublisherClientHandler::runShard, this, std::ref(*shard)),
+						   WORKER_PERIOD);
+	}
+}
+
 PublisherClientHandler::~PublisherClientHandler()
 {
+	for (auto& shard : _shards)
+	{
+		{
+			std::lock_guard<std::mutex> lock(shard->queueMutex);
+			shard->stopping = true;
+		}
+		shard->queueCondition.notify_all();
+		shard->worker->stop();
+	}
+
 	releaseClients();
 }
 
@@ -27,48 +74,309 @@ bool PublisherClientHandler::handle(std::shared_ptr<ghost::Client> client, bool&
 {
 	keepClientAlive = true;
 
-	std::lock_guard<std::mutex> lock(_subscribersMutex);
+	auto subscriber = std::make_shared<Subscriber>();
+	subscriber->client = client;
+	subscriber->writer = client->getWriter<google::protobuf::Any>();
+	auto remoteClient = std::dynamic_pointer_cast<RemoteClientGRPC>(client);
+	if (remoteClient) subscriber->rpc = remoteClient->getRPC();
 
-	auto writer = client->getWriter<google::protobuf::Any>();
-	auto entry = std::make_pair(client, writer);
+	// the new subscriber joins the smallest shard
+	Shard* smallest = nullptr;
+	size_t smallestSize = 0;
+	for (auto& shard : _shards)
+	{
+		std::lock_guard<std::mutex> lock(shard->mutex);
+		if (!smallest || shard->subscribers.size() < smallestSize)
+		{
+			smallest = shard.get();
+			smallestSize = shard->subscribers.size();
+		}
+	}
 
-	_subscribers.push_back(entry);
+	std::lock_guard<std::mutex> lock(smallest->mutex);
+	smallest->subscribers.push_back(subscriber);
 
 	return true;
 }
 
 bool PublisherClientHandler::send(const google::protobuf::Any& message)
 {
-	std::lock_guard<std::mutex> lock(_subscribersMutex);
+	grpc::ByteBuffer buffer;
+	if (!serializeStreamMessage(message, _streamTypeUrl, buffer)) return false;
+
+	return dispatch(buffer, WriterQueue::getPriority(_priorities, message.type_url()),
+			getDeadline(std::chrono::steady_clock::now(),
+				    WriterQueue::getTimeToLive(_timesToLive, message.type_url())));
+}
+
+bool PublisherClientHandler::sendRaw(const grpc::ByteBuffer& message,
+				     const std::chrono::steady_clock::time_point& publishTime)
+{
+	// the type URL is read from the first bytes of the message, which is not decoded. An unreadable message has
+	// the default priority and time to live
+	std::string typeUrl;
+	if (!readStreamTypeUrl(message, _streamTypeUrl, typeUrl)) typeUrl.clear();
+
+	return dispatch(message, WriterQueue::getPriority(_priorities, typeUrl),
+			getDeadline(publishTime, WriterQueue::getTimeToLive(_timesToLive, typeUrl)));
+}
+
+std::chrono::steady_clock::time_point PublisherClientHandler::getDeadline(
+    const std::chrono::steady_clock::time_point& publishTime, const std::chrono::milliseconds& timeToLive)
+{
+	// the time to live starts when the message is published, it may wait in the queues of the shards
+	return timeToLive.count() > 0 ? publishTime + timeToLive : std::chrono::steady_clock::time_point::max();
+}
 
-	auto it = _subscribers.begin();
-	while (it != _subscribers.end())
+bool PublisherClientHandler::dispatch(grpc::ByteBuffer buffer, WriterQueue::Priority priority,
+				      const std::chrono::steady_clock::time_point& deadline)
+{
+	std::unique_lock<std::mutex> sequenceLock(_sequenceMutex, std::defer_lock);
+	if (_sequenceNumbers)
+	{
+		// the lock is kept while dispatching, so that the queues of the shards receive the numbers in order
+		sequenceLock.lock();
+		if (!appendSequenceNumber(buffer, _sequenceNumber + 1)) return false;
+		_sequenceNumber++;
+	}
+
+	Message message;
+	message.buffer = buffer;
+	message.priority = priority;
+	message.deadline = deadline;
+
+	// the caller is responsible for the flow control ("awaitWritable"): the message is appended even if a queue
+	// is full. The queues share the buffer.
+	for (auto& shard : _shards)
 	{
-		if (!it->first->isRunning()	 // if the client is not running anymore, dont send anything
-		    || !it->second->write(message)) // if the write failed
 		{
-			it->first->stop();
-			it = _subscribers.erase(it);
+			std::lock_guard<std::mutex> lock(shard->queueMutex);
+			shard->messages.push_back(message);
+			shard->bytes += buffer.Length();
+			updateWritable(*shard);
 		}
+		shard->queueCondition.notify_one();
+	}
+
+	return true;
+}
+
+void PublisherClientHandler::runShard(Shard& shard)
+{
+	while (true)
+	{
+		Message message;
+		{
+			// woken up by "dispatch". The wait is bounded like the writer of the publisher: the executor
+			// calls this task again
+			std::unique_lock<std::mutex> lock(shard.queueMutex);
+			bool hasMessage = shard.queueCondition.wait_for(lock, WORKER_PERIOD, [&shard] {
+				return !shard.messages.empty() || shard.stopping;
+			});
+			if (!hasMessage || shard.stopping) return;
+
+			message = std::move(shard.messages.front());
+			shard.messages.pop_front();
+			shard.bytes -= std::min(shard.bytes, message.buffer.Length());
+			updateWritable(shard);
+		}
+
+		if (message.deadline <= std::chrono::steady_clock::now())
+			expire(shard);
 		else
-			++it;
+			write(shard, message);
+	}
+}
+
+void PublisherClientHandler::write(Shard& shard, const Message& message)
+{
+	// the full subscribers are waited for after the lock is released, so that new subscribers are not blocked
+	std::vector<std::shared_ptr<Subscriber>> fullSubscribers;
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		google::protobuf::Any parsedMessage;
+		bool parsed = false;
+		auto it = shard.subscribers.begin();
+		while (it != shard.subscribers.end())
+		{
+			auto& subscriber = *it;
+			// if the client is not running anymore, dont send anything
+			bool written = subscriber->client->isRunning();
+			if (written && subscriber->rpc)
+			{
+				// the writer queue shares the buffer
+				if (!writeRaw(*subscriber, message)) fullSubscribers.push_back(subscriber);
+			}
+			else if (written)
+			{
+				// other clients receive the message through their writer, parsed for the first one
+				if (!parsed)
+				{
+					grpc::ByteBuffer copy(message.buffer);
+					if (!parseStreamMessage(copy, _streamTypeUrl, parsedMessage)) return;
+					parsed = true;
+				}
+				written = subscriber->writer->write(parsedMessage);
+			}
+
+			if (!written)
+			{
+				subscriber->client->stop();
+				it = shard.subscribers.erase(it);
+			}
+			else
+				++it;
+		}
 	}
 
+	if (!fullSubscribers.empty()) awaitSubscribers(shard, fullSubscribers, message);
+}
+
+bool PublisherClientHandler::writeRaw(Subscriber& subscriber, const Message& message)
+{
+	// the writer queue receives the time that remains to live
+	std::chrono::milliseconds timeToLive(0);
+	if (message.deadline != std::chrono::steady_clock::time_point::max())
+	{
+		auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+		    message.deadline - std::chrono::steady_clock::now());
+		timeToLive = std::max(remaining, std::chrono::milliseconds(1));
+	}
+
+	if (subscriber.rpc->writeRaw(message.buffer, message.priority, timeToLive))
+	{
+		subscriber.lagging = false;
+		return true;
+	}
+
+	if (!subscriber.lagging) return false;
+
+	_droppedMessages++;
 	return true;
 }
 
+void PublisherClientHandler::awaitSubscribers(Shard& shard,
+					      const std::vector<std::shared_ptr<Subscriber>>& subscribers,
+					      const Message& message)
+{
+	// all the subscribers share the lagging timeout, so that the shard is delayed once per message at most
+	auto laggingDeadline = _laggingTimeout.count() > 0 ? std::chrono::steady_clock::now() + _laggingTimeout
+							   : std::chrono::steady_clock::time_point::max();
+	auto deadline = std::min(laggingDeadline, message.deadline);
+
+	for (const auto& subscriber : subscribers)
+	{
+		while (!shard.stopping && subscriber->client->isRunning())
+		{
+			auto now = std::chrono::steady_clock::now();
+			if (now >= deadline)
+			{
+				if (now >= message.deadline)
+				{
+					_expiredMessages++;
+				}
+				else
+				{
+					subscriber->lagging = true;
+					_droppedMessages++;
+				}
+				break;
+			}
+
+			// bounded, so that a stopping shard or client is noticed
+			auto timeout = std::min(WORKER_PERIOD, std::chrono::duration_cast<std::chrono::milliseconds>(
+								   deadline - now + std::chrono::milliseconds(1)));
+			if (subscriber->rpc->awaitWritable(timeout) == WriterQueue::Status::WRITABLE &&
+			    writeRaw(*subscriber, message))
+				break;
+		}
+	}
+}
+
+void PublisherClientHandler::expire(Shard& shard)
+{
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	_expiredMessages += shard.subscribers.size();
+}
+
+void PublisherClientHandler::updateWritable(Shard& shard) const
+{
+	if (shard.writable)
+	{
+		shard.writable = (_highWatermark == 0 || shard.messages.size() < _highWatermark) &&
+				 (_highWatermarkBytes == 0 || shard.bytes < _highWatermarkBytes);
+	}
+	else if ((_highWatermark == 0 || shard.messages.size() <= _lowWatermark) &&
+		 (_highWatermarkBytes == 0 || shard.bytes <= _lowWatermarkBytes))
+	{
+		shard.writable = true;
+		shard.writableCondition.notify_all();
+	}
+}
+
 size_t PublisherClientHandler::countSubscribers() const
 {
-	std::lock_guard<std::mutex> lock(_subscribersMutex);
-	return _subscribers.size();
+	size_t count = 0;
+	for (const auto& shard : _shards)
+	{
+		std::lock_guard<std::mutex> lock(shard->mutex);
+		count += shard->subscribers.size();
+	}
+	return count;
+}
+
+size_t PublisherClientHandler::countExpiredMessages() const
+{
+	size_t count = _expiredMessages;
+	for (const auto& shard : _shards)
+	{
+		std::lock_guard<std::mutex> lock(shard->mutex);
+		for (const auto& subscriber : shard->subscribers)
+			if (subscriber->rpc) count += subscriber->rpc->getWriterQueue()->countExpired();
+	}
+	return count;
+}
+
+size_t PublisherClientHandler::countDroppedMessages() const
+{
+	return _droppedMessages;
+}
+
+WriterQueue::Status PublisherClientHandler::awaitWritable(const std::chrono::milliseconds& timeout) const
+{
+	// all the shards share the same timeout
+	auto deadline = std::chrono::steady_clock::now() + timeout;
+	for (const auto& shard : _shards)
+	{
+		std::unique_lock<std::mutex> lock(shard->queueMutex);
+		if (shard->writable) continue;
+		if (timeout.count() <= 0) return WriterQueue::Status::WOULD_BLOCK;
+
+		if (!shard->writableCondition.wait_until(lock, deadline, [&shard] { return shard->writable; }))
+			return WriterQueue::Status::TIMEOUT;
+	}
+
+	return WriterQueue::Status::WRITABLE;
 }
 
 void PublisherClientHandler::releaseClients()
 {
-	std::lock_guard<std::mutex> lock(_subscribersMutex);
-	for (auto it = _subscribers.begin(); it != _subscribers.end(); ++it)
+	for (auto& shard : _shards)
 	{
-		it->first->stop();
+		{
+			// the messages that were not written are dropped with the subscribers
+			std::lock_guard<std::mutex> lock(shard->queueMutex);
+			shard->messages.clear();
+			shard->bytes = 0;
+			updateWritable(*shard);
+		}
+
+		std::lock_guard<std::mutex> lock(shard->mutex);
+		for (auto it = shard->subscribers.begin(); it != shard->subscribers.end(); ++it)
+		{
+			(*it)->client->stop();
+		}
+		shard->subscribers.clear();
 	}
-	_subscribers.clear();
 }
@@ -17,34 +17,152 @@
 #ifndef GHOST_INTERNAL_NETWORK_PUBLISHERCLIENTHANDLER_HPP
 #define GHOST_INTERNAL_NETWORK_PUBLISHERCLIENTHANDLER_HPP
 
+#include <grpcpp/support/byte_buffer.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <ghost/connection/Client.hpp>
 #include <ghost/connection/ClientHandler.hpp>
 #include <ghost/connection/Writer.hpp>
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
+#include <ghost/module/ThreadPool.hpp>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
+
+#include "rpc/WriterQueue.hpp"
 
 namespace ghost
 {
 namespace internal
 {
+class IncomingRPC;
+
 /**
  *	This handler keeps the clients which connect to the server, and sends them the published data.
+ *	A published message is serialized once, and the resulting buffer is shared by the writer queues of all the
+ *	subscribers.
+ *	The subscribers are split across the shards of the configuration (see
+ *	ghost::ConnectionConfigurationGRPC::setServerShards). A published message is appended to the queue of every
+ *	shard, and each shard has a worker that writes the messages of its queue to its subscribers: the shards are
+ *	written in parallel, and a slow shard does not delay the other ones.
+ *	The publisher is writable as long as the queues of all the shards are, they apply the writer watermarks of the
+ *	configuration.
+ *	A subscriber whose writer queue is full is waited for after the message was written to the other subscribers of
+ *	the shard, without blocking them: the shard waits for its slowest subscriber, which slows down the publisher
+ *	through the watermarks of the shard queues. If a lagging subscriber timeout is configured, a subscriber that
+ *	stays full during this timeout is lagging instead: the messages are dropped for it, and counted, until its
+ *	queue reaches its low watermark again.
+ *	The time to live of a message starts when it is published, the messages that expire in the queue of a shard are
+ *	counted as expired for each subscriber of the shard.
+ *	The sequence numbers are stamped once per published message: all the subscribers receive the same numbers,
+ *	and a subscriber that reconnects detects the messages it missed.
  */
 class PublisherClientHandler : public ghost::ClientHandler
 {
 public:
+	PublisherClientHandler(const ghost::ConnectionConfigurationGRPC& configuration,
+			       const std::shared_ptr<ghost::ThreadPool>& threadPool);
 	~PublisherClientHandler();
 
 	bool handle(std::shared_ptr<ghost::Client> client, bool& keepClientAlive) override;
 
 	bool send(const google::protobuf::Any& message);
+	/// Sends a message that is already serialized (raw mode, used by relays) without decoding it. Its type URL is
+	/// read to apply the priorities and the times to live of the configuration, from "publishTime".
+	bool sendRaw(const grpc::ByteBuffer& message, const std::chrono::steady_clock::time_point& publishTime);
+	/// Stops the subscribers and drops the messages that were not written to them yet.
 	void releaseClients();
 	size_t countSubscribers() const;
+	/// @return the number of messages that expired in the queues of the shards, and in the writer queues of the
+	/// current subscribers.
+	size_t countExpiredMessages() const;
+	/// @return the number of messages that were dropped for lagging subscribers.
+	size_t countDroppedMessages() const;
+	/// Blocks until the queues of all the shards accept new messages, or until the timeout expires.
+	WriterQueue::Status awaitWritable(const std::chrono::milliseconds& timeout) const;
 
 private:
-	mutable std::mutex _subscribersMutex;
-	std::deque<std::pair<std::shared_ptr<ghost::Client>, std::shared_ptr<ghost::Writer<google::protobuf::Any>>>>
-	    _subscribers;
+	/// Maximum time the worker of a shard waits for its messages, or for a full subscriber, after which it checks
+	/// whether it stops.
+	static const std::chrono::milliseconds WORKER_PERIOD;
+
+	struct Subscriber
+	{
+		std::shared_ptr<ghost::Client> client;
+		std::shared_ptr<ghost::Writer<google::protobuf::Any>> writer;
+		std::shared_ptr<IncomingRPC> rpc; // null if the client is not a ghost::internal::RemoteClientGRPC
+		std::atomic<bool> lagging{false}; // messages are dropped until its writer queue accepts them again
+	};
+
+	struct Message
+	{
+		grpc::ByteBuffer buffer;
+		WriterQueue::Priority priority;
+		std::chrono::steady_clock::time_point deadline; // max if the message does not expire
+	};
+
+	struct Shard
+	{
+		Shard() : bytes(0), writable(true), stopping(false)
+		{
+		}
+
+		mutable std::mutex mutex;
+		std::deque<std::shared_ptr<Subscriber>> subscribers;
+
+		mutable std::mutex queueMutex;
+		std::condition_variable queueCondition;            // a message was appended, or the shard stops
+		mutable std::condition_variable writableCondition; // the queue reached its low watermarks
+		std::deque<Message> messages;
+		size_t bytes;
+		bool writable;
+		std::atomic<bool> stopping;
+		std::shared_ptr<ghost::ScheduledExecutor> worker;
+	};
+
+	/// Appends "buffer" to the queues of all the shards, after stamping it with the next sequence number if they
+	/// are enabled.
+	bool dispatch(grpc::ByteBuffer buffer, WriterQueue::Priority priority,
+		      const std::chrono::steady_clock::time_point& deadline);
+	/// @return the time at which a message published at "publishTime" expires, max if it does not.
+	static std::chrono::steady_clock::time_point getDeadline(
+	    const std::chrono::steady_clock::time_point& publishTime, const std::chrono::milliseconds& timeToLive);
+	/// Task of the worker of "shard": writes the messages of its queue until it stayed empty for a period.
+	void runShard(Shard& shard);
+	/// Writes "message" to the subscribers of one shard, then waits for the subscribers that were full.
+	void write(Shard& shard, const Message& message);
+	/// Writes "message" to the writer queue of a gRPC subscriber, or drops it if the subscriber is lagging.
+	/// @return false if the writer queue is full and the subscriber must be waited for.
+	bool writeRaw(Subscriber& subscriber, const Message& message);
+	/// Waits for the full subscribers until they accept "message", stop, or lag behind.
+	void awaitSubscribers(Shard& shard, const std::vector<std::shared_ptr<Subscriber>>& subscribers,
+			      const Message& message);
+	/// Counts a message that expired in the queue of "shard" once for each of its subscribers.
+	void expire(Shard& shard);
+	/// Same as ghost::internal::WriterQueue for the queue of a shard, its mutex must be locked.
+	void updateWritable(Shard& shard) const;
+
+	std::shared_ptr<ghost::ThreadPool> _threadPool;
+	std::string _streamTypeUrl;
+	std::map<std::string, WriterQueue::Priority> _priorities;
+	std::map<std::string, std::chrono::milliseconds> _timesToLive;
+	const size_t _highWatermark;
+	const size_t _lowWatermark;
+	const size_t _highWatermarkBytes;
+	const size_t _lowWatermarkBytes;
+	const std::chrono::milliseconds _laggingTimeout; // 0 to wait for the slowest subscriber
+	bool _sequenceNumbers;
+	std::mutex _sequenceMutex;
+	uint64_t _sequenceNumber; // last number stamped
+	std::atomic<size_t> _droppedMessages;
+	std::atomic<size_t> _expiredMessages; // in the queues of the shards
+	std::vector<std::unique_ptr<Shard>> _shards;
 };
 } // namespace internal
 } // namespace ghost
@@ -16,19 +16,33 @@
 
 #include "PublisherGRPC.hpp"
 
+#include <algorithm>
+
 using namespace ghost::internal;
 
+const std::chrono::milliseconds PublisherGRPC::WRITER_PERIOD = std::chrono::milliseconds(10);
+
 PublisherGRPC::PublisherGRPC(const ghost::ConnectionConfiguration& config,
 			     const std::shared_ptr<ghost::ThreadPool>& threadPool)
-    : PublisherGRPC(ghost::NetworkConnectionConfiguration::initializeFrom(config), threadPool)
+    : PublisherGRPC(ghost::ConnectionConfigurationGRPC::initializeFrom(config), threadPool)
 {
 }
 
-PublisherGRPC::PublisherGRPC(const ghost::NetworkConnectionConfiguration& config,
+PublisherGRPC::PublisherGRPC(const ghost::ConnectionConfigurationGRPC& config,
 			     const std::shared_ptr<ghost::ThreadPool>& threadPool)
-    : ghost::Publisher(config), _threadPool(threadPool), _server(config, threadPool)
+    : ghost::Publisher(config)
+    , _threadPool(threadPool)
+    , _server(config, threadPool)
+    , _highWatermark(config.getWriterHighWatermark())
+    , _lowWatermark(_highWatermark == 0 ? 0 : std::min(config.getWriterLowWatermark(), _highWatermark - 1))
+    , _highWatermarkBytes(config.getWriterHighWatermarkBytes())
+    , _lowWatermarkBytes(_highWatermarkBytes == 0
+			     ? 0
+			     : std::min(config.getWriterLowWatermarkBytes(), _highWatermarkBytes - 1))
+    , _rawMessagesBytes(0)
+    , _rawMessagesWritable(true)
 {
-	_handler = std::make_shared<PublisherClientHandler>();
+	_handler = std::make_shared<PublisherClientHandler>(config, threadPool);
 	_server.setClientHandler(_handler);
 }
 
@@ -37,8 +51,7 @@ bool PublisherGRPC::start()
 	if (!_executor)
 	{
 		_executor = _threadPool->makeScheduledExecutor();
-		_executor->scheduleAtFixedRate(std::bind(&PublisherGRPC::writerThread, this),
-					       std::chrono::milliseconds(10));
+		_executor->scheduleAtFixedRate(std::bind(&PublisherGRPC::writerThread, this), WRITER_PERIOD);
 
 		return _server.start();
 	}
@@ -50,6 +63,12 @@ bool PublisherGRPC::stop()
 	getWriterSink()->drain();
 
 	if (_executor) _executor->stop();
+	{
+		std::lock_guard<std::mutex> lock(_rawMessagesMutex);
+		_rawMessages.clear();
+		_rawMessagesBytes = 0;
+		_rawMessagesWritable = true;
+	}
 
 	_handler->releaseClients();
 	return _server.stop();
@@ -65,18 +84,94 @@ size_t PublisherGRPC::countSubscribers() const
 	return _handler->countSubscribers();
 }
 
+size_t PublisherGRPC::countExpiredMessages() const
+{
+	return _handler->countExpiredMessages();
+}
+
+size_t PublisherGRPC::countDroppedMessages() const
+{
+	return _handler->countDroppedMessages();
+}
+
+ServerGRPC::AcceptStatistics PublisherGRPC::getAcceptStatistics() const
+{
+	return _server.getAcceptStatistics();
+}
+
+WriterQueue::Status PublisherGRPC::awaitWritable(const std::chrono::milliseconds& timeout) const
+{
+	return _handler->awaitWritable(timeout);
+}
+
+bool PublisherGRPC::publishRaw(const grpc::ByteBuffer& message)
+{
+	{
+		std::lock_guard<std::mutex> lock(_rawMessagesMutex);
+		RawMessage rawMessage;
+		rawMessage.buffer = message;
+		rawMessage.publishTime = std::chrono::steady_clock::now();
+		_rawMessages.push_back(rawMessage);
+		_rawMessagesBytes += message.Length();
+	}
+	sendRawMessages();
+
+	// the watermark is checked after sending, so that the drained callback only follows a "false" result
+	std::lock_guard<std::mutex> lock(_rawMessagesMutex);
+	if (_rawMessagesWritable)
+	{
+		_rawMessagesWritable = (_highWatermark == 0 || _rawMessages.size() < _highWatermark) &&
+				       (_highWatermarkBytes == 0 || _rawMessagesBytes < _highWatermarkBytes);
+	}
+	return _rawMessagesWritable;
+}
+
+void PublisherGRPC::setRawMessagesDrainedCallback(const std::function<void()>& callback)
+{
+	_rawMessagesDrainedCallback = callback;
+}
+
 void PublisherGRPC::writerThread()
 {
+	sendRawMessages();
+
 	auto writer = getWriterSink();
 	google::protobuf::Any message;
-	bool getSuccess = true;
-	while (getSuccess)
+	while (writer->get(message, std::chrono::milliseconds(0)))
 	{
-		getSuccess = writer->get(message, std::chrono::milliseconds(0));
-		if (getSuccess)
+		// the messages stay in the sink while a subscriber cannot keep up, its queue wakes this thread up as
+		// soon as it reaches its low watermark. The wait is bounded so that "stop", which drains the sink, ends
+		// the loop.
+		if (_handler->awaitWritable(WRITER_PERIOD) != WriterQueue::Status::WRITABLE) continue;
+
+		_handler->send(message);
+		writer->pop();
+	}
+}
+
+void PublisherGRPC::sendRawMessages()
+{
+	bool drained = false;
+	{
+		// the lock is kept while sending, so that the messages keep their order
+		std::lock_guard<std::mutex> lock(_rawMessagesMutex);
+		while (!_rawMessages.empty() &&
+		       _handler->awaitWritable(std::chrono::milliseconds(0)) == WriterQueue::Status::WRITABLE)
 		{
-			_handler->send(message);
-			writer->pop();
+			const auto& message = _rawMessages.front();
+			_handler->sendRaw(message.buffer, message.publishTime);
+			_rawMessagesBytes -= std::min(_rawMessagesBytes, message.buffer.Length());
+			_rawMessages.pop_front();
+		}
+
+		if (!_rawMessagesWritable && (_highWatermark == 0 || _rawMessages.size() <= _lowWatermark) &&
+		    (_highWatermarkBytes == 0 || _rawMessagesBytes <= _lowWatermarkBytes))
+		{
+			_rawMessagesWritable = true;
+			drained = true;
 		}
 	}
+
+	// called without the lock: a relay resumes its upstream reads, which may publish again
+	if (drained && _rawMessagesDrainedCallback) _rawMessagesDrainedCallback();
 }
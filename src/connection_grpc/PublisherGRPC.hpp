@@ -17,10 +17,17 @@
 #ifndef GHOST_INTERNAL_NETWORK_PUBLISHERGRPC_HPP
 #define GHOST_INTERNAL_NETWORK_PUBLISHERGRPC_HPP
 
+#include <grpcpp/support/byte_buffer.h>
+
 #include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <ghost/connection/Publisher.hpp>
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
 #include <ghost/module/ThreadPool.hpp>
 #include <memory>
+#include <mutex>
 
 #include "PublisherClientHandler.hpp"
 #include "ServerGRPC.hpp"
@@ -36,14 +43,18 @@ namespace internal
  *	to all the registered clients.
  *
  *	Periodically checks for new messages (10ms fixed rate) and reads messages until
- *	the sink is empty when messages are available.
+ *	the sink is empty when messages are available. While a subscriber's writer queue is full, the writer waits
+ *	for it to drain to its low watermark and resumes right away instead of waiting for the next check.
+ *	Serialized messages published with "publishRaw" wait in a separate queue, under the same conditions. This
+ *	queue applies the writer watermarks of the configuration: the relay that publishes the messages pauses its
+ *	upstream reads while it is full.
  */
 class PublisherGRPC : public ghost::Publisher
 {
 public:
 	PublisherGRPC(const ghost::ConnectionConfiguration& config,
 		      const std::shared_ptr<ghost::ThreadPool>& threadPool);
-	PublisherGRPC(const ghost::NetworkConnectionConfiguration& config,
+	PublisherGRPC(const ghost::ConnectionConfigurationGRPC& config,
 		      const std::shared_ptr<ghost::ThreadPool>& threadPool);
 
 	bool start() override;
@@ -51,14 +62,50 @@ public:
 	bool isRunning() const override;
 
 	size_t countSubscribers() const;
+	/// @return the number of messages that expired before they were sent to the current subscribers.
+	size_t countExpiredMessages() const;
+	/// @return the number of messages that were dropped for subscribers that could not keep up.
+	size_t countDroppedMessages() const;
+	/// Metrics of the pool of posted connection requests, see ghost::internal::ServerGRPC.
+	ServerGRPC::AcceptStatistics getAcceptStatistics() const;
+	/// Blocks until all the subscribers accept new messages, or until the timeout expires.
+	/// With a timeout of 0, returns WriterQueue::Status::WOULD_BLOCK immediately if a subscriber is full.
+	WriterQueue::Status awaitWritable(const std::chrono::milliseconds& timeout) const;
+	/// Publishes a message that is already serialized (raw mode, see ghost::internal::RelayGRPC) without
+	/// decoding it. The message is sent right away unless a subscriber cannot keep up, the publisher keeps it
+	/// until then.
+	/// @return false if the waiting raw messages reached the high watermark: the message is kept, but the caller
+	/// should not publish more until the drained callback is called.
+	bool publishRaw(const grpc::ByteBuffer& message);
+	/// Called, from a thread of the publisher, when the waiting raw messages reached the low watermark after
+	/// "publishRaw" returned false. Must be set before "start".
+	void setRawMessagesDrainedCallback(const std::function<void()>& callback);
 
 private:
+	static const std::chrono::milliseconds WRITER_PERIOD;
+
+	struct RawMessage
+	{
+		grpc::ByteBuffer buffer;
+		std::chrono::steady_clock::time_point publishTime; // the time to live of the message starts here
+	};
+
 	void writerThread(); // waits for the writer to be fed and sends the data to the handler
+	void sendRawMessages();
 
 	std::shared_ptr<ghost::ThreadPool> _threadPool;
 	std::shared_ptr<ghost::ScheduledExecutor> _executor;
 	ServerGRPC _server;
 	std::shared_ptr<PublisherClientHandler> _handler;
+	const size_t _highWatermark;
+	const size_t _lowWatermark;
+	const size_t _highWatermarkBytes;
+	const size_t _lowWatermarkBytes;
+	std::mutex _rawMessagesMutex;
+	std::deque<RawMessage> _rawMessages;
+	size_t _rawMessagesBytes;
+	bool _rawMessagesWritable; // false from the high watermark until the low watermark is reached again
+	std::function<void()> _rawMessagesDrainedCallback;
 };
 } // namespace internal
 } // namespace ghost
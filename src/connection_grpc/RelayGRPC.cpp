@@ -0,0 +1,72 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "RelayGRPC.hpp"
+
+using namespace ghost::internal;
+
+std::shared_ptr<ghost::RelayGRPC> ghost::RelayGRPC::create(const ghost::ConnectionConfigurationGRPC& upstream,
+							   const ghost::ConnectionConfigurationGRPC& downstream,
+							   const std::shared_ptr<ghost::ThreadPool>& threadPool)
+{
+	return std::make_shared<ghost::internal::RelayGRPC>(upstream, downstream, threadPool);
+}
+
+RelayGRPC::RelayGRPC(const ghost::ConnectionConfigurationGRPC& upstream,
+		     const ghost::ConnectionConfigurationGRPC& downstream,
+		     const std::shared_ptr<ghost::ThreadPool>& threadPool)
+    : _publisher(downstream, threadPool), _subscriber(upstream, threadPool)
+{
+	_subscriber.setRawReaderHandler(std::bind(&RelayGRPC::onMessage, this, std::placeholders::_1));
+	_publisher.setRawMessagesDrainedCallback(std::bind(&SubscriberGRPC::resumeReader, &_subscriber));
+}
+
+bool RelayGRPC::start()
+{
+	// the subscribers of the relay can connect before the messages start flowing
+	if (!_publisher.start()) return false;
+
+	if (!_subscriber.start())
+	{
+		_publisher.stop();
+		return false;
+	}
+
+	return true;
+}
+
+bool RelayGRPC::stop()
+{
+	bool subscriberStopped = _subscriber.stop();
+	bool publisherStopped = _publisher.stop();
+	return subscriberStopped && publisherStopped;
+}
+
+bool RelayGRPC::isRunning() const
+{
+	return _publisher.isRunning() && _subscriber.isRunning();
+}
+
+size_t RelayGRPC::countSubscribers() const
+{
+	return _publisher.countSubscribers();
+}
+
+bool RelayGRPC::onMessage(const grpc::ByteBuffer& message)
+{
+	return _publisher.publishRaw(message);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_INTERNAL_NETWORK_RELAYGRPC_HPP
+#define GHOST_INTERNAL_NETWORK_RELAYGRPC_HPP
+
+#include <grpcpp/support/byte_buffer.h>
+
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
+#include <ghost/connection_grpc/RelayGRPC.hpp>
+#include <ghost/module/ThreadPool.hpp>
+#include <memory>
+
+#include "PublisherGRPC.hpp"
+#include "SubscriberGRPC.hpp"
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Implementation of ghost::RelayGRPC with a ghost::internal::SubscriberGRPC reading in raw mode,
+ *	and a ghost::internal::PublisherGRPC to which the received buffers are published as they are.
+ *	The subscriber reconnects to the upstream publisher if the upstream configuration enables it.
+ *	When the downstream subscribers cannot keep up, the publisher stops accepting buffers at its high watermark:
+ *	the relay stops reading from the upstream publisher until the publisher drained its messages.
+ */
+class RelayGRPC : public ghost::RelayGRPC
+{
+public:
+	RelayGRPC(const ghost::ConnectionConfigurationGRPC& upstream,
+		  const ghost::ConnectionConfigurationGRPC& downstream,
+		  const std::shared_ptr<ghost::ThreadPool>& threadPool);
+
+	bool start() override;
+	bool stop() override;
+	bool isRunning() const override;
+	size_t countSubscribers() const override;
+
+private:
+	/// @return false to pause the upstream reads.
+	bool onMessage(const grpc::ByteBuffer& message);
+
+	PublisherGRPC _publisher;
+	SubscriberGRPC _subscriber;
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_RELAYGRPC_HPP
@@ -20,10 +20,42 @@
 
 using namespace ghost::internal;
 
+/**
+ *	Replaces the reader sink of the clients executed by an asynchronous handler: the messages
+ *	are given to the handler from the completion queue thread that read them, and the drain
+ *	that follows the end of the connection notifies the disconnection.
+ */
+class RemoteClientGRPC::HandlerReaderSink : public ghost::ReaderSink
+{
+public:
+	HandlerReaderSink(RemoteClientGRPC* client) : _client(client)
+	{
+	}
+
+	bool put(const google::protobuf::Any& message) override
+	{
+		_client->onMessage(message);
+		return true;
+	}
+
+	void drain() override
+	{
+		_client->onDisconnected();
+	}
+
+private:
+	RemoteClientGRPC* _client;
+};
+
 RemoteClientGRPC::RemoteClientGRPC(const ghost::ConnectionConfiguration& configuration,
 				   const std::shared_ptr<ghost::ThreadPool>& threadPool,
 				   const std::shared_ptr<IncomingRPC>& rpc, ServerGRPC* parentServer)
-    : ghost::Client(configuration), _threadPool(threadPool), _rpc(rpc), _parentServer(parentServer)
+    : ghost::Client(configuration)
+    , _threadPool(threadPool)
+    , _executing(false)
+    , _rpc(rpc)
+    , _disconnected(false)
+    , _parentServer(parentServer)
 {
 }
 
@@ -40,12 +72,13 @@ bool RemoteClientGRPC::stop()
 
 bool RemoteClientGRPC::isRunning() const
 {
-	return !_rpc->isFinished() ||
-	       _execution.valid() && _execution.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready;
+	// checked for every message sent by the publishers: the RPC state is read first, it is a single atomic load
+	return !_rpc->isFinished() || _executing;
 }
 
 void RemoteClientGRPC::execute()
 {
+	_executing = true;
 	_execution = _threadPool->execute([this] {
 		if (_parentServer->getClientHandler())
 			_parentServer->getClientHandler()->configureClient(_rpc->getParent());
@@ -66,6 +99,54 @@ void RemoteClientGRPC::execute()
 
 		// if continueExecution is false, stop the server
 		if (!continueExecution) _parentServer->shutdown();
+		_executing = false;
+	});
+}
+
+void RemoteClientGRPC::executeAsync(const std::shared_ptr<ghost::AsyncClientHandlerGRPC>& handler)
+{
+	// called from the completion queue thread that connected the client
+	_asyncHandler = handler;
+	auto self = _rpc->getParent();
+
+	_asyncHandler->configureClient(self);
+	_asyncHandler->onConnected(self);
+
+	_rpc->startReader(std::make_shared<HandlerReaderSink>(this));
+	_rpc->startWriter(getWriterSink());
+}
+
+void RemoteClientGRPC::onMessage(const google::protobuf::Any& message)
+{
+	auto self = _rpc->getParent();
+	if (!self) return;
+
+	_asyncHandler->onMessage(self, message);
+	// the answers written by the handler are sent without waiting for the periodic writer task
+	_rpc->flushWriter();
+}
+
+void RemoteClientGRPC::onDisconnected()
+{
+	// the RPC is drained when it becomes inactive, and again when it is finished
+	if (_disconnected.exchange(true)) return;
+
+	if (!_rpc->getParent()) return;
+
+	// stopping the RPC waits for its pending operations, which cannot be done from a completion queue thread.
+	// The stored task must not hold the client: the client manager keeps it while it is executing, and deletes
+	// it once the handler was notified.
+	_executing = true;
+	_execution = _threadPool->execute([this] {
+		{
+			auto self = _rpc->getParent();
+			if (self)
+			{
+				shutdown();
+				_asyncHandler->onDisconnected(self);
+			}
+		}
+		_executing = false;
 	});
 }
 
@@ -17,7 +17,9 @@
 #ifndef GHOST_INTERNAL_NETWORK_REMOTECLIENTGRPC_HPP
 #define GHOST_INTERNAL_NETWORK_REMOTECLIENTGRPC_HPP
 
+#include <atomic>
 #include <ghost/connection/Client.hpp>
+#include <ghost/connection_grpc/AsyncClientHandlerGRPC.hpp>
 #include <ghost/module/ThreadPool.hpp>
 #include <memory>
 
@@ -41,6 +43,8 @@ public:
 	bool isRunning() const override;
 
 	void execute();
+	/// Hands the client over to the given message-driven handler instead of executing it on the thread pool.
+	void executeAsync(const std::shared_ptr<ghost::AsyncClientHandlerGRPC>& handler);
 	void shutdown();
 
 	std::shared_ptr<ghost::ReaderSink> getReaderSink() const;
@@ -48,10 +52,20 @@ public:
 	const std::shared_ptr<IncomingRPC> getRPC() const;
 
 private:
+	class HandlerReaderSink;
+
+	void onMessage(const google::protobuf::Any& message);
+	void onDisconnected();
+
 	std::shared_ptr<ghost::ThreadPool> _threadPool;
+	// the handler task of a synchronous client, or the disconnection task of an asynchronous one
 	std::future<void> _execution;
+	std::atomic_bool _executing;
 	std::shared_ptr<IncomingRPC> _rpc;
 
+	std::shared_ptr<ghost::AsyncClientHandlerGRPC> _asyncHandler;
+	std::atomic_bool _disconnected;
+
 	ServerGRPC* _parentServer;
 };
 } // namespace internal
@@ -20,25 +20,43 @@
 #include <grpcpp/server.h>
 #include <grpcpp/server_builder.h>
 
+#include <algorithm>
+
+#include "ChannelArgumentsGRPC.hpp"
 #include "RemoteClientGRPC.hpp"
 #include "rpc/IncomingRPC.hpp"
 
 using namespace ghost::internal;
 
+const std::chrono::milliseconds ServerGRPC::ACCEPT_RATE_WINDOW = std::chrono::milliseconds(100);
+
 ServerGRPC::ServerGRPC(const ghost::ConnectionConfiguration& config,
 		       const std::shared_ptr<ghost::ThreadPool>& threadPool)
-    : ServerGRPC(ghost::NetworkConnectionConfiguration::initializeFrom(config), threadPool)
+    : ServerGRPC(ghost::ConnectionConfigurationGRPC::initializeFrom(config), threadPool)
 {
 }
 
-ServerGRPC::ServerGRPC(const ghost::NetworkConnectionConfiguration& config,
+ServerGRPC::ServerGRPC(const ghost::ConnectionConfigurationGRPC& config,
 		       const std::shared_ptr<ghost::ThreadPool>& threadPool)
     : _threadPool(threadPool)
     , _configuration(config)
+    , _streamSettings(StreamSettings::create(config))
     , _running(false)
-    , _completionQueueExecutor(threadPool)
+    , _shuttingDown(false)
     , _clientManager(threadPool)
+    , _acceptPoolMinSize(config.getAcceptPoolMinSize() > 0 ? config.getAcceptPoolMinSize()
+							     : config.getThreadPoolSize())
+    , _acceptPoolMaxSize(std::max(_acceptPoolMinSize, config.getAcceptPoolMaxSize()))
+    , _acceptsInWindow(0)
+    , _postedAccepts(0)
+    , _nextAcceptShard(0)
 {
+	// the remote clients only use the settings of the base configuration
+	_clientConfiguration.setOperationBlocking(config.isOperationBlocking());
+	_clientConfiguration.setThreadPoolSize(config.getThreadPoolSize());
+
+	for (size_t i = 0; i < config.getServerShards(); ++i)
+		_completionQueueExecutors.emplace_back(new CompletionQueueExecutor(threadPool));
 }
 
 bool ServerGRPC::start()
@@ -46,6 +64,7 @@ bool ServerGRPC::start()
 	if (_running) return false;
 
 	_running = true;
+	_shuttingDown = false;
 
 	std::string serverAddress =
 	    _configuration.getServerIpAddress() + ":" + std::to_string(_configuration.getServerPortNumber());
@@ -55,6 +74,9 @@ bool ServerGRPC::start()
 	// Prevents two servers from using the same port.
 	builder.AddChannelArgument(GRPC_ARG_ALLOW_REUSEPORT, 0);
 
+	// Keepalive, message sizes and HTTP/2 settings of the configuration.
+	ChannelArgumentsGRPC::applyTo(_configuration, builder);
+
 	// Listen on the given address without any authentication mechanism.
 	builder.AddListeningPort(serverAddress, ::grpc::InsecureServerCredentials());
 
@@ -62,9 +84,9 @@ bool ServerGRPC::start()
 	// clients. In this case it corresponds to an *asynchronous* service.
 	builder.RegisterService(&_service);
 
-	// Get hold of the completion queue used for the asynchronous communication
-	// with the gRPC runtime.
-	_completionQueueExecutor.setCompletionQueue(builder.AddCompletionQueue());
+	// Get hold of the completion queues used for the asynchronous communication
+	// with the gRPC runtime, one per shard.
+	for (auto& executor : _completionQueueExecutors) executor->setCompletionQueue(builder.AddCompletionQueue());
 
 	// Finally assemble the server.
 	_grpcServer = builder.BuildAndStart();
@@ -74,21 +96,28 @@ bool ServerGRPC::start()
 		return false; // Starting the server failed
 	}
 
-	_completionQueueExecutor.start(_configuration.getThreadPoolSize());
-
-	auto callback = std::bind(&ServerGRPC::onClientConnected, this, std::placeholders::_1);
+	// the threads of the configuration are divided between the shards
+	size_t shards = _completionQueueExecutors.size();
+	size_t threadsPerShard = std::max<size_t>(1, (_configuration.getThreadPoolSize() + shards - 1) / shards);
+	for (auto& executor : _completionQueueExecutors) executor->start(threadsPerShard);
 
-	auto cq = static_cast<grpc::ServerCompletionQueue*>(_completionQueueExecutor.getCompletionQueue());
-	for (size_t i = 0; i < _configuration.getThreadPoolSize();
-	     i++) // start as many calls as there can be concurrent rpcs
 	{
-		// Spawn a new CallData instance to serve new clients
-		auto client = std::make_shared<RemoteClientGRPC>(
-		    _configuration, _threadPool, std::make_shared<IncomingRPC>(&_service, cq, _threadPool, callback),
-		    this);
-		client->getRPC()->setParent(client);
-		_clientManager.addClient(client);
+		std::lock_guard<std::mutex> lock(_acceptMutex);
+		_acceptStatistics = AcceptStatistics();
+		_acceptStatistics.target = _acceptPoolMinSize;
+		_acceptStatistics.outstanding = _acceptPoolMinSize;
+		_postedAccepts = 0;
+		_nextAcceptShard = 0;
+		_lastAccept = std::chrono::steady_clock::now();
+		_acceptWindowStart = _lastAccept;
+		_acceptsInWindow = 0;
 	}
+	postAccepts(_acceptPoolMinSize);
+
+	_acceptPoolExecutor = _threadPool->makeScheduledExecutor();
+	_acceptPoolExecutor->scheduleAtFixedRate(std::bind(&ServerGRPC::shrinkAcceptPool, this),
+						 std::chrono::seconds(1));
+
 	_clientManager.start();
 
 	return true;
@@ -118,20 +147,37 @@ bool ServerGRPC::isShutdown() const
 	return !_grpcServer;
 }
 
+size_t ServerGRPC::countClients() const
+{
+	return _clientManager.countClients();
+}
+
+ServerGRPC::AcceptStatistics ServerGRPC::getAcceptStatistics() const
+{
+	std::lock_guard<std::mutex> lock(_acceptMutex);
+	auto statistics = _acceptStatistics;
+	// include the current starvation
+	if (_postedAccepts == 0 && statistics.accepted > 0)
+		statistics.starvedTime += std::chrono::duration_cast<std::chrono::microseconds>(
+		    std::chrono::steady_clock::now() - _starvedSince);
+	return statistics;
+}
+
 void ServerGRPC::shutdown()
 {
-	// Tell the clients to shutdown their RPCs
+	if (_acceptPoolExecutor) _acceptPoolExecutor->stop();
+
+	// the clients connecting from now on are finished right away, see "onClientConnected"
+	_shuttingDown = true;
+
+	// Tell the clients to shutdown their RPCs, this waits until they are finished
 	_clientManager.shutdownClients();
 
-	// Shut down the grpc server - this will wait until current RPCs are processed
-	if (_grpcServer)
-	{
-		auto deadline = std::chrono::system_clock::now() + std::chrono::milliseconds(100);
-		_grpcServer->Shutdown(deadline);
-	}
+	// Shut down the grpc server - the RPCs are finished, it only cancels the pending connection requests
+	if (_grpcServer) _grpcServer->Shutdown();
 
-	// Stop the completion queue, finishing the remaining open operations
-	_completionQueueExecutor.stop();
+	// Stop the completion queues, finishing the remaining open operations
+	for (auto& executor : _completionQueueExecutors) executor->stop();
 
 	// Destroy the gRPC server
 	if (_grpcServer) _grpcServer.reset();
@@ -151,16 +197,91 @@ void ServerGRPC::onClientConnected(std::shared_ptr<RemoteClientGRPC> client)
 {
 	if (isRunning())
 	{
-		// restart the process of creating the request for the next client
-		auto cq = static_cast<grpc::ServerCompletionQueue*>(_completionQueueExecutor.getCompletionQueue());
-		auto callback = std::bind(&ServerGRPC::onClientConnected, this, std::placeholders::_1);
-		auto newClient = std::make_shared<RemoteClientGRPC>(
-		    _configuration, _threadPool, std::make_shared<IncomingRPC>(&_service, cq, _threadPool, callback),
-		    this);
-		newClient->getRPC()->setParent(newClient);
-		_clientManager.addClient(newClient);
+		size_t newRequests = 0;
+		{
+			std::lock_guard<std::mutex> lock(_acceptMutex);
+			auto now = std::chrono::steady_clock::now();
+			_acceptStatistics.accepted++;
+			_acceptStatistics.outstanding--;
+			_postedAccepts--;
+			_lastAccept = now;
+			if (_postedAccepts == 0)
+			{
+				_acceptStatistics.starvations++;
+				_starvedSince = now;
+			}
+
+			// The pool follows the accept rate: it doubles when more connections than its size were
+			// accepted within the rate window, or when it was emptied
+			if (now - _acceptWindowStart > ACCEPT_RATE_WINDOW)
+			{
+				_acceptWindowStart = now;
+				_acceptsInWindow = 0;
+			}
+			_acceptsInWindow++;
+			if (_acceptsInWindow > _acceptStatistics.target || _acceptStatistics.outstanding == 0)
+				_acceptStatistics.target = std::min(_acceptStatistics.target * 2, _acceptPoolMaxSize);
+
+			// restart the process of creating requests for the next clients. While the pool is above its
+			// target, the consumed request is retired instead: posted requests cannot be cancelled
+			if (_acceptStatistics.outstanding < _acceptStatistics.target)
+				newRequests = _acceptStatistics.target - _acceptStatistics.outstanding;
+			else
+				_acceptStatistics.retired++;
+			_acceptStatistics.outstanding += newRequests;
+		}
+		postAccepts(newRequests);
+	}
+
+	// a client connecting while the server shuts down is not handled, it would delay the shutdown
+	if (_shuttingDown)
+	{
+		client->getRPC()->requestStop();
+		return;
+	}
+
+	// Message-driven handlers are called by the completion queue, the others are executed in a separate thread
+	auto asyncHandler = std::dynamic_pointer_cast<ghost::AsyncClientHandlerGRPC>(getClientHandler());
+	if (asyncHandler)
+		client->executeAsync(asyncHandler);
+	else
+		client->execute();
+}
+
+void ServerGRPC::postAccepts(size_t count)
+{
+	auto callback = std::bind(&ServerGRPC::onClientConnected, this, std::placeholders::_1);
+	for (size_t i = 0; i < count; i++)
+	{
+		grpc::ServerCompletionQueue* cq;
+		{
+			// counted before it is posted, since it can be consumed right away
+			std::lock_guard<std::mutex> lock(_acceptMutex);
+			// the connections arriving while no request was posted waited in the accept queue of gRPC
+			if (_postedAccepts == 0 && _acceptStatistics.accepted > 0)
+				_acceptStatistics.starvedTime += std::chrono::duration_cast<std::chrono::microseconds>(
+				    std::chrono::steady_clock::now() - _starvedSince);
+			_postedAccepts++;
+
+			cq = static_cast<grpc::ServerCompletionQueue*>(
+			    _completionQueueExecutors[_nextAcceptShard]->getCompletionQueue());
+			_nextAcceptShard = (_nextAcceptShard + 1) % _completionQueueExecutors.size();
+		}
+
+		// Spawn a new CallData instance to serve new clients
+		auto client = std::make_shared<RemoteClientGRPC>(
+		    _clientConfiguration, _threadPool,
+		    std::make_shared<IncomingRPC>(&_service, cq, _threadPool, _streamSettings, callback), this);
+		client->getRPC()->setParent(client);
+		_clientManager.addClient(client);
 	}
+}
+
+void ServerGRPC::shrinkAcceptPool()
+{
+	std::lock_guard<std::mutex> lock(_acceptMutex);
+	if (std::chrono::steady_clock::now() - _lastAccept < std::chrono::seconds(1)) return;
 
-	// Execute the application's code in a separate thread
-	client->execute();
+	// the requests above the new target are retired as they are consumed, see "onClientConnected"
+	_acceptStatistics.target = std::max(_acceptStatistics.target / 2, _acceptPoolMinSize);
 }
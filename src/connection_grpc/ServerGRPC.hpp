@@ -22,13 +22,18 @@
 #include <grpcpp/server.h>
 
 #include <atomic>
-#include <ghost/connection/NetworkConnectionConfiguration.hpp>
+#include <chrono>
 #include <ghost/connection/Server.hpp>
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
+#include <ghost/connection_grpc/ConnectionControlGRPC.hpp>
 #include <ghost/module/ThreadPool.hpp>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include "ClientManager.hpp"
 #include "CompletionQueueExecutor.hpp"
+#include "rpc/StreamSettings.hpp"
 
 namespace ghost
 {
@@ -39,18 +44,31 @@ class IncomingRPC;
 /**
  * Server implementation using the gRPC library. Runs a gRPC server which accepts connections, and create
  * a writing/sending interface which is returned to the server object.
+ *
+ * Connections are accepted by a pool of posted requests (ghost::internal::IncomingRPC). The pool doubles when
+ * more connections than its size are accepted within 100 ms, or when it gets empty, up to the maximum size of the
+ * configuration. Its target is halved every second without accepted connections, down to the minimum size. gRPC
+ * cannot cancel a posted request: the requests above the target are retired when they are consumed, by not
+ * replacing them.
+ *
+ * The server has one completion queue per shard (see ghost::ConnectionConfigurationGRPC::setServerShards), each
+ * processed by its own threads. The connection requests are posted on the shards in turn.
  */
 class ServerGRPC : public ghost::Server
 {
 public:
+	using AcceptStatistics = ghost::ConnectionControlGRPC::AcceptStatistics;
+
 	ServerGRPC(const ghost::ConnectionConfiguration& config, const std::shared_ptr<ghost::ThreadPool>& threadPool);
-	ServerGRPC(const ghost::NetworkConnectionConfiguration& config,
+	ServerGRPC(const ghost::ConnectionConfigurationGRPC& config,
 		   const std::shared_ptr<ghost::ThreadPool>& threadPool);
 
 	bool start() override;
 	bool stop() override;
 	bool isRunning() const override;
 	bool isShutdown() const;
+	size_t countClients() const;
+	AcceptStatistics getAcceptStatistics() const;
 
 	void shutdown();
 	void setClientHandler(std::shared_ptr<ClientHandler> handler) override;
@@ -58,17 +76,42 @@ public:
 
 private:
 	void onClientConnected(std::shared_ptr<RemoteClientGRPC> client);
+	/// Posts "count" new connection requests.
+	void postAccepts(size_t count);
+	/// Shrinks the pool of connection requests if no connection was accepted recently.
+	void shrinkAcceptPool();
+
+	static const std::chrono::milliseconds ACCEPT_RATE_WINDOW;
 
 	std::shared_ptr<ghost::ThreadPool> _threadPool;
-	ghost::NetworkConnectionConfiguration _configuration;
+	ghost::ConnectionConfigurationGRPC _configuration;
+	// shared by the connections, which do not hold a copy of the whole configuration
+	ghost::ConnectionConfiguration _clientConfiguration;
+	std::shared_ptr<const StreamSettings> _streamSettings;
 	std::atomic<bool> _running;
+	std::atomic<bool> _shuttingDown;
 
-	ghost::protobuf::connectiongrpc::ServerClientService::AsyncService _service;
+	// raw service: the connections exchange serialized messages, see ghost::internal::IncomingRPC
+	ghost::protobuf::connectiongrpc::ServerClientService::WithRawMethod_connect<
+	    ghost::protobuf::connectiongrpc::ServerClientService::Service>
+	    _service;
 	std::unique_ptr<grpc::Server> _grpcServer;
-	CompletionQueueExecutor _completionQueueExecutor;
+	std::vector<std::unique_ptr<CompletionQueueExecutor>> _completionQueueExecutors;
 
 	ClientManager _clientManager;
 	std::shared_ptr<ClientHandler> _clientHandler;
+
+	mutable std::mutex _acceptMutex;
+	size_t _acceptPoolMinSize;
+	size_t _acceptPoolMaxSize;
+	AcceptStatistics _acceptStatistics;
+	std::chrono::steady_clock::time_point _lastAccept;
+	std::chrono::steady_clock::time_point _acceptWindowStart;
+	size_t _acceptsInWindow;
+	size_t _postedAccepts;
+	size_t _nextAcceptShard;
+	std::chrono::steady_clock::time_point _starvedSince;
+	std::shared_ptr<ghost::ScheduledExecutor> _acceptPoolExecutor;
 };
 } // namespace internal
 } // namespace ghost
@@ -20,29 +20,69 @@ using namespace ghost::internal;
 
 SubscriberGRPC::SubscriberGRPC(const ghost::ConnectionConfiguration& config,
 			       const std::shared_ptr<ghost::ThreadPool>& threadPool)
-    : SubscriberGRPC(ghost::NetworkConnectionConfiguration::initializeFrom(config), threadPool)
+    : SubscriberGRPC(ghost::ConnectionConfigurationGRPC::initializeFrom(config), threadPool)
 {
 }
 
-SubscriberGRPC::SubscriberGRPC(const ghost::NetworkConnectionConfiguration& config,
+SubscriberGRPC::SubscriberGRPC(const ghost::ConnectionConfigurationGRPC& config,
 			       const std::shared_ptr<ghost::ThreadPool>& threadPool)
-    : ghost::Subscriber(config)
-    , _client(threadPool, config.getServerIpAddress(), config.getServerPortNumber(), config.getThreadPoolSize())
+    : ghost::Subscriber(config), _threadPool(threadPool), _client(threadPool, config)
 {
 	_client.setReaderSink(getReaderSink());
 }
 
 bool SubscriberGRPC::start()
 {
+	if (_managedReaderSink) _managedReaderSink->start();
 	return _client.start();
 }
 
+std::shared_future<bool> SubscriberGRPC::startAsync(const std::function<void(bool)>& callback)
+{
+	if (_managedReaderSink) _managedReaderSink->start();
+	return _client.startAsync(callback);
+}
+
 bool SubscriberGRPC::stop()
 {
-	return _client.stop();
+	bool stopResult = _client.stop();
+	// the messages that were received before the end of the connection are still delivered
+	if (_managedReaderSink) _managedReaderSink->stop();
+	return stopResult;
 }
 
 bool SubscriberGRPC::isRunning() const
 {
 	return _client.isRunning();
 }
+
+OutgoingRPC::ReconnectStatistics SubscriberGRPC::getReconnectStatistics() const
+{
+	return _client.getReconnectStatistics();
+}
+
+SequenceChecker::Statistics SubscriberGRPC::getSequenceStatistics() const
+{
+	return _client.getSequenceStatistics();
+}
+
+void SubscriberGRPC::setRawReaderHandler(const OutgoingRPC::RawReaderHandler& handler)
+{
+	_client.setRawReaderHandler(handler);
+}
+
+void SubscriberGRPC::resumeReader()
+{
+	_client.resumeReader();
+}
+
+void SubscriberGRPC::setManagedReaderSink(const std::shared_ptr<ManagedReaderSink>& sink)
+{
+	_managedReaderSink = sink;
+	_client.setReaderSink(sink);
+}
+
+const std::shared_ptr<ghost::ThreadPool>& SubscriberGRPC::getThreadPool() const
+{
+	return _threadPool;
+}
@@ -17,10 +17,11 @@
 #ifndef GHOST_INTERNAL_NETWORK_SUBSCRIBERGRPC_HPP
 #define GHOST_INTERNAL_NETWORK_SUBSCRIBERGRPC_HPP
 
-#include <ghost/connection/NetworkConnectionConfiguration.hpp>
 #include <ghost/connection/Subscriber.hpp>
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
 #include <ghost/module/ThreadPool.hpp>
 
+#include "ManagedReaderSink.hpp"
 #include "rpc/OutgoingRPC.hpp"
 
 namespace ghost
@@ -36,15 +37,33 @@ class SubscriberGRPC : public ghost::Subscriber
 public:
 	SubscriberGRPC(const ghost::ConnectionConfiguration& config,
 		       const std::shared_ptr<ghost::ThreadPool>& threadPool);
-	SubscriberGRPC(const ghost::NetworkConnectionConfiguration& config,
+	SubscriberGRPC(const ghost::ConnectionConfigurationGRPC& config,
 		       const std::shared_ptr<ghost::ThreadPool>& threadPool);
 
 	bool start() override;
+	/// Connects without blocking, see ghost::internal::OutgoingRPC::startAsync.
+	std::shared_future<bool> startAsync(const std::function<void(bool)>& callback = {});
 	bool stop() override;
 	bool isRunning() const override;
 
+	/// Metrics of the automatic reconnection, see ghost::ConnectionConfigurationGRPC::setReconnectEnabled.
+	OutgoingRPC::ReconnectStatistics getReconnectStatistics() const;
+	/// Metrics of the received sequence numbers, see ghost::ConnectionConfigurationGRPC::setSequenceNumbersEnabled.
+	SequenceChecker::Statistics getSequenceStatistics() const;
+	/// Passes the received messages to "handler" without parsing them, instead of the readers of this
+	/// subscriber (see ghost::internal::RelayGRPC). Must be called before "start".
+	void setRawReaderHandler(const OutgoingRPC::RawReaderHandler& handler);
+	/// Restarts the reads that the raw reader handler paused.
+	void resumeReader();
+	/// Passes the received messages to "sink" instead of the readers of this subscriber, see
+	/// ghost::BatchHandlerGRPC and ghost::KeyedHandlerGRPC. Must be called before "start".
+	void setManagedReaderSink(const std::shared_ptr<ManagedReaderSink>& sink);
+	const std::shared_ptr<ghost::ThreadPool>& getThreadPool() const;
+
 private:
+	std::shared_ptr<ghost::ThreadPool> _threadPool;
 	OutgoingRPC _client;
+	std::shared_ptr<ManagedReaderSink> _managedReaderSink;
 };
 } // namespace internal
 } // namespace ghost
@@ -20,13 +20,13 @@
 
 using namespace ghost::internal;
 
-IncomingRPC::IncomingRPC(ghost::protobuf::connectiongrpc::ServerClientService::AsyncService* service,
-			 grpc::ServerCompletionQueue* completionQueue,
+IncomingRPC::IncomingRPC(ServiceType* service, grpc::ServerCompletionQueue* completionQueue,
 			 const std::shared_ptr<ghost::ThreadPool>& threadPool,
+			 const std::shared_ptr<const StreamSettings>& streamSettings,
 			 const std::function<void(std::shared_ptr<RemoteClientGRPC>)>& clientConnectedCallback)
-    : WriterRPC(threadPool)
+    : ReaderRPC(streamSettings)
+    , WriterRPC(threadPool, streamSettings)
     , _serverCallback(clientConnectedCallback)
-    , _threadPool(threadPool)
     , _rpc(std::make_shared<RPC<ReaderWriter, ContextType>>(threadPool))
     , _requestOperation(std::make_shared<RPCRequest<ReaderWriter, ContextType, ServiceType>>(
 	  _rpc, service, completionQueue, completionQueue))
@@ -35,8 +35,7 @@ IncomingRPC::IncomingRPC(ghost::protobuf::connectiongrpc::ServerClientService::A
 	auto rpcCallback = std::bind(&IncomingRPC::onRPCConnected, this);
 	_requestOperation->setConnectionCallback(rpcCallback);
 
-	_rpc->setClient(std::make_unique<grpc::ServerAsyncReaderWriter<google::protobuf::Any, google::protobuf::Any>>(
-	    _rpc->getContext().get()));
+	_rpc->setClient(std::make_unique<ReaderWriter>(_rpc->getContext().get()));
 	_rpc->getStateMachine().setStateChangedCallback(
 	    std::bind(&IncomingRPC::onRPCStateChanged, this, std::placeholders::_1));
 
@@ -60,6 +59,15 @@ bool IncomingRPC::start()
 }
 
 bool IncomingRPC::stop(const grpc::Status& status)
+{
+	if (!requestStop(status)) return false;
+
+	dispose();
+
+	return true;
+}
+
+bool IncomingRPC::requestStop(const grpc::Status& status)
 {
 	if (!_rpc->dispose()) return false;
 
@@ -70,8 +78,6 @@ bool IncomingRPC::stop(const grpc::Status& status)
 		_finishOperation->start();
 	}
 
-	dispose();
-
 	return true;
 }
 
@@ -104,6 +110,17 @@ std::shared_ptr<RemoteClientGRPC> IncomingRPC::getParent()
 	return _parent.lock();
 }
 
+void IncomingRPC::setFinishedCallback(const std::function<void()>& callback)
+{
+	{
+		std::lock_guard<std::mutex> lock(_finishedCallbackMutex);
+		_finishedCallback = callback;
+	}
+
+	// the RPC may have finished before the callback was set
+	if (callback && _rpc->getStateMachine().getState() == RPCStateMachine::FINISHED) callback();
+}
+
 void IncomingRPC::onRPCConnected()
 {
 	auto parent = _parent.lock();
@@ -121,4 +138,14 @@ void IncomingRPC::onRPCStateChanged(RPCStateMachine::State newState)
 		drainReader();
 		drainWriter();
 	}
+
+	if (newState == RPCStateMachine::FINISHED)
+	{
+		std::function<void()> callback;
+		{
+			std::lock_guard<std::mutex> lock(_finishedCallbackMutex);
+			callback = _finishedCallback;
+		}
+		if (callback) callback();
+	}
 }
@@ -22,6 +22,7 @@
 #include <ghost/connection/WriterSink.hpp>
 #include <ghost/module/ThreadPool.hpp>
 #include <memory>
+#include <mutex>
 
 #include "RPC.hpp"
 #include "RPCDone.hpp"
@@ -39,24 +40,30 @@ class RemoteClientGRPC;
 /**
  *	Manages gRPC calls for an incoming connection (a client connection to this server).
  *	This object is created by ghost::internal::ServerGRPC (and therefore also by ghost::internal::PublisherGRPC).
+ *	The method is served in raw mode: the stream carries the serialized messages (grpc::ByteBuffer), which lets
+ *	publishers serialize a message once for all their subscribers.
+ *	The settings of the stream are shared by all the incoming RPCs of a server.
  */
 class IncomingRPC
-    : public ReaderRPC<grpc::ServerAsyncReaderWriter<google::protobuf::Any, google::protobuf::Any>,
-		       grpc::ServerContext>,
-      public WriterRPC<grpc::ServerAsyncReaderWriter<google::protobuf::Any, google::protobuf::Any>, grpc::ServerContext>
+    : public ReaderRPC<grpc::ServerAsyncReaderWriter<grpc::ByteBuffer, grpc::ByteBuffer>, grpc::ServerContext>,
+      public WriterRPC<grpc::ServerAsyncReaderWriter<grpc::ByteBuffer, grpc::ByteBuffer>, grpc::ServerContext>
 {
 public:
-	using ReaderWriter = grpc::ServerAsyncReaderWriter<google::protobuf::Any, google::protobuf::Any>;
+	using ReaderWriter = grpc::ServerAsyncReaderWriter<grpc::ByteBuffer, grpc::ByteBuffer>;
 	using ContextType = grpc::ServerContext;
-	using ServiceType = ghost::protobuf::connectiongrpc::ServerClientService::AsyncService;
+	using ServiceType = ghost::protobuf::connectiongrpc::ServerClientService::WithRawMethod_connect<
+	    ghost::protobuf::connectiongrpc::ServerClientService::Service>;
 
-	IncomingRPC(ghost::protobuf::connectiongrpc::ServerClientService::AsyncService* service,
-		    grpc::ServerCompletionQueue* completionQueue, const std::shared_ptr<ghost::ThreadPool>& threadPool,
+	IncomingRPC(ServiceType* service, grpc::ServerCompletionQueue* completionQueue,
+		    const std::shared_ptr<ghost::ThreadPool>& threadPool,
+		    const std::shared_ptr<const StreamSettings>& streamSettings,
 		    const std::function<void(std::shared_ptr<RemoteClientGRPC>)>& clientConnectedCallback);
 	~IncomingRPC();
 
 	bool start();
 	bool stop(const grpc::Status& status = grpc::Status::OK);
+	/// Starts finishing the RPC without waiting for it, "dispose" waits. @return false if it was not active.
+	bool requestStop(const grpc::Status& status = grpc::Status::OK);
 
 	void dispose();
 
@@ -64,18 +71,21 @@ public:
 
 	void setParent(std::weak_ptr<RemoteClientGRPC> parent);
 	std::shared_ptr<RemoteClientGRPC> getParent();
+	/// Sets a callback called once the RPC reached the state FINISHED, or right away if it already did.
+	void setFinishedCallback(const std::function<void()>& callback);
 
 private:
 	void onRPCConnected();
 	void onRPCStateChanged(RPCStateMachine::State newState);
 	std::function<void(std::shared_ptr<RemoteClientGRPC>)> _serverCallback;
 
-	std::shared_ptr<ghost::ThreadPool> _threadPool;
 	std::weak_ptr<RemoteClientGRPC> _parent;
 	std::shared_ptr<RPC<ReaderWriter, ContextType>> _rpc;
 	std::shared_ptr<RPCRequest<ReaderWriter, ContextType, ServiceType>> _requestOperation;
 	std::shared_ptr<RPCServerFinish<ReaderWriter, ContextType>> _finishOperation;
 	std::shared_ptr<RPCDone<ReaderWriter, ContextType>> _doneOperation;
+	std::mutex _finishedCallbackMutex;
+	std::function<void()> _finishedCallback;
 };
 } // namespace internal
 } // namespace ghost
@@ -21,70 +21,157 @@
 #include <grpcpp/create_channel.h>
 #include <grpcpp/security/credentials.h>
 
-#include "RPCConnect.hpp"
+#include <algorithm>
+#include <random>
+
+#include "../ChannelArgumentsGRPC.hpp"
 #include "RPCFinish.hpp"
 
 using namespace ghost::internal;
 
-OutgoingRPC::OutgoingRPC(const std::shared_ptr<ghost::ThreadPool>& threadPool, const std::string& serverIp,
-			 int serverPort, size_t dedicatedThreads)
-    : WriterRPC(threadPool)
+namespace
+{
+std::vector<std::string> getEndpoints(const ghost::ConnectionConfigurationGRPC& configuration)
+{
+	auto endpoints = configuration.getServerEndpoints();
+	if (endpoints.empty())
+		endpoints.push_back(configuration.getServerIpAddress() + ":" +
+				    std::to_string(configuration.getServerPortNumber()));
+	return endpoints;
+}
+} // namespace
+
+OutgoingRPC::OutgoingRPC(const std::shared_ptr<ghost::ThreadPool>& threadPool,
+			 const ghost::ConnectionConfigurationGRPC& configuration)
+    : OutgoingRPC(threadPool, configuration, StreamSettings::create(configuration))
+{
+}
+
+OutgoingRPC::OutgoingRPC(const std::shared_ptr<ghost::ThreadPool>& threadPool,
+			 const ghost::ConnectionConfigurationGRPC& configuration,
+			 const std::shared_ptr<const StreamSettings>& streamSettings)
+    : ReaderRPC(streamSettings)
+    , WriterRPC(threadPool, streamSettings)
     , _threadPool(threadPool)
-    , _completionQueue(new grpc::CompletionQueue()) // Will be owned by the executor
-    , _serverIp(serverIp)
-    , _serverPort(serverPort)
-    , _rpc(std::make_shared<RPC<ReaderWriter, ContextType>>(threadPool))
-    , _executor(_completionQueue, _threadPool) // now owns the completion queue
+    , _executor(CompletionQueueExecutor::getClientExecutor(threadPool, configuration.getThreadPoolSize()))
+    , _channelArguments(ChannelArgumentsGRPC::makeClientArguments(configuration))
+    , _balancer(EndpointBalancer::get(getEndpoints(configuration), configuration.getLoadBalancingPolicy()))
+    , _endpoint(0)
+    , _endpointPlaced(false)
+    , _rpc(makeRPC())
+    , _reconnectEnabled(configuration.isReconnectEnabled())
+    , _initialBackoff(std::max(configuration.getReconnectInitialBackoff(), std::chrono::milliseconds(1)))
+    , _maxBackoff(std::max(configuration.getReconnectMaxBackoff(), _initialBackoff))
+    , _connected(false)
+    , _stopping(false)
+    , _reconnecting(false)
 {
-	_rpc->getStateMachine().setStateChangedCallback(
-	    std::bind(&OutgoingRPC::onRPCStateChanged, this, std::placeholders::_1));
-	_executor.start(dedicatedThreads);
 }
 
 OutgoingRPC::~OutgoingRPC()
 {
+	// the completion of a pending connection uses this object
+	if (_connectResult.valid()) _connectResult.wait();
+	stopReconnection();
+
 	dispose();
 }
 
-/**
- *	Blocks until the client is connected thanks to the condition variable.
- */
 bool OutgoingRPC::start()
 {
-	if (!_rpc->initialize()) return false;
+	// Unlike "startAsync", the connection is completed by this thread. It only waits for the completion queue,
+	// whose threads do not belong to the thread pool: this can be called by a thread of the pool.
+	auto finished = std::make_shared<std::promise<void>>();
+	if (!startConnection([finished] { finished->set_value(); })) return false;
 
-	std::string serverAddress = _serverIp + ":" + std::to_string(_serverPort);
+	finished->get_future().wait();
+	return completeConnection({});
+}
 
-	auto channel = grpc::CreateChannel(serverAddress, grpc::InsecureChannelCredentials());
-	_stub = ghost::protobuf::connectiongrpc::ServerClientService::NewStub(channel);
+std::shared_future<bool> OutgoingRPC::startAsync(const std::function<void(bool)>& callback)
+{
+	// The promise is shared with the completion task so that it outlives the call to "set_value"
+	auto promise = std::make_shared<std::promise<bool>>();
+	_connectResult = promise->get_future().share();
 
-	// Connect and wait that the connection succeeds
-	RPCConnect<ReaderWriter, ContextType> connectOperation(_rpc, _stub, _completionQueue);
-	connectOperation.start();
-	while (connectOperation.isRunning()) _threadPool->yield(std::chrono::milliseconds(1));
+	bool started = startConnection([this, promise, callback] {
+		// This is called by a thread of the completion queue which cannot stop the RPC (it would wait for
+		// itself), the result is processed by the thread pool.
+		_connectCompletion = _threadPool->execute([this, promise, callback] {
+			bool connected = completeConnection(callback);
 
-	// If the connection failed, the RPC is not in state EXECUTING
-	if (_rpc->getStateMachine().getState() != RPCStateMachine::EXECUTING)
+			// last access to this object: the destructor waits for this result
+			promise->set_value(connected);
+		});
+	});
+
+	if (!started)
 	{
-		stop();
-		return false;
+		if (callback) callback(false);
+		promise->set_value(false);
 	}
 
-	// Start the reader
-	startReader();
-	startWriter();
+	return _connectResult;
+}
+
+bool OutgoingRPC::startConnection(const std::function<void()>& onFinish)
+{
+	auto rpc = getRPC();
+	if (!rpc->initialize()) return false;
+
+	placeStream(false);
+
+	// Connect, the result is processed when the operation completes
+	_connectOperation =
+	    std::make_shared<RPCConnect<ReaderWriter, ContextType>>(rpc, _stub, _executor->getCompletionQueue());
+	_connectOperation->onFinish(onFinish);
+	if (!_connectOperation->start()) onFinish();
 
 	return true;
 }
 
+bool OutgoingRPC::completeConnection(const std::function<void(bool)>& callback)
+{
+	// If the connection failed, the RPC is not in state EXECUTING
+	bool connected = getRPC()->getStateMachine().getState() == RPCStateMachine::EXECUTING;
+	if (!connected) connected = failover();
+	if (connected)
+	{
+		// From now on, a lost connection is reestablished (if enabled)
+		{
+			std::lock_guard<std::mutex> lock(_reconnectMutex);
+			_connected = true;
+		}
+
+		// Start the reader
+		startReader();
+		startWriter();
+	}
+	else
+		stop();
+
+	if (callback) callback(connected);
+	return connected;
+}
+
 bool OutgoingRPC::stop()
 {
-	if (!_rpc->dispose()) return false;
+	bool reconnectionInterrupted = stopReconnection();
+
+	auto rpc = getRPC();
+	if (!rpc->dispose())
+	{
+		if (!reconnectionInterrupted) return false;
+
+		// the interrupted reconnection left a finished RPC
+		dispose();
+		return true;
+	}
 
 	std::shared_ptr<RPCFinish<ReaderWriter, ContextType>> finishOperation;
-	if (_rpc->getStateMachine().getState() == RPCStateMachine::DISPOSING)
+	if (rpc->getStateMachine().getState() == RPCStateMachine::DISPOSING)
 	{
-		finishOperation = std::make_shared<RPCFinish<ReaderWriter, ContextType>>(_rpc);
+		finishOperation = std::make_shared<RPCFinish<ReaderWriter, ContextType>>(rpc);
 		finishOperation->start();
 	}
 
@@ -97,28 +184,68 @@ bool OutgoingRPC::stop()
 
 bool OutgoingRPC::isRunning() const
 {
-	return _rpc->getStateMachine().getState() == RPCStateMachine::INITIALIZING ||
-	       _rpc->getStateMachine().getState() == RPCStateMachine::EXECUTING ||
-	       _rpc->getStateMachine().getState() == RPCStateMachine::INACTIVE;
+	// the connection is considered running while it is reestablished
+	if (_reconnecting) return true;
+
+	auto state = getRPC()->getStateMachine().getState();
+	return state == RPCStateMachine::INITIALIZING || state == RPCStateMachine::EXECUTING ||
+	       state == RPCStateMachine::INACTIVE;
 }
 
 void OutgoingRPC::setWriterSink(const std::shared_ptr<ghost::WriterSink>& sink)
 {
-	initWriter(_rpc, sink);
+	initWriter(getRPC(), sink);
 }
 
 void OutgoingRPC::setReaderSink(const std::shared_ptr<ghost::ReaderSink>& sink)
 {
-	initReader(_rpc, sink);
+	initReader(getRPC(), sink);
+}
+
+void OutgoingRPC::setRawReaderHandler(const RawReaderHandler& handler)
+{
+	initRawReader(getRPC(), handler);
+}
+
+void OutgoingRPC::addDisconnectedCallback(const std::function<void()>& callback)
+{
+	std::lock_guard<std::mutex> lock(_disconnectedCallbacksMutex);
+	_disconnectedCallbacks.push_back(callback);
+}
+
+OutgoingRPC::ReconnectStatistics OutgoingRPC::getReconnectStatistics() const
+{
+	std::lock_guard<std::mutex> lock(_reconnectMutex);
+	return _reconnectStatistics;
+}
+
+std::string OutgoingRPC::getEndpoint() const
+{
+	std::lock_guard<std::mutex> lock(_endpointMutex);
+	return _balancer->getEndpoint(_endpoint);
 }
 
 void OutgoingRPC::onRPCStateChanged(RPCStateMachine::State newState)
 {
-	if (newState == RPCStateMachine::INACTIVE || newState == RPCStateMachine::FINISHED)
+	if (newState != RPCStateMachine::INACTIVE && newState != RPCStateMachine::FINISHED) return;
+
+	{
+		std::lock_guard<std::mutex> lock(_disconnectedCallbacksMutex);
+		for (const auto& callback : _disconnectedCallbacks) callback();
+	}
+
 	{
-		drainReader();
-		drainWriter();
+		std::lock_guard<std::mutex> lock(_reconnectMutex);
+		if (_reconnectEnabled && _connected && !_stopping)
+		{
+			// the pending messages are kept for the next connection
+			if (newState == RPCStateMachine::INACTIVE) scheduleReconnect();
+			return;
+		}
 	}
+
+	drainReader();
+	drainWriter();
 }
 
 void OutgoingRPC::dispose()
@@ -126,7 +253,195 @@ void OutgoingRPC::dispose()
 	stopReader();
 	stopWriter();
 
-	_rpc->awaitFinished();
-	_executor.stop();
-	_rpc->disposeGRPC();
+	auto rpc = getRPC();
+	rpc->awaitFinished();
+	rpc->disposeGRPC();
+
+	releaseStream();
+}
+
+std::shared_ptr<OutgoingRPC::RPCType> OutgoingRPC::getRPC() const
+{
+	std::lock_guard<std::mutex> lock(_rpcMutex);
+	return _rpc;
+}
+
+std::shared_ptr<OutgoingRPC::RPCType> OutgoingRPC::makeRPC()
+{
+	auto rpc = std::make_shared<RPCType>(_threadPool);
+	rpc->getStateMachine().setStateChangedCallback(
+	    std::bind(&OutgoingRPC::onRPCStateChanged, this, std::placeholders::_1));
+	return rpc;
+}
+
+void OutgoingRPC::placeStream(bool failover)
+{
+	std::lock_guard<std::mutex> lock(_endpointMutex);
+	size_t failed = EndpointBalancer::NONE;
+	if (_endpointPlaced)
+	{
+		if (failover) failed = _endpoint;
+		_balancer->release(_endpoint);
+	}
+	_endpoint = _balancer->acquire(failed);
+	_endpointPlaced = true;
+
+	auto channel = grpc::CreateCustomChannel(_balancer->getEndpoint(_endpoint), grpc::InsecureChannelCredentials(),
+						 _channelArguments);
+	_stub = std::make_shared<grpc::GenericStub>(channel);
+}
+
+void OutgoingRPC::releaseStream()
+{
+	std::lock_guard<std::mutex> lock(_endpointMutex);
+	if (_endpointPlaced) _balancer->release(_endpoint);
+	_endpointPlaced = false;
+}
+
+bool OutgoingRPC::failover()
+{
+	// the other endpoints are tried once each, like a reconnection but without waiting
+	for (size_t attempt = 1; attempt < _balancer->countEndpoints(); ++attempt)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_reconnectMutex);
+			if (_stopping) return false;
+		}
+
+		finish(getRPC());
+		placeStream(true);
+
+		auto rpc = makeRPC();
+		switchReader(rpc);
+		switchWriter(rpc);
+		{
+			std::lock_guard<std::mutex> lock(_rpcMutex);
+			_rpc = rpc;
+		}
+
+		if (connect(rpc)) return true;
+	}
+
+	return false;
+}
+
+void OutgoingRPC::scheduleReconnect()
+{
+	// called with _reconnectMutex locked, by the completion queue thread that noticed the lost connection
+	if (_reconnectStatistics.reconnecting) return;
+
+	_reconnectStatistics.reconnecting = true;
+	_reconnecting = true;
+	_outageStart = std::chrono::steady_clock::now();
+	_reconnection = _threadPool->execute(std::bind(&OutgoingRPC::reconnect, this));
+}
+
+void OutgoingRPC::reconnect()
+{
+	// The reader and the writer can only move to a new RPC once the operations of the lost one completed
+	finish(getRPC());
+
+	std::mt19937 generator(std::random_device{}());
+	auto backoff = _initialBackoff;
+	bool connected = false;
+	while (true)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_reconnectMutex);
+			if (_stopping) break;
+		}
+
+		// the lost endpoint, then each failed one, is avoided if the policy allows it
+		placeStream(true);
+
+		auto rpc = makeRPC();
+		switchReader(rpc);
+		switchWriter(rpc);
+		{
+			std::lock_guard<std::mutex> lock(_rpcMutex);
+			_rpc = rpc;
+		}
+
+		connected = connect(rpc);
+		if (connected) break;
+
+		finish(rpc);
+
+		// Wait before the next attempt. The delay is randomized so that the clients of a lost server do not
+		// reconnect all at once.
+		std::uniform_int_distribution<long long> jitter(backoff.count() / 2, backoff.count());
+		std::unique_lock<std::mutex> lock(_reconnectMutex);
+		_reconnectStatistics.failedAttempts++;
+		_reconnectCondition.wait_for(lock, std::chrono::milliseconds(jitter(generator)),
+					     [this] { return _stopping; });
+		backoff = std::min(backoff * 2, _maxBackoff);
+	}
+
+	// the writer restarts by itself with its periodic task
+	if (connected) startReader();
+
+	std::lock_guard<std::mutex> lock(_reconnectMutex);
+	if (connected)
+	{
+		auto outage = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+										    _outageStart);
+		_reconnectStatistics.reconnections++;
+		_reconnectStatistics.lastOutage = outage;
+		_reconnectStatistics.maxOutage = std::max(_reconnectStatistics.maxOutage, outage);
+		_reconnectStatistics.totalOutage += outage;
+	}
+	_reconnectStatistics.reconnecting = false;
+	_reconnecting = false;
+}
+
+bool OutgoingRPC::connect(const std::shared_ptr<RPCType>& rpc)
+{
+	if (!rpc->initialize()) return false;
+
+	// the completion queue threads do not belong to the thread pool, this thread can block until they report
+	auto completed = std::make_shared<bool>(false);
+	_reconnectOperation =
+	    std::make_shared<RPCConnect<ReaderWriter, ContextType>>(rpc, _stub, _executor->getCompletionQueue());
+	_reconnectOperation->onFinish([this, completed] {
+		{
+			std::lock_guard<std::mutex> lock(_reconnectMutex);
+			*completed = true;
+		}
+		_reconnectCondition.notify_all();
+	});
+	if (!_reconnectOperation->start()) return false;
+
+	{
+		std::unique_lock<std::mutex> lock(_reconnectMutex);
+		_reconnectCondition.wait(lock, [&completed] { return *completed; });
+	}
+
+	return rpc->getStateMachine().getState() == RPCStateMachine::EXECUTING;
+}
+
+void OutgoingRPC::finish(const std::shared_ptr<RPCType>& rpc)
+{
+	// an RPC that never connected has no stream to finish
+	if (!rpc->dispose()) return;
+
+	auto finishOperation = std::make_shared<RPCFinish<ReaderWriter, ContextType>>(rpc);
+	finishOperation->start();
+	rpc->awaitFinished();
+	rpc->disposeGRPC();
+}
+
+bool OutgoingRPC::stopReconnection()
+{
+	bool interrupted;
+	{
+		std::lock_guard<std::mutex> lock(_reconnectMutex);
+		_stopping = true;
+		interrupted = _reconnectStatistics.reconnecting;
+	}
+	_reconnectCondition.notify_all();
+
+	// the reconnection returns without waiting for its backoff, or right after its connection attempt
+	if (_reconnection.valid()) _reconnection.wait();
+
+	return interrupted;
 }
@@ -18,11 +18,24 @@
 #define GHOST_INTERNAL_NETWORK_OUTGOINGRPC_HPP
 
 #include <grpcpp/client_context.h>
+#include <grpcpp/generic/generic_stub.h>
+#include <grpcpp/support/channel_arguments.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
+#include <ghost/connection_grpc/ConnectionControlGRPC.hpp>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include "../CompletionQueueExecutor.hpp"
+#include "../EndpointBalancer.hpp"
 #include "RPC.hpp"
+#include "RPCConnect.hpp"
 #include "ReaderRPC.hpp"
 #include "WriterRPC.hpp"
 
@@ -37,41 +50,121 @@ namespace internal
  *	The method "setWriterSink" is called by ghost::internal::ClientGRPC.
  *	The method "setReaderSink" is called by ghost::internal::ClientGRPC and ghost::internal::SubscriberGRPC.
  *	If one of the aforementioned methods is not called, the corrsponding writer/reader is not started.
+ *
+ *	The connection can be established asynchronously with "startAsync", which allows many connections to be
+ *	dialed concurrently. "start" is the blocking variant.
+ *
+ *	If the reconnection is enabled in the configuration, a lost connection is not stopped: a new RPC is
+ *	connected with an exponential backoff, and the reader and the writer continue on it. The messages that were
+ *	not sent yet stay in the writer queue and in the writerSink until the connection is back.
+ *
+ *	The stream carries the serialized messages (grpc::ByteBuffer): they are parsed by the reader and serialized by
+ *	the writer queue, or forwarded as they are by relays with "setRawReaderHandler" and "writeRaw".
+ *
+ *	The stream is placed on one of the server endpoints of the configuration by a ghost::internal::EndpointBalancer.
+ *	If the endpoint cannot be reached, the other endpoints are tried once each before the connection fails, and
+ *	every reconnection places the stream again.
  */
-class OutgoingRPC
-    : public ReaderRPC<grpc::ClientAsyncReaderWriter<google::protobuf::Any, google::protobuf::Any>,
-		       grpc::ClientContext>,
-      public WriterRPC<grpc::ClientAsyncReaderWriter<google::protobuf::Any, google::protobuf::Any>, grpc::ClientContext>
+class OutgoingRPC : public ReaderRPC<grpc::GenericClientAsyncReaderWriter, grpc::ClientContext>,
+		    public WriterRPC<grpc::GenericClientAsyncReaderWriter, grpc::ClientContext>
 {
 public:
-	using ReaderWriter = grpc::ClientAsyncReaderWriter<google::protobuf::Any, google::protobuf::Any>;
+	using ReaderWriter = grpc::GenericClientAsyncReaderWriter;
 	using ContextType = grpc::ClientContext;
 
-	OutgoingRPC(const std::shared_ptr<ghost::ThreadPool>& threadPool, const std::string& serverIp, int serverPort,
-		    size_t dedicatedThreads);
+	using ReconnectStatistics = ghost::ConnectionControlGRPC::ReconnectStatistics;
+
+	OutgoingRPC(const std::shared_ptr<ghost::ThreadPool>& threadPool,
+		    const ghost::ConnectionConfigurationGRPC& configuration);
 	~OutgoingRPC();
 
+	/// Blocks until the connection is established or failed.
 	bool start();
+	/// Starts connecting without blocking. The result is available through the returned future, and passed to
+	/// the callback (if provided) from a thread of the thread pool, once the reader and the writer are started.
+	std::shared_future<bool> startAsync(const std::function<void(bool)>& callback = {});
 	bool stop();
 	bool isRunning() const;
 
 	// configuration: set a writer sink or a reader sink to activate the feature
 	void setWriterSink(const std::shared_ptr<ghost::WriterSink>& sink);
 	void setReaderSink(const std::shared_ptr<ghost::ReaderSink>& sink);
+	/// Reads the received messages in raw mode, without parsing them. Replaces the readerSink.
+	void setRawReaderHandler(const RawReaderHandler& handler);
+	/// Calls "callback" every time the stream is lost or finished, including before a reconnection. It is called
+	/// by a thread of the completion queue and should not block.
+	void addDisconnectedCallback(const std::function<void()>& callback);
+
+	ReconnectStatistics getReconnectStatistics() const;
+	/// @return the server endpoint of the current stream ("host:port").
+	std::string getEndpoint() const;
 
 private:
+	using RPCType = RPC<ReaderWriter, ContextType>;
+
+	/// The reader and the writer share the settings of the stream.
+	OutgoingRPC(const std::shared_ptr<ghost::ThreadPool>& threadPool,
+		    const ghost::ConnectionConfigurationGRPC& configuration,
+		    const std::shared_ptr<const StreamSettings>& streamSettings);
+
 	void onRPCStateChanged(RPCStateMachine::State newState);
+	/// Starts connecting the current RPC, "onFinish" is called once the connection succeeded or failed.
+	/// @return false if the RPC could not be initialized, "onFinish" is not called then.
+	bool startConnection(const std::function<void()>& onFinish);
+	/// Starts the reader and the writer of a successful connection, or stops a failed one.
+	/// @return true if the connection is established.
+	bool completeConnection(const std::function<void(bool)>& callback);
 	void dispose();
+	std::shared_ptr<RPCType> getRPC() const;
+	/// Places the stream on an endpoint and creates the stub that connects to it.
+	/// @param failover	true if the current endpoint could not be used.
+	void placeStream(bool failover);
+	void releaseStream();
+	/// Tries the other endpoints after a failed connection.
+	bool failover();
+
+	/* Reconnection */
+	std::shared_ptr<RPCType> makeRPC();
+	void scheduleReconnect();
+	void reconnect();
+	bool connect(const std::shared_ptr<RPCType>& rpc);
+	void finish(const std::shared_ptr<RPCType>& rpc);
+	/// Prevents further reconnections and waits for the one in progress to return.
+	/// @return true if a reconnection was in progress.
+	bool stopReconnection();
 
 	std::shared_ptr<ghost::ThreadPool> _threadPool;
-	grpc::CompletionQueue* _completionQueue;
-	std::shared_ptr<ghost::protobuf::connectiongrpc::ServerClientService::Stub> _stub;
+	std::shared_ptr<CompletionQueueExecutor> _executor; // shared with the other clients
+	std::shared_ptr<grpc::GenericStub> _stub;
+
+	grpc::ChannelArguments _channelArguments;
+	std::shared_ptr<EndpointBalancer> _balancer;
+	mutable std::mutex _endpointMutex;
+	size_t _endpoint;
+	bool _endpointPlaced;
+
+	mutable std::mutex _rpcMutex;
+	std::shared_ptr<RPCType> _rpc;
+
+	std::shared_ptr<RPCConnect<ReaderWriter, ContextType>> _connectOperation;
+	std::shared_future<bool> _connectResult;
+	std::future<void> _connectCompletion;
 
-	std::string _serverIp;
-	int _serverPort;
+	bool _reconnectEnabled;
+	std::chrono::milliseconds _initialBackoff;
+	std::chrono::milliseconds _maxBackoff;
+	mutable std::mutex _reconnectMutex;
+	std::condition_variable _reconnectCondition; // backoff waits and connection attempts
+	bool _connected;
+	bool _stopping;
+	std::chrono::steady_clock::time_point _outageStart;
+	ReconnectStatistics _reconnectStatistics;
+	std::atomic_bool _reconnecting; // copy of _reconnectStatistics.reconnecting, read without the mutex
+	std::shared_ptr<RPCConnect<ReaderWriter, ContextType>> _reconnectOperation;
+	std::future<void> _reconnection;
 
-	std::shared_ptr<RPC<ReaderWriter, ContextType>> _rpc;
-	CompletionQueueExecutor _executor;
+	std::mutex _disconnectedCallbacksMutex;
+	std::vector<std::function<void()>> _disconnectedCallbacks;
 };
 } // namespace internal
 } // namespace ghost
@@ -36,28 +36,15 @@ void RPC<ReaderWriter, ContextType>::disposeGRPC()
 template <typename ReaderWriter, typename ContextType>
 bool RPC<ReaderWriter, ContextType>::initialize()
 {
-	auto lock = _statemachine.lock();
-	if (_statemachine.getState(false) == RPCStateMachine::CREATED)
-	{
-		_statemachine.setState(RPCStateMachine::INITIALIZING, false);
-		return true;
-	}
-
-	return false;
+	return _statemachine.setState(RPCStateMachine::CREATED, RPCStateMachine::INITIALIZING);
 }
 
 template <typename ReaderWriter, typename ContextType>
 bool RPC<ReaderWriter, ContextType>::dispose()
 {
-	auto lock =
-	    _statemachine.lock(); // mutex taken because user can call it concurrently - avoids entering twice in the if
-	if (_statemachine.getState(false) == RPCStateMachine::EXECUTING ||
-	    _statemachine.getState(false) == RPCStateMachine::INACTIVE)
-	{
-		_statemachine.setState(RPCStateMachine::DISPOSING, false);
-		return true;
-	}
-	return false;
+	// the user can call it concurrently: only one of the calls succeeds the transition
+	return _statemachine.setState(RPCStateMachine::EXECUTING, RPCStateMachine::DISPOSING) ||
+	       _statemachine.setState(RPCStateMachine::INACTIVE, RPCStateMachine::DISPOSING);
 }
 
 template <typename ReaderWriter, typename ContextType>
@@ -69,7 +56,9 @@ void RPC<ReaderWriter, ContextType>::startOperation()
 template <typename ReaderWriter, typename ContextType>
 void RPC<ReaderWriter, ContextType>::finishOperation()
 {
+	// the last operation completes the RPC if it is already finished
 	_operationsRunning--;
+	_statemachine.notify();
 }
 
 template <typename ReaderWriter, typename ContextType>
@@ -81,12 +70,15 @@ bool RPC<ReaderWriter, ContextType>::isFinished() const
 template <typename ReaderWriter, typename ContextType>
 void RPC<ReaderWriter, ContextType>::awaitFinished()
 {
-	while ((_statemachine.getState() != RPCStateMachine::FINISHED &&
-		_statemachine.getState() != RPCStateMachine::CREATED) ||
-	       _operationsRunning > 0)
-	{
-		_threadPool->yield(std::chrono::milliseconds(1));
-	}
+	auto finished = [this] {
+		auto state = _statemachine.getState();
+		return (state == RPCStateMachine::FINISHED || state == RPCStateMachine::CREATED) &&
+		       _operationsRunning == 0;
+	};
+
+	// Woken up by every transition and completed operation. The completion queue that completes the RPC is
+	// processed by executors that own their thread, they do not depend on the caller.
+	_statemachine.await(finished);
 }
 
 template <typename ReaderWriter, typename ContextType>
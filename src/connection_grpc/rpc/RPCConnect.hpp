@@ -20,8 +20,10 @@
 #include <ghost/connection_grpc/ServerClientService.grpc.pb.h>
 #include <ghost/connection_grpc/ServerClientService.pb.h>
 #include <grpcpp/completion_queue.h>
+#include <grpcpp/generic/generic_stub.h>
 
 #include <memory>
+#include <string>
 
 #include "RPCOperation.hpp"
 
@@ -32,13 +34,14 @@ namespace internal
 /**
  *	Connect operation used by an outgoing connection (@see ghost::internal::OutgoingRPC) to connect
  *	to a server.
+ *	The call is made through a generic stub: its messages are the serialized bytes of the google.protobuf.Any
+ *	messages of ServerClientService::connect, which makes it compatible with the generated service.
  */
 template <typename ReaderWriter, typename ContextType>
 class RPCConnect : public RPCOperation<ReaderWriter, ContextType>
 {
 public:
-	RPCConnect(std::weak_ptr<RPC<ReaderWriter, ContextType>> parent,
-		   const std::shared_ptr<ghost::protobuf::connectiongrpc::ServerClientService::Stub>& stub,
+	RPCConnect(std::weak_ptr<RPC<ReaderWriter, ContextType>> parent, const std::shared_ptr<grpc::GenericStub>& stub,
 		   grpc::CompletionQueue* completionQueue);
 
 protected:
@@ -47,17 +50,16 @@ protected:
 	void onOperationFailed() override;
 
 private:
-	std::shared_ptr<ghost::protobuf::connectiongrpc::ServerClientService::Stub> _stub;
+	std::shared_ptr<grpc::GenericStub> _stub;
 	grpc::CompletionQueue* _completionQueue;
 };
 
 /////////////////////////// Template definition ///////////////////////////
 
 template <typename ReaderWriter, typename ContextType>
-RPCConnect<ReaderWriter, ContextType>::RPCConnect(
-    std::weak_ptr<RPC<ReaderWriter, ContextType>> parent,
-    const std::shared_ptr<ghost::protobuf::connectiongrpc::ServerClientService::Stub>& stub,
-    grpc::CompletionQueue* completionQueue)
+RPCConnect<ReaderWriter, ContextType>::RPCConnect(std::weak_ptr<RPC<ReaderWriter, ContextType>> parent,
+						  const std::shared_ptr<grpc::GenericStub>& stub,
+						  grpc::CompletionQueue* completionQueue)
     : RPCOperation<ReaderWriter, ContextType>(parent), _stub(stub), _completionQueue(completionQueue)
 {
 }
@@ -68,8 +70,11 @@ bool RPCConnect<ReaderWriter, ContextType>::initiateOperation()
 	auto rpc = RPCOperation<ReaderWriter, ContextType>::_rpc.lock();
 	if (!rpc) return false;
 
-	rpc->setClient(_stub->Asyncconnect(rpc->getContext().get(), _completionQueue,
-					   &(RPCOperation<ReaderWriter, ContextType>::_operationCompletedCallback)));
+	static const std::string method =
+	    std::string("/") + ghost::protobuf::connectiongrpc::ServerClientService::service_full_name() + "/connect";
+
+	rpc->setClient(_stub->PrepareCall(rpc->getContext().get(), method, _completionQueue));
+	rpc->getClient()->StartCall(&(RPCOperation<ReaderWriter, ContextType>::_operationCompletedCallback));
 	return true;
 }
 
@@ -14,10 +14,13 @@
  * limitations under the License.
  */
 
+
 #ifndef GHOST_INTERNAL_NETWORK_RPCREAD_HPP
 #define GHOST_INTERNAL_NETWORK_RPCREAD_HPP
 
-#include <ghost/connection/ReaderSink.hpp>
+#include <grpcpp/support/byte_buffer.h>
+
+#include <functional>
 #include <memory>
 
 #include "RPCOperation.hpp"
@@ -29,13 +32,14 @@ namespace internal
 /**
  *	Single read operation for outgoing and incoming connections.
  *	The operation completes once a message is read or the connection is shut down.
+ *	The message is read as it was received, without being parsed, and passed to the callback of the operation.
  */
-template <typename ReaderWriter, typename ContextType, typename ReadMessageType>
+template <typename ReaderWriter, typename ContextType>
 class RPCRead : public RPCOperation<ReaderWriter, ContextType>
 {
 public:
 	RPCRead(std::weak_ptr<RPC<ReaderWriter, ContextType>> parent,
-		const std::shared_ptr<ghost::ReaderSink>& readerSink);
+		const std::function<void(grpc::ByteBuffer&)>& messageCallback);
 
 protected:
 	bool initiateOperation() override;
@@ -43,21 +47,21 @@ protected:
 	void onOperationFailed() override;
 
 private:
-	ReadMessageType _incomingMessage;
-	std::shared_ptr<ghost::ReaderSink> _readerSink;
+	grpc::ByteBuffer _incomingMessage;
+	std::function<void(grpc::ByteBuffer&)> _messageCallback;
 };
 
 /////////////////////////// Template definition ///////////////////////////
 
-template <typename ReaderWriter, typename ContextType, typename ReadMessageType>
-RPCRead<ReaderWriter, ContextType, ReadMessageType>::RPCRead(std::weak_ptr<RPC<ReaderWriter, ContextType>> parent,
-							     const std::shared_ptr<ghost::ReaderSink>& readerSink)
-    : RPCOperation<ReaderWriter, ContextType>(parent), _readerSink(readerSink)
+template <typename ReaderWriter, typename ContextType>
+RPCRead<ReaderWriter, ContextType>::RPCRead(std::weak_ptr<RPC<ReaderWriter, ContextType>> parent,
+					    const std::function<void(grpc::ByteBuffer&)>& messageCallback)
+    : RPCOperation<ReaderWriter, ContextType>(parent), _messageCallback(messageCallback)
 {
 }
 
-template <typename ReaderWriter, typename ContextType, typename ReadMessageType>
-bool RPCRead<ReaderWriter, ContextType, ReadMessageType>::initiateOperation()
+template <typename ReaderWriter, typename ContextType>
+bool RPCRead<ReaderWriter, ContextType>::initiateOperation()
 {
 	auto rpc = RPCOperation<ReaderWriter, ContextType>::_rpc.lock();
 	if (!rpc) return false;
@@ -68,19 +72,15 @@ bool RPCRead<ReaderWriter, ContextType, ReadMessageType>::initiateOperation()
 	return true;
 }
 
-template <typename ReaderWriter, typename ContextType, typename ReadMessageType>
-void RPCRead<ReaderWriter, ContextType, ReadMessageType>::onOperationSucceeded()
+template <typename ReaderWriter, typename ContextType>
+void RPCRead<ReaderWriter, ContextType>::onOperationSucceeded()
 {
-	google::protobuf::Any anyMessage;
-	if (_incomingMessage.GetTypeName() == anyMessage.descriptor()->full_name())
-		anyMessage = _incomingMessage;
-	else
-		anyMessage.PackFrom(_incomingMessage);
-	_readerSink->put(anyMessage);
+	// the operation is not reused, the callback may consume the message
+	_messageCallback(_incomingMessage);
 }
 
-template <typename ReaderWriter, typename ContextType, typename ReadMessageType>
-void RPCRead<ReaderWriter, ContextType, ReadMessageType>::onOperationFailed()
+template <typename ReaderWriter, typename ContextType>
+void RPCRead<ReaderWriter, ContextType>::onOperationFailed()
 {
 	auto rpc = RPCOperation<ReaderWriter, ContextType>::_rpc.lock();
 	if (!rpc) return;
@@ -18,54 +18,40 @@
 
 using namespace ghost::internal;
 
-RPCStateMachine::RPCStateMachine() : _state(CREATED)
+RPCStateMachine::RPCStateMachine() : _state(CREATED), _waiters(0)
 {
 }
 
-RPCStateMachine::State RPCStateMachine::getState(bool lockk) const
+RPCStateMachine::State RPCStateMachine::getState() const
 {
-	if (lockk)
-	{
-		std::lock_guard<std::mutex> lock(_mutex);
-		return _state;
-	}
-
-	return _state;
+	return _state.load(std::memory_order_acquire);
 }
 
-void RPCStateMachine::setState(State state, bool lockk)
+bool RPCStateMachine::setState(State state)
 {
-	if (lockk) _mutex.lock();
-
-	bool transitionAllowed = false;
-	switch (_state)
+	State current = getState();
+	do
 	{
-		case CREATED:
-			transitionAllowed = (state != EXECUTING && state != INACTIVE);
-			break;
-		case INITIALIZING:
-			transitionAllowed = (state != CREATED);
-			break;
-		case EXECUTING:
-		case INACTIVE:
-			transitionAllowed = (state == INACTIVE || state == DISPOSING || state == FINISHED);
-			break;
-		case DISPOSING:
-			transitionAllowed = (state == FINISHED);
-			break;
-		case FINISHED:
-			transitionAllowed = false;
-			break;
-		default:
-			break;
-	}
+		if (!isTransitionAllowed(current, state)) return false;
+		// on failure, "current" is updated with the state that was set concurrently
+	} while (!_state.compare_exchange_weak(current, state, std::memory_order_acq_rel, std::memory_order_acquire));
 
-	if (transitionAllowed) _state = state;
+	notify();
+	// Call the callback if one was set.
+	if (_stateChangedCallback) _stateChangedCallback(state);
+	return true;
+}
 
-	if (lockk) _mutex.unlock();
+bool RPCStateMachine::setState(State expected, State state)
+{
+	if (!isTransitionAllowed(expected, state)) return false;
+	if (!_state.compare_exchange_strong(expected, state, std::memory_order_acq_rel, std::memory_order_acquire))
+		return false;
 
+	notify();
 	// Call the callback if one was set.
-	if (transitionAllowed && _stateChangedCallback) _stateChangedCallback(state);
+	if (_stateChangedCallback) _stateChangedCallback(state);
+	return true;
 }
 
 void RPCStateMachine::setStateChangedCallback(const std::function<void(State)>& callback)
@@ -73,7 +59,58 @@ void RPCStateMachine::setStateChangedCallback(const std::function<void(State)>&
 	_stateChangedCallback = callback;
 }
 
-std::unique_lock<std::mutex> RPCStateMachine::lock()
+void RPCStateMachine::await(const std::function<bool()>& predicate) const
+{
+	_waiters++;
+	{
+		std::unique_lock<std::mutex> lock(_waitMutex);
+		_waitCondition.wait(lock, predicate);
+	}
+	_waiters--;
+}
+
+bool RPCStateMachine::await(const std::function<bool()>& predicate, const std::chrono::milliseconds& timeout) const
 {
-	return std::unique_lock<std::mutex>(_mutex);
+	// registered before the predicate is evaluated: a concurrent change either is seen by the predicate, or
+	// sees the waiter and notifies it
+	_waiters++;
+	bool result;
+	{
+		std::unique_lock<std::mutex> lock(_waitMutex);
+		result = _waitCondition.wait_for(lock, timeout, predicate);
+	}
+	_waiters--;
+	return result;
+}
+
+void RPCStateMachine::notify() const
+{
+	// orders the change made by the caller before the read of the waiters, as "_waiters++" in "await"
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (_waiters == 0) return;
+
+	// taking the mutex guarantees that a waiter is either blocked or has not evaluated its predicate yet
+	{
+		std::lock_guard<std::mutex> lock(_waitMutex);
+	}
+	_waitCondition.notify_all();
+}
+
+bool RPCStateMachine::isTransitionAllowed(State from, State to)
+{
+	switch (from)
+	{
+		case CREATED:
+			return (to != EXECUTING && to != INACTIVE);
+		case INITIALIZING:
+			return (to != CREATED);
+		case EXECUTING:
+		case INACTIVE:
+			return (to == INACTIVE || to == DISPOSING || to == FINISHED);
+		case DISPOSING:
+			return (to == FINISHED);
+		case FINISHED:
+		default:
+			return false;
+	}
 }
@@ -17,6 +17,9 @@
 #ifndef GHOST_INTERNAL_NETWORK_RPCSTATEMACHINE_HPP
 #define GHOST_INTERNAL_NETWORK_RPCSTATEMACHINE_HPP
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -27,6 +30,11 @@ namespace internal
 {
 /**
  *	State machine representing all the possible states of an RPC.
+ *	The state is an atomic value: reading it never blocks, and the transitions are applied
+ *	with a compare-and-swap, so that concurrent transitions cannot both succeed from the
+ *	same state.
+ *	Threads can wait for a condition on the state with "await": they are woken up by the
+ *	transitions and by "notify", the mutex is only taken when a thread is waiting.
  */
 class RPCStateMachine
 {
@@ -48,16 +56,29 @@ public:
 	};
 
 	RPCStateMachine();
-	State getState(bool lock = true) const;
-	void setState(State state, bool lock = true);
+	State getState() const;
+	/// Changes the state if the transition from the current state is allowed.
+	bool setState(State state);
+	/// Changes the state only if it currently is "expected" and the transition is allowed.
+	bool setState(State expected, State state);
 	void setStateChangedCallback(const std::function<void(State)>& callback);
 
-	std::unique_lock<std::mutex> lock();
+	/// Blocks until "predicate" is true.
+	void await(const std::function<bool()>& predicate) const;
+	/// Blocks until "predicate" is true or the timeout expired. @return the last value of the predicate.
+	bool await(const std::function<bool()>& predicate, const std::chrono::milliseconds& timeout) const;
+	/// Wakes up the waiting threads, for predicates that do not only depend on the state.
+	void notify() const;
+
+	static bool isTransitionAllowed(State from, State to);
 
 private:
-	State _state;
+	std::atomic<State> _state;
 	std::function<void(State)> _stateChangedCallback;
-	mutable std::mutex _mutex;
+
+	mutable std::atomic<int> _waiters;
+	mutable std::mutex _waitMutex;
+	mutable std::condition_variable _waitCondition;
 };
 } // namespace internal
 } // namespace ghost
@@ -17,10 +17,12 @@
 #ifndef GHOST_INTERNAL_NETWORK_RPCWRITE_HPP
 #define GHOST_INTERNAL_NETWORK_RPCWRITE_HPP
 
-#include <ghost/connection/WriterSink.hpp>
+#include <grpcpp/support/byte_buffer.h>
+
 #include <memory>
 
 #include "RPCOperation.hpp"
+#include "WriterQueue.hpp"
 
 namespace ghost
 {
@@ -28,14 +30,18 @@ namespace internal
 {
 /**
  *	Write operation for incoming and outgoing connections.
- *	This operation fails if there is nothing to write in the writerSink.
+ *	Writes the oldest message of the writer queue, which is removed from the queue once the write succeeded.
+ *	The write is corked (grpc::WriteOptions::set_buffer_hint) when the queue decides to coalesce it with the
+ *	next messages.
+ *	This operation fails if there is nothing to write in the writer queue.
+ *	The messages of the queue are already serialized: the write shares their buffer with the queue.
  */
-template <typename ReaderWriter, typename ContextType, typename WriteMessageType>
+template <typename ReaderWriter, typename ContextType>
 class RPCWrite : public RPCOperation<ReaderWriter, ContextType>
 {
 public:
 	RPCWrite(std::weak_ptr<RPC<ReaderWriter, ContextType>> parent,
-		 const std::shared_ptr<ghost::WriterSink>& writerSink);
+		 const std::shared_ptr<WriterQueue>& writerQueue);
 
 protected:
 	bool initiateOperation() override;
@@ -43,55 +49,53 @@ protected:
 	void onOperationFailed() override;
 
 private:
-	std::shared_ptr<ghost::WriterSink> _writerSink;
+	std::shared_ptr<WriterQueue> _writerQueue;
 };
 
 /////////////////////////// Template definition ///////////////////////////
 
-template <typename ReaderWriter, typename ContextType, typename WriteMessageType>
-RPCWrite<ReaderWriter, ContextType, WriteMessageType>::RPCWrite(std::weak_ptr<RPC<ReaderWriter, ContextType>> parent,
-								const std::shared_ptr<ghost::WriterSink>& writerSink)
-    : RPCOperation<ReaderWriter, ContextType>(parent), _writerSink(writerSink)
+template <typename ReaderWriter, typename ContextType>
+RPCWrite<ReaderWriter, ContextType>::RPCWrite(std::weak_ptr<RPC<ReaderWriter, ContextType>> parent,
+					      const std::shared_ptr<WriterQueue>& writerQueue)
+    : RPCOperation<ReaderWriter, ContextType>(parent), _writerQueue(writerQueue)
 {
 }
 
-template <typename ReaderWriter, typename ContextType, typename WriteMessageType>
-bool RPCWrite<ReaderWriter, ContextType, WriteMessageType>::initiateOperation()
+template <typename ReaderWriter, typename ContextType>
+bool RPCWrite<ReaderWriter, ContextType>::initiateOperation()
 {
 	auto rpc = RPCOperation<ReaderWriter, ContextType>::_rpc.lock();
 	if (!rpc) return false;
 
-	google::protobuf::Any message;
-	bool success = false;
+	// An RPC that is still connecting (after a reconnection) has no stream yet
+	auto rpcState = rpc->getStateMachine().getState();
+	if (rpcState == RPCStateMachine::CREATED || rpcState == RPCStateMachine::INITIALIZING) return false;
 
-	bool hasMessage = _writerSink->get(message, std::chrono::milliseconds(0));
+	grpc::ByteBuffer message;
+	bool bufferHint = false;
+	bool hasMessage = _writerQueue->front(message, bufferHint);
 	if (!hasMessage) return false;
 
-	WriteMessageType msg;
-	if (msg.GetTypeName() == message.descriptor()->full_name()) // Don't unpack any to any because it will fail
-		msg = message;
-	else
-	{
-		bool unpackSuccess = message.UnpackTo(&msg);
-		if (!unpackSuccess) return false;
-	}
+	grpc::WriteOptions options;
+	if (bufferHint) options.set_buffer_hint();
 
-	rpc->getClient()->Write(msg, &(RPCOperation<ReaderWriter, ContextType>::_operationCompletedCallback));
+	rpc->getClient()->Write(message, options,
+				&(RPCOperation<ReaderWriter, ContextType>::_operationCompletedCallback));
 	return true;
 }
 
-template <typename ReaderWriter, typename ContextType, typename WriteMessageType>
-void RPCWrite<ReaderWriter, ContextType, WriteMessageType>::onOperationSucceeded()
+template <typename ReaderWriter, typename ContextType>
+void RPCWrite<ReaderWriter, ContextType>::onOperationSucceeded()
 {
 	auto rpc = RPCOperation<ReaderWriter, ContextType>::_rpc.lock();
 	if (!rpc) return;
 	if (rpc->isFinished()) return; // nothing to do here
 
-	_writerSink->pop();
+	_writerQueue->pop();
 }
 
-template <typename ReaderWriter, typename ContextType, typename WriteMessageType>
-void RPCWrite<ReaderWriter, ContextType, WriteMessageType>::onOperationFailed()
+template <typename ReaderWriter, typename ContextType>
+void RPCWrite<ReaderWriter, ContextType>::onOperationFailed()
 {
 	auto rpc = RPCOperation<ReaderWriter, ContextType>::_rpc.lock();
 	if (!rpc) return;
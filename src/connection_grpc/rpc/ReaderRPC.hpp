@@ -17,10 +17,20 @@
 #ifndef GHOST_INTERNAL_NETWORK_READERRPC_HPP
 #define GHOST_INTERNAL_NETWORK_READERRPC_HPP
 
+#include <grpcpp/support/byte_buffer.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <ghost/connection/ReaderSink.hpp>
 #include <memory>
+#include <mutex>
+#include <string>
 
 #include "RPCRead.hpp"
+#include "SequenceChecker.hpp"
+#include "StreamSettings.hpp"
+#include "StreamType.hpp"
 
 namespace ghost
 {
@@ -29,29 +39,67 @@ namespace internal
 /**
  *	Base class for a reading connection (IncomingRPC and OutgoingRPC).
  *	Manages the RPCRead calls and populates the readerSink with newly received messages.
+ *
+ *	In raw mode (see "initRawReader"), the received messages are passed to a handler as they were received,
+ *	without being parsed: relays forward them without decoding and encoding them again. The handler pauses the
+ *	reads when it cannot take more messages, and "resumeReader" restarts them: the messages then wait in the
+ *	stream, which applies the flow control of gRPC to the remote writer.
+ *
+ *	If sequence numbers are enabled, the number of every received message is checked by a
+ *	ghost::internal::SequenceChecker, and removed from the parsed messages.
  */
 template <typename ReaderWriter, typename ContextType>
 class ReaderRPC
 {
 public:
+	/// Receives the serialized messages of a raw reader. The handler is called by the completion queue, it may
+	/// keep a copy of the buffer (which shares the received bytes) but should not block.
+	/// It returns false to pause the reads after this message, until "resumeReader" is called.
+	using RawReaderHandler = std::function<bool(const grpc::ByteBuffer& message)>;
+
+	ReaderRPC(const std::shared_ptr<const StreamSettings>& settings);
 	virtual ~ReaderRPC() = default;
 
 	void initReader(std::shared_ptr<RPC<ReaderWriter, ContextType>> rpc,
 			const std::shared_ptr<ghost::ReaderSink>& sink = nullptr);
+	/// Reads from "rpc" in raw mode: the messages are passed to "handler" instead of a readerSink.
+	void initRawReader(std::shared_ptr<RPC<ReaderWriter, ContextType>> rpc, const RawReaderHandler& handler);
 	void startReader(const std::shared_ptr<ghost::ReaderSink>& sink = nullptr);
+	/// Waits until the reads of the previous (finished) RPC completed, then reads from "rpc" with the same sink.
+	void switchReader(std::shared_ptr<RPC<ReaderWriter, ContextType>> rpc);
+	/// Restarts the reads that a raw reader handler paused.
+	void resumeReader();
 	void drainReader();
 	void stopReader();
+	/// Metrics of the sequence numbers of the received messages, see SequenceChecker.
+	SequenceChecker::Statistics getSequenceStatistics() const;
 
 private:
 	void restartReader();
+	void onMessageRead(grpc::ByteBuffer& message);
+	std::shared_ptr<RPCRead<ReaderWriter, ContextType>> makeReaderOperation();
 
 	std::shared_ptr<RPC<ReaderWriter, ContextType>> _rpc;
 	std::mutex _readerMutex;
-	std::shared_ptr<RPCRead<ReaderWriter, ContextType, google::protobuf::Any>> _activeReaderOperation;
-	std::shared_ptr<RPCRead<ReaderWriter, ContextType, google::protobuf::Any>> _completedReaderOperation;
+	std::condition_variable _readerCondition; // notified when the active operation is reset
+	std::shared_ptr<RPCRead<ReaderWriter, ContextType>> _activeReaderOperation;
+	std::shared_ptr<RPCRead<ReaderWriter, ContextType>> _completedReaderOperation;
 	std::shared_ptr<ghost::ReaderSink> _readerSink;
+	RawReaderHandler _rawReaderHandler;
+	bool _readerPaused;
+	uint64_t _readerResumes; // incremented by "resumeReader", so that a pause does not miss a concurrent resume
+	std::shared_ptr<const StreamSettings> _settings;
+	SequenceChecker _sequenceChecker;
 };
 
+template <typename ReaderWriter, typename ContextType>
+ReaderRPC<ReaderWriter, ContextType>::ReaderRPC(const std::shared_ptr<const StreamSettings>& settings)
+    : _readerPaused(false)
+    , _readerResumes(0)
+    , _settings(settings)
+{
+}
+
 template <typename ReaderWriter, typename ContextType>
 void ReaderRPC<ReaderWriter, ContextType>::initReader(std::shared_ptr<RPC<ReaderWriter, ContextType>> rpc,
 						      const std::shared_ptr<ghost::ReaderSink>& sink)
@@ -60,18 +108,26 @@ void ReaderRPC<ReaderWriter, ContextType>::initReader(std::shared_ptr<RPC<Reader
 	_rpc = rpc;
 }
 
+template <typename ReaderWriter, typename ContextType>
+void ReaderRPC<ReaderWriter, ContextType>::initRawReader(std::shared_ptr<RPC<ReaderWriter, ContextType>> rpc,
+							 const RawReaderHandler& handler)
+{
+	_rawReaderHandler = handler;
+	_rpc = rpc;
+}
+
 template <typename ReaderWriter, typename ContextType>
 void ReaderRPC<ReaderWriter, ContextType>::startReader(const std::shared_ptr<ghost::ReaderSink>& sink)
 {
 	if (sink) _readerSink = sink;
 
-	if (_readerSink)
+	if (_readerSink || _rawReaderHandler)
 	{
-		auto readerOperation =
-		    std::make_shared<RPCRead<ReaderWriter, ContextType, google::protobuf::Any>>(_rpc, _readerSink);
+		// a new stream is read at least once, the raw reader handler pauses it again if needed
+		std::lock_guard<std::mutex> lock(_readerMutex);
+		_readerPaused = false;
 
-		// Register a callback on completion, so that the operation can be restarted
-		readerOperation->onFinish(std::bind(&ReaderRPC<ReaderWriter, ContextType>::restartReader, this));
+		auto readerOperation = makeReaderOperation();
 
 		// Start the operation
 		bool startResult = readerOperation->start();
@@ -79,18 +135,85 @@ void ReaderRPC<ReaderWriter, ContextType>::startReader(const std::shared_ptr<gho
 	}
 }
 
+template <typename ReaderWriter, typename ContextType>
+void ReaderRPC<ReaderWriter, ContextType>::switchReader(std::shared_ptr<RPC<ReaderWriter, ContextType>> rpc)
+{
+	std::unique_lock<std::mutex> lock(_readerMutex);
+	// The last read of the previous RPC resets the active operation when its restart fails
+	_readerCondition.wait(lock, [this] { return !_activeReaderOperation; });
+	_rpc = rpc;
+}
+
 template <typename ReaderWriter, typename ContextType>
 void ReaderRPC<ReaderWriter, ContextType>::restartReader()
 {
 	std::unique_lock<std::mutex> lock(_readerMutex);
 	_completedReaderOperation = std::move(_activeReaderOperation);
 
-	auto readerOperation =
-	    std::make_shared<RPCRead<ReaderWriter, ContextType, google::protobuf::Any>>(_rpc, _readerSink);
-	readerOperation->onFinish(std::bind(&ReaderRPC<ReaderWriter, ContextType>::restartReader, this));
+	// a paused reader is restarted by "resumeReader"
+	if (!_readerPaused)
+	{
+		auto readerOperation = makeReaderOperation();
+		if (readerOperation->start()) _activeReaderOperation = readerOperation;
+	}
+
+	if (!_activeReaderOperation) _readerCondition.notify_all();
+}
+
+template <typename ReaderWriter, typename ContextType>
+void ReaderRPC<ReaderWriter, ContextType>::resumeReader()
+{
+	std::lock_guard<std::mutex> lock(_readerMutex);
+	_readerPaused = false;
+	_readerResumes++;
+
+	// an active operation restarts by itself
+	if (_activeReaderOperation || !_rpc) return;
 
-	bool startResult = readerOperation->start();
-	if (startResult) _activeReaderOperation = readerOperation;
+	auto readerOperation = makeReaderOperation();
+	if (readerOperation->start()) _activeReaderOperation = readerOperation;
+}
+
+template <typename ReaderWriter, typename ContextType>
+void ReaderRPC<ReaderWriter, ContextType>::onMessageRead(grpc::ByteBuffer& message)
+{
+	uint64_t sequenceNumber;
+	if (_rawReaderHandler)
+	{
+		// the raw message is forwarded with its sequence number, a relay may stamp it again
+		if (_settings->sequenceNumbers && readSequenceNumber(message, sequenceNumber))
+			_sequenceChecker.check(sequenceNumber);
+
+		uint64_t resumes;
+		{
+			std::lock_guard<std::mutex> lock(_readerMutex);
+			resumes = _readerResumes;
+		}
+		if (_rawReaderHandler(message)) return;
+
+		// the next read is not started, unless the handler resumed the reads in the meantime
+		std::lock_guard<std::mutex> lock(_readerMutex);
+		if (_readerResumes == resumes) _readerPaused = true;
+		return;
+	}
+
+	google::protobuf::Any anyMessage;
+	if (!_readerSink || !parseStreamMessage(message, _settings->streamTypeUrl, anyMessage)) return;
+
+	if (_settings->sequenceNumbers && takeSequenceNumber(anyMessage, sequenceNumber))
+		_sequenceChecker.check(sequenceNumber);
+	_readerSink->put(anyMessage);
+}
+
+template <typename ReaderWriter, typename ContextType>
+std::shared_ptr<RPCRead<ReaderWriter, ContextType>> ReaderRPC<ReaderWriter, ContextType>::makeReaderOperation()
+{
+	auto readerOperation = std::make_shared<RPCRead<ReaderWriter, ContextType>>(
+	    _rpc, [this](grpc::ByteBuffer& message) { onMessageRead(message); });
+
+	// Register a callback on completion, so that the operation can be restarted
+	readerOperation->onFinish(std::bind(&ReaderRPC<ReaderWriter, ContextType>::restartReader, this));
+	return readerOperation;
 }
 
 template <typename ReaderWriter, typename ContextType>
@@ -104,6 +227,12 @@ void ReaderRPC<ReaderWriter, ContextType>::stopReader()
 {
 }
 
+template <typename ReaderWriter, typename ContextType>
+SequenceChecker::Statistics ReaderRPC<ReaderWriter, ContextType>::getSequenceStatistics() const
+{
+	return _sequenceChecker.getStatistics();
+}
+
 } // namespace internal
 } // namespace ghost
 
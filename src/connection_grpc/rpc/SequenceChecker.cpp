@@ -0,0 +1,50 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SequenceChecker.hpp"
+
+using namespace ghost::internal;
+
+SequenceChecker::SequenceChecker() : _last(0)
+{
+}
+
+void SequenceChecker::check(uint64_t sequenceNumber)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_statistics.received++;
+
+	if (_last == 0 || (sequenceNumber == 1 && _last != 1))
+	{
+		if (_last != 0) _statistics.restarts++;
+		_last = sequenceNumber;
+	}
+	else if (sequenceNumber > _last)
+	{
+		_statistics.gaps += sequenceNumber - _last - 1;
+		_last = sequenceNumber;
+	}
+	else if (sequenceNumber == _last)
+		_statistics.duplicates++;
+	else
+		_statistics.outOfOrder++; // the reference stays the highest number received
+}
+
+SequenceChecker::Statistics SequenceChecker::getStatistics() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _statistics;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GHOST_INTERNAL_NETWORK_SEQUENCECHECKER_HPP
+#define GHOST_INTERNAL_NETWORK_SEQUENCECHECKER_HPP
+
+#include <cstdint>
+#include <ghost/connection_grpc/ConnectionControlGRPC.hpp>
+#include <mutex>
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Checks the sequence numbers of the messages received by a connection (see
+ *	ghost::ConnectionConfigurationGRPC::setSequenceNumbersEnabled).
+ *	Numbers are expected to follow the last number received: a higher number reveals lost messages, a lower
+ *	one a message received out of order, and the same one a duplicate. The first number received, and the
+ *	number 1 (a writer that restarted), only set the reference for the next ones.
+ *	The reference survives the restart of the stream, so that the messages lost during a reconnection are
+ *	counted.
+ */
+class SequenceChecker
+{
+public:
+	using Statistics = ghost::ConnectionControlGRPC::SequenceStatistics;
+
+	SequenceChecker();
+
+	void check(uint64_t sequenceNumber);
+	Statistics getStatistics() const;
+
+private:
+	mutable std::mutex _mutex;
+	uint64_t _last; // 0 until a number is received
+	Statistics _statistics;
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_SEQUENCECHECKER_HPP
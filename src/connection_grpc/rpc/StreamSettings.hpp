@@ -0,0 +1,71 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GHOST_INTERNAL_NETWORK_STREAMSETTINGS_HPP
+#define GHOST_INTERNAL_NETWORK_STREAMSETTINGS_HPP
+
+#include <chrono>
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "StreamType.hpp"
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Settings of the streams of a connection, read once from its configuration.
+ *	They are immutable: a server creates them once and shares them between all its incoming RPCs, so that a
+ *	connection does not hold its own copy of the type URL, the message priorities and the times to live.
+ */
+struct StreamSettings
+{
+	using Priority = ghost::ConnectionConfigurationGRPC::MessagePriority;
+
+	size_t writerHighWatermark = 0;
+	size_t writerLowWatermark = 0;
+	size_t writerHighWatermarkBytes = 0;
+	size_t writerLowWatermarkBytes = 0;
+	std::chrono::microseconds writerMaxCoalescingDelay = std::chrono::microseconds(0);
+	std::string streamTypeUrl;
+	std::map<std::string, Priority> priorities;
+	size_t starvationLimit = 0;
+	std::map<std::string, std::chrono::milliseconds> timesToLive;
+	bool sequenceNumbers = false;
+
+	static std::shared_ptr<const StreamSettings> create(const ghost::ConnectionConfigurationGRPC& configuration)
+	{
+		auto settings = std::make_shared<StreamSettings>();
+		settings->writerHighWatermark = configuration.getWriterHighWatermark();
+		settings->writerLowWatermark = configuration.getWriterLowWatermark();
+		settings->writerHighWatermarkBytes = configuration.getWriterHighWatermarkBytes();
+		settings->writerLowWatermarkBytes = configuration.getWriterLowWatermarkBytes();
+		settings->writerMaxCoalescingDelay = configuration.getWriterMaxCoalescingDelay();
+		settings->streamTypeUrl = makeStreamTypeUrl(configuration);
+		settings->priorities = configuration.getMessagePriorities();
+		settings->starvationLimit = configuration.getPriorityStarvationLimit();
+		settings->timesToLive = configuration.getMessageTimesToLive();
+		settings->sequenceNumbers = configuration.isSequenceNumbersEnabled();
+		return settings;
+	}
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_STREAMSETTINGS_HPP
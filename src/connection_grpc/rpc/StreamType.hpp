@@ -0,0 +1,203 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_INTERNAL_NETWORK_STREAMTYPE_HPP
+#define GHOST_INTERNAL_NETWORK_STREAMTYPE_HPP
+
+#include <google/protobuf/any.pb.h>
+#include <google/protobuf/unknown_field_set.h>
+#include <grpcpp/impl/codegen/proto_utils.h>
+#include <grpcpp/support/byte_buffer.h>
+
+#include <cstdint>
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
+#include <string>
+#include <vector>
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Type URL of the messages of a single-type stream (see ConnectionConfigurationGRPC::setStreamMessageType).
+ *	@return an empty string if no type is declared.
+ */
+inline std::string makeStreamTypeUrl(const ghost::ConnectionConfigurationGRPC& configuration)
+{
+	std::string typeName = configuration.getStreamMessageType();
+	if (typeName.empty()) return "";
+
+	return "type.googleapis.com/" + typeName;
+}
+
+/**
+ *	Serializes a message to be written on a stream. Messages of the stream's type are sent without their
+ *	type URL, which is removed from "message".
+ *	@return false if the message could not be serialized.
+ */
+inline bool serializeStreamMessage(google::protobuf::Any& message, const std::string& streamTypeUrl,
+				   grpc::ByteBuffer& buffer)
+{
+	if (!streamTypeUrl.empty() && message.type_url() == streamTypeUrl) message.clear_type_url();
+
+	bool ownBuffer = false;
+	return grpc::SerializationTraits<google::protobuf::Any>::Serialize(message, &buffer, &ownBuffer).ok();
+}
+
+/// Same as above for a message that cannot be modified: it is only copied if its type URL must be removed.
+inline bool serializeStreamMessage(const google::protobuf::Any& message, const std::string& streamTypeUrl,
+				   grpc::ByteBuffer& buffer)
+{
+	if (!streamTypeUrl.empty() && message.type_url() == streamTypeUrl)
+	{
+		google::protobuf::Any untypedMessage = message;
+		return serializeStreamMessage(untypedMessage, streamTypeUrl, buffer);
+	}
+
+	bool ownBuffer = false;
+	return grpc::SerializationTraits<google::protobuf::Any>::Serialize(message, &buffer, &ownBuffer).ok();
+}
+
+/**
+ *	Parses a message read from a stream, and restores the type URL of the stream's type if it was omitted.
+ *	The content of "buffer" is consumed.
+ *	@return false if the message could not be parsed.
+ */
+inline bool parseStreamMessage(grpc::ByteBuffer& buffer, const std::string& streamTypeUrl,
+			       google::protobuf::Any& message)
+{
+	if (!grpc::SerializationTraits<google::protobuf::Any>::Deserialize(&buffer, &message).ok()) return false;
+
+	if (message.type_url().empty() && !streamTypeUrl.empty()) message.set_type_url(streamTypeUrl);
+	return true;
+}
+
+/// Tag of the type URL of a serialized google.protobuf.Any (field 1, length-delimited).
+const uint8_t STREAM_TYPE_URL_TAG = (1 << 3) | 2;
+
+/**
+ *	Reads the type URL of a serialized message without parsing it. It is the first field of the message, or it was
+ *	omitted if the message is of the stream's type.
+ *	@return false if the buffer could not be read.
+ */
+inline bool readStreamTypeUrl(const grpc::ByteBuffer& buffer, const std::string& streamTypeUrl, std::string& typeUrl)
+{
+	std::vector<grpc::Slice> slices;
+	if (!buffer.Valid() || !buffer.Dump(&slices).ok()) return false;
+
+	// only the first slices are copied, until they contain the type URL
+	std::string head;
+	auto slice = slices.begin();
+	auto readHead = [&head, &slice, &slices](size_t size) {
+		for (; slice != slices.end() && head.size() < size; ++slice)
+			head.append(reinterpret_cast<const char*>(slice->begin()), slice->size());
+		return head.size() >= size;
+	};
+
+	typeUrl = streamTypeUrl;
+	if (!readHead(1) || static_cast<uint8_t>(head[0]) != STREAM_TYPE_URL_TAG) return true;
+
+	// the length of the URL is a varint
+	size_t length = 0;
+	size_t offset = 1;
+	for (int shift = 0;; shift += 7)
+	{
+		if (shift > 28 || !readHead(offset + 1)) return false;
+
+		uint8_t byte = static_cast<uint8_t>(head[offset++]);
+		length |= static_cast<size_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) break;
+	}
+
+	if (!readHead(offset + length)) return false;
+	typeUrl = head.substr(offset, length);
+	return true;
+}
+
+/**
+ *	Sequence numbers (see ConnectionConfigurationGRPC::setSequenceNumbersEnabled) are appended to a serialized
+ *	message as a fixed64 field that google.protobuf.Any does not define. Parsers keep it as an unknown field,
+ *	and raw readers find it in the last bytes of the message. When a message is stamped again (by a relay), the
+ *	last number is the valid one.
+ */
+const int STREAM_SEQUENCE_NUMBER_FIELD = 15;
+const size_t STREAM_SEQUENCE_NUMBER_SIZE = 9; // tag and fixed64 value
+const uint8_t STREAM_SEQUENCE_NUMBER_TAG = (STREAM_SEQUENCE_NUMBER_FIELD << 3) | 1;
+
+/// Appends "sequenceNumber" to a serialized message. The bytes of the message are shared, not copied.
+/// @return false if the buffer could not be read.
+inline bool appendSequenceNumber(grpc::ByteBuffer& buffer, uint64_t sequenceNumber)
+{
+	std::vector<grpc::Slice> slices;
+	if (buffer.Valid() && !buffer.Dump(&slices).ok()) return false;
+
+	uint8_t stamp[STREAM_SEQUENCE_NUMBER_SIZE];
+	stamp[0] = STREAM_SEQUENCE_NUMBER_TAG;
+	for (size_t i = 0; i < 8; ++i) stamp[i + 1] = static_cast<uint8_t>(sequenceNumber >> (8 * i));
+	slices.emplace_back(stamp, sizeof(stamp));
+
+	grpc::ByteBuffer stamped(slices.data(), slices.size());
+	buffer.Swap(&stamped);
+	return true;
+}
+
+/// Reads the sequence number at the end of a serialized message, without parsing it.
+/// @return false if the message does not end with a sequence number.
+inline bool readSequenceNumber(const grpc::ByteBuffer& buffer, uint64_t& sequenceNumber)
+{
+	std::vector<grpc::Slice> slices;
+	if (!buffer.Valid() || !buffer.Dump(&slices).ok()) return false;
+
+	std::string tail;
+	for (auto it = slices.rbegin(); it != slices.rend() && tail.size() < STREAM_SEQUENCE_NUMBER_SIZE; ++it)
+		tail.insert(0, reinterpret_cast<const char*>(it->begin()), it->size());
+	if (tail.size() < STREAM_SEQUENCE_NUMBER_SIZE) return false;
+
+	const uint8_t* stamp =
+	    reinterpret_cast<const uint8_t*>(tail.data()) + tail.size() - STREAM_SEQUENCE_NUMBER_SIZE;
+	if (stamp[0] != STREAM_SEQUENCE_NUMBER_TAG) return false;
+
+	sequenceNumber = 0;
+	for (size_t i = 0; i < 8; ++i) sequenceNumber |= static_cast<uint64_t>(stamp[i + 1]) << (8 * i);
+	return true;
+}
+
+/// Removes the sequence numbers of a parsed message, so that they do not reach the application.
+/// @return false if the message has no sequence number.
+inline bool takeSequenceNumber(google::protobuf::Any& message, uint64_t& sequenceNumber)
+{
+	auto fields = message.GetReflection()->MutableUnknownFields(&message);
+	bool found = false;
+	for (int i = 0; i < fields->field_count(); ++i)
+	{
+		const auto& field = fields->field(i);
+		if (field.number() == STREAM_SEQUENCE_NUMBER_FIELD &&
+		    field.type() == google::protobuf::UnknownField::TYPE_FIXED64)
+		{
+			sequenceNumber = field.fixed64();
+			found = true;
+		}
+	}
+
+	if (found) fields->DeleteByNumber(STREAM_SEQUENCE_NUMBER_FIELD);
+	return found;
+}
+
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_STREAMTYPE_HPP
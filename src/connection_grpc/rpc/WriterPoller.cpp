@@ -0,0 +1,96 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "WriterPoller.hpp"
+
+#include <map>
+
+using namespace ghost::internal;
+
+const std::chrono::milliseconds WriterPoller::POLL_PERIOD = std::chrono::milliseconds(10);
+
+std::shared_ptr<WriterPoller> WriterPoller::get(const std::shared_ptr<ghost::ThreadPool>& threadPool)
+{
+	static std::mutex pollersMutex;
+	static std::map<const ghost::ThreadPool*, std::weak_ptr<WriterPoller>> pollers;
+
+	std::lock_guard<std::mutex> lock(pollersMutex);
+	auto poller = pollers[threadPool.get()].lock();
+	if (!poller)
+	{
+		// the poller holds the thread pool: the entry cannot be reused by another pool while it exists
+		poller = std::make_shared<WriterPoller>(threadPool);
+		pollers[threadPool.get()] = poller;
+	}
+	return poller;
+}
+
+WriterPoller::WriterPoller(const std::shared_ptr<ghost::ThreadPool>& threadPool)
+    : _threadPool(threadPool), _nextId(0)
+{
+	_executor = _threadPool->makeScheduledExecutor();
+	_executor->scheduleAtFixedRate(std::bind(&WriterPoller::pollAll, this), POLL_PERIOD);
+}
+
+WriterPoller::~WriterPoller()
+{
+	_executor->stop();
+}
+
+size_t WriterPoller::add(const std::function<void()>& poll)
+{
+	auto writer = std::make_shared<Writer>();
+	writer->poll = poll;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	size_t id = _nextId++;
+	_writers[id] = writer;
+	return id;
+}
+
+void WriterPoller::remove(size_t id)
+{
+	std::shared_ptr<Writer> writer;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _writers.find(id);
+		if (it == _writers.end()) return;
+
+		writer = it->second;
+		_writers.erase(it);
+	}
+
+	// waits for a call in progress on another thread, a poll that copied the writer before will skip it
+	std::lock_guard<std::recursive_mutex> lock(writer->mutex);
+	writer->removed = true;
+}
+
+void WriterPoller::pollAll()
+{
+	std::vector<std::shared_ptr<Writer>> writers;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		writers.reserve(_writers.size());
+		for (const auto& writer : _writers) writers.push_back(writer.second);
+	}
+
+	for (const auto& writer : writers)
+	{
+		std::unique_lock<std::recursive_mutex> lock(writer->mutex, std::try_to_lock);
+		if (lock && !writer->removed) writer->poll();
+	}
+}
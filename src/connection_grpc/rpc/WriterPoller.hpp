@@ -0,0 +1,79 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_INTERNAL_NETWORK_WRITERPOLLER_HPP
+#define GHOST_INTERNAL_NETWORK_WRITERPOLLER_HPP
+
+#include <functional>
+#include <ghost/module/ThreadPool.hpp>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Periodically checks the writer sinks of all the connections using the same thread pool.
+ *	The ghost::WriterSink does not notify new messages, the writers must look for them: instead of one
+ *	ghost::ScheduledExecutor per connection, a single executor calls the registered writers one after
+ *	the other.
+ *	The writers are called without the lock of the poller, so that they can be removed while a poll is in
+ *	progress, including from the writer itself. The writers must not block: one that is busy checks again at
+ *	the next poll instead of delaying the other ones.
+ *	The poller is shared through "get" and deleted with the last writer that uses it.
+ */
+class WriterPoller
+{
+public:
+	/// Returns the poller of this thread pool, and creates it if it does not exist.
+	static std::shared_ptr<WriterPoller> get(const std::shared_ptr<ghost::ThreadPool>& threadPool);
+
+	WriterPoller(const std::shared_ptr<ghost::ThreadPool>& threadPool);
+	~WriterPoller();
+
+	/// Registers a function called at every poll. @return an identifier for "remove".
+	size_t add(const std::function<void()>& poll);
+	/// Unregisters a function, it is not being called anymore when this returns. If it is being called by
+	/// another thread, waits for the call to return.
+	void remove(size_t id);
+
+private:
+	struct Writer
+	{
+		std::function<void()> poll;
+		// held during a call, recursive so that the function can remove itself
+		std::recursive_mutex mutex;
+		bool removed = false;
+	};
+
+	void pollAll();
+
+	static const std::chrono::milliseconds POLL_PERIOD;
+
+	std::shared_ptr<ghost::ThreadPool> _threadPool;
+	std::shared_ptr<ghost::ScheduledExecutor> _executor;
+	std::mutex _mutex;
+	std::unordered_map<size_t, std::shared_ptr<Writer>> _writers;
+	size_t _nextId;
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_WRITERPOLLER_HPP
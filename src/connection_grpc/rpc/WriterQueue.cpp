@@ -0,0 +1,339 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "WriterQueue.hpp"
+
+#include <algorithm>
+
+#include "StreamType.hpp"
+
+using namespace ghost::internal;
+
+const size_t WriterQueue::NO_LANE = static_cast<size_t>(-1);
+
+WriterQueue::WriterQueue(const std::shared_ptr<const StreamSettings>& settings)
+    : _settings(settings)
+    , _lowWatermark(settings->writerHighWatermark == 0
+			? 0
+			: std::min(settings->writerLowWatermark, settings->writerHighWatermark - 1))
+    , _lowWatermarkBytes(settings->writerHighWatermarkBytes == 0
+			     ? 0
+			     : std::min(settings->writerLowWatermarkBytes, settings->writerHighWatermarkBytes - 1))
+    , _lanes(static_cast<size_t>(Priority::BULK) + 1)
+    , _skipped(_lanes.size(), 0)
+    , _selectedLane(NO_LANE)
+    , _size(0)
+    , _bytes(0)
+    , _expired(0)
+    , _sequenceNumber(0)
+    , _writable(true)
+    , _sinkPending(false)
+    , _coalescing(false)
+{
+}
+
+WriterQueue::WriterQueue(size_t highWatermark, size_t lowWatermark, size_t highWatermarkBytes,
+			 size_t lowWatermarkBytes, const std::chrono::microseconds& maxCoalescingDelay,
+			 const std::string& streamTypeUrl, const std::map<std::string, Priority>& priorities,
+			 size_t starvationLimit, const std::map<std::string, std::chrono::milliseconds>& timesToLive,
+			 bool sequenceNumbers)
+    : WriterQueue(makeSettings(highWatermark, lowWatermark, highWatermarkBytes, lowWatermarkBytes, maxCoalescingDelay,
+			       streamTypeUrl, priorities, starvationLimit, timesToLive, sequenceNumbers))
+{
+}
+
+bool WriterQueue::fill(ghost::WriterSink& sink)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	// expired messages make room for the ones waiting in the sink
+	dropExpired();
+
+	google::protobuf::Any message;
+	_sinkPending = false;
+	while (sink.get(message, std::chrono::milliseconds(0)))
+	{
+		// a full queue still takes the control messages, the other ones stay in the sink
+		Priority priority = getPriority(message.type_url());
+		if (!_writable && priority != Priority::CONTROL)
+		{
+			_sinkPending = true;
+			break;
+		}
+
+		// the message leaves the sink: a blocking writer waiting for it is released
+		sink.pop();
+
+		// only invalid messages fail to serialize, they are dropped
+		grpc::ByteBuffer buffer;
+		if (!serializeStreamMessage(message, _settings->streamTypeUrl, buffer)) continue;
+
+		// the numbers follow the order in which the application wrote the messages
+		if (_settings->sequenceNumbers)
+		{
+			if (!appendSequenceNumber(buffer, _sequenceNumber + 1)) continue;
+			_sequenceNumber++;
+		}
+
+		enqueue(buffer, priority, getTimeToLive(_settings->timesToLive, message.type_url()));
+	}
+
+	return _size > 0;
+}
+
+bool WriterQueue::push(const grpc::ByteBuffer& message, Priority priority,
+		       const std::chrono::milliseconds& timeToLive)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_writable && priority != Priority::CONTROL) return false;
+
+	enqueue(message, priority, timeToLive);
+	return true;
+}
+
+bool WriterQueue::front(grpc::ByteBuffer& message) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	size_t lane = _selectedLane != NO_LANE ? _selectedLane : nextLane();
+	if (lane == NO_LANE) return false;
+
+	message = _lanes[lane].front().message;
+	return true;
+}
+
+bool WriterQueue::front(grpc::ByteBuffer& message, bool& bufferHint)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	// the hint depends on the messages that are still waiting once the expired ones are dropped
+	dropExpired();
+	if (_selectedLane == NO_LANE) _selectedLane = nextLane();
+	if (_selectedLane == NO_LANE) return false;
+
+	message = _lanes[_selectedLane].front().message;
+
+	// the last waiting message always flushes what was buffered before it. The messages left in the sink by a
+	// full queue are waiting too: they enter the queue as soon as this one is written
+	bufferHint = _size > 1 || _sinkPending;
+	if (bufferHint && _settings->writerMaxCoalescingDelay.count() > 0)
+	{
+		auto now = std::chrono::steady_clock::now();
+		if (!_coalescing)
+			_coalescingStart = now;
+		else if (now - _coalescingStart >= _settings->writerMaxCoalescingDelay)
+			bufferHint = false;
+	}
+	_coalescing = bufferHint;
+
+	return true;
+}
+
+void WriterQueue::pop()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	size_t lane = _selectedLane != NO_LANE ? _selectedLane : nextLane();
+	_selectedLane = NO_LANE;
+	if (lane == NO_LANE) return;
+
+	_bytes -= std::min(_bytes, _lanes[lane].front().message.Length());
+	_size--;
+	_lanes[lane].pop_front();
+
+	// the lower lanes that are waiting were skipped once more
+	_skipped[lane] = 0;
+	for (size_t i = lane + 1; i < _lanes.size(); ++i)
+		if (!_lanes[i].empty()) _skipped[i]++;
+
+	updateWritable();
+}
+
+void WriterQueue::clear()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (auto& lane : _lanes) lane.clear();
+	std::fill(_skipped.begin(), _skipped.end(), 0);
+	_selectedLane = NO_LANE;
+	_size = 0;
+	_bytes = 0;
+	_sinkPending = false;
+	_coalescing = false;
+	updateWritable();
+}
+
+size_t WriterQueue::size() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _size;
+}
+
+size_t WriterQueue::bytes() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _bytes;
+}
+
+size_t WriterQueue::countExpired() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _expired;
+}
+
+WriterQueue::Priority WriterQueue::getPriority(const std::string& typeUrl) const
+{
+	return getPriority(_settings->priorities, typeUrl);
+}
+
+WriterQueue::Priority WriterQueue::getPriority(const std::map<std::string, Priority>& priorities,
+					       const std::string& typeUrl)
+{
+	if (priorities.empty()) return Priority::NORMAL;
+
+	auto it = priorities.find(getTypeName(typeUrl));
+	if (it == priorities.end()) return Priority::NORMAL;
+
+	return it->second;
+}
+
+std::chrono::milliseconds WriterQueue::getTimeToLive(
+    const std::map<std::string, std::chrono::milliseconds>& timesToLive, const std::string& typeUrl)
+{
+	if (timesToLive.empty()) return std::chrono::milliseconds(0);
+
+	auto it = timesToLive.find(getTypeName(typeUrl));
+	if (it == timesToLive.end()) return std::chrono::milliseconds(0);
+
+	return it->second;
+}
+
+bool WriterQueue::isWritable() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _writable;
+}
+
+WriterQueue::Status WriterQueue::awaitWritable(const std::chrono::milliseconds& timeout)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	if (_writable) return Status::WRITABLE;
+	if (timeout.count() <= 0) return Status::WOULD_BLOCK;
+
+	bool writable = _writableCondition.wait_for(lock, timeout, [this] { return _writable; });
+	return writable ? Status::WRITABLE : Status::TIMEOUT;
+}
+
+std::shared_ptr<const StreamSettings> WriterQueue::makeSettings(
+    size_t highWatermark, size_t lowWatermark, size_t highWatermarkBytes, size_t lowWatermarkBytes,
+    const std::chrono::microseconds& maxCoalescingDelay, const std::string& streamTypeUrl,
+    const std::map<std::string, Priority>& priorities, size_t starvationLimit,
+    const std::map<std::string, std::chrono::milliseconds>& timesToLive, bool sequenceNumbers)
+{
+	auto settings = std::make_shared<StreamSettings>();
+	settings->writerHighWatermark = highWatermark;
+	settings->writerLowWatermark = lowWatermark;
+	settings->writerHighWatermarkBytes = highWatermarkBytes;
+	settings->writerLowWatermarkBytes = lowWatermarkBytes;
+	settings->writerMaxCoalescingDelay = maxCoalescingDelay;
+	settings->streamTypeUrl = streamTypeUrl;
+	settings->priorities = priorities;
+	settings->starvationLimit = starvationLimit;
+	settings->timesToLive = timesToLive;
+	settings->sequenceNumbers = sequenceNumbers;
+	return settings;
+}
+
+std::string WriterQueue::getTypeName(const std::string& typeUrl)
+{
+	// the full name of the type follows the last '/' of the URL
+	return typeUrl.substr(typeUrl.find_last_of('/') + 1);
+}
+
+void WriterQueue::enqueue(const grpc::ByteBuffer& message, Priority priority,
+			  const std::chrono::milliseconds& timeToLive)
+{
+	Entry entry;
+	entry.message = message;
+	entry.deadline = timeToLive.count() > 0 ? std::chrono::steady_clock::now() + timeToLive
+						: std::chrono::steady_clock::time_point::max();
+
+	_bytes += message.Length();
+	_size++;
+	_lanes[static_cast<size_t>(priority)].push_back(std::move(entry));
+	updateWritable();
+}
+
+void WriterQueue::dropExpired()
+{
+	auto now = std::chrono::steady_clock::now();
+	bool dropped = false;
+	for (size_t lane = 0; lane < _lanes.size(); ++lane)
+	{
+		auto& messages = _lanes[lane];
+		// the message returned by "front" is being written, it is removed by "pop"
+		size_t first = lane == _selectedLane ? 1 : 0;
+		while (messages.size() > first && messages[first].deadline <= now)
+		{
+			// After a corked write, the last waiting message is written even if it expired: it is the write
+			// that flushes the stream, without it the corked messages would wait for the next message.
+			size_t waiting = _selectedLane != NO_LANE ? _size - 1 : _size;
+			if (_coalescing && waiting == 1) break;
+
+			_bytes -= std::min(_bytes, messages[first].message.Length());
+			_size--;
+			_expired++;
+			messages.erase(messages.begin() + first);
+			dropped = true;
+		}
+		if (messages.empty()) _skipped[lane] = 0;
+	}
+
+	if (dropped) updateWritable();
+}
+
+void WriterQueue::updateWritable()
+{
+	size_t highWatermark = _settings->writerHighWatermark;
+	size_t highWatermarkBytes = _settings->writerHighWatermarkBytes;
+	if (_writable)
+	{
+		// stop accepting messages as soon as one of the high watermarks is reached
+		_writable = (highWatermark == 0 || _size < highWatermark) &&
+			    (highWatermarkBytes == 0 || _bytes < highWatermarkBytes);
+	}
+	else if ((highWatermark == 0 || _size <= _lowWatermark) &&
+		 (highWatermarkBytes == 0 || _bytes <= _lowWatermarkBytes))
+	{
+		// only accept messages again once both low watermarks are reached, to avoid toggling on every write
+		_writable = true;
+		_writableCondition.notify_all();
+	}
+}
+
+size_t WriterQueue::nextLane() const
+{
+	size_t lane = 0;
+	while (lane < _lanes.size() && _lanes[lane].empty()) lane++;
+	if (lane == _lanes.size()) return NO_LANE;
+	if (_settings->starvationLimit == 0) return lane;
+
+	// a lower lane that was skipped too many times goes first, the one that waited the longest first
+	size_t starved = lane;
+	for (size_t i = lane + 1; i < _lanes.size(); ++i)
+	{
+		if (!_lanes[i].empty() && _skipped[i] >= _settings->starvationLimit &&
+		    (starved == lane || _skipped[i] > _skipped[starved]))
+			starved = i;
+	}
+	return starved;
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_INTERNAL_NETWORK_WRITERQUEUE_HPP
+#define GHOST_INTERNAL_NETWORK_WRITERQUEUE_HPP
+
+#include <google/protobuf/any.pb.h>
+#include <grpcpp/support/byte_buffer.h>
+
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <ghost/connection/WriterSink.hpp>
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
+#include <ghost/connection_grpc/ConnectionControlGRPC.hpp>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "StreamSettings.hpp"
+
+namespace ghost
+{
+namespace internal
+{
+/**
+ *	Bounded queue of the messages waiting to be written by an RPC.
+ *	Messages are moved from the connection's writer sink into this queue until the high watermark
+ *	(in messages or in bytes) is reached. The queue then stops accepting messages until enough
+ *	RPCWrite operations completed to bring it below both low watermarks.
+ *	A watermark of 0 disables the corresponding limit.
+ *	Messages are serialized when they enter the queue: it holds the bytes written to the stream, which raw writers
+ *	(relays) can also push directly.
+ *
+ *	The queue also decides when consecutive writes are coalesced: while more messages are waiting behind the
+ *	one being written, in the queue or in the sink that it could not take, the write is buffered by gRPC and only
+ *	the last one flushes the stream. A maximum coalescing delay forces a flush when messages were buffered for
+ *	longer than this delay.
+ *
+ *	The messages wait in one lane per priority class (see ghost::ConnectionConfigurationGRPC::MessagePriority),
+ *	and the next message is taken from the highest class that has messages, unless a lower class has been
+ *	skipped "starvationLimit" times in a row. CONTROL messages are moved from the sink even if the queue is full.
+ *
+ *	Messages whose type has a time to live (see ghost::ConnectionConfigurationGRPC::setMessageTimeToLive) expire
+ *	once they waited longer than this time in the queue: the expired messages are dropped, and counted, when the
+ *	queue is filled and before the next message is written. After a corked write, the last waiting message is
+ *	never dropped, so that a write flushes the stream.
+ *
+ *	With "sequenceNumbers", the messages taken from the sink are stamped with consecutive numbers (see
+ *	ghost::ConnectionConfigurationGRPC::setSequenceNumbersEnabled). Pushed messages are already stamped by
+ *	their writer.
+ *
+ *	The settings are shared, not copied: the queues of a server's connections all refer to the same ones.
+ */
+class WriterQueue
+{
+public:
+	using Status = ghost::ConnectionControlGRPC::WriterStatus;
+	using Priority = ghost::ConnectionConfigurationGRPC::MessagePriority;
+
+	WriterQueue(const std::shared_ptr<const StreamSettings>& settings);
+	WriterQueue(size_t highWatermark = 0, size_t lowWatermark = 0, size_t highWatermarkBytes = 0,
+		    size_t lowWatermarkBytes = 0,
+		    const std::chrono::microseconds& maxCoalescingDelay = std::chrono::microseconds(0),
+		    const std::string& streamTypeUrl = "",
+		    const std::map<std::string, Priority>& priorities = std::map<std::string, Priority>(),
+		    size_t starvationLimit = 0,
+		    const std::map<std::string, std::chrono::milliseconds>& timesToLive =
+			std::map<std::string, std::chrono::milliseconds>(),
+		    bool sequenceNumbers = false);
+
+	/// Moves messages from the sink into this queue until it is full.
+	/// @return true if the queue contains at least one message.
+	bool fill(ghost::WriterSink& sink);
+	/// Appends an already serialized message. The buffer is shared, not copied.
+	/// @param timeToLive the message expires after this time, 0 if it does not expire.
+	/// @return false if the queue is full and the message was not appended. As in "fill", CONTROL messages are
+	/// always appended.
+	bool push(const grpc::ByteBuffer& message, Priority priority = Priority::NORMAL,
+		  const std::chrono::milliseconds& timeToLive = std::chrono::milliseconds(0));
+	/// Copies the next message to write into "message". The copy shares the buffer of the queue.
+	/// @return false if the queue is empty.
+	bool front(grpc::ByteBuffer& message) const;
+	/// Same as "front" after the expired messages were dropped, and sets "bufferHint" to true if this message
+	/// should not be flushed right away because more messages are waiting and the maximum coalescing delay did
+	/// not expire.
+	/// The message stays the next one until "pop" is called, even if messages of a higher class arrive.
+	bool front(grpc::ByteBuffer& message, bool& bufferHint);
+	/// Removes the next message of the queue, after it was written.
+	void pop();
+	/// Removes all the messages and releases the threads waiting in "awaitWritable".
+	void clear();
+
+	size_t size() const;
+	size_t bytes() const;
+	/// @return the number of messages that expired before they were written.
+	size_t countExpired() const;
+	/// @return the priority class of the messages of this type ("type.googleapis.com/name" or "name").
+	Priority getPriority(const std::string& typeUrl) const;
+	/// @return the priority class of the messages of this type in "priorities", NORMAL if it is not listed.
+	static Priority getPriority(const std::map<std::string, Priority>& priorities, const std::string& typeUrl);
+	/// @return the time to live of the messages of this type in "timesToLive", 0 if it is not listed.
+	static std::chrono::milliseconds getTimeToLive(
+	    const std::map<std::string, std::chrono::milliseconds>& timesToLive, const std::string& typeUrl);
+	bool isWritable() const;
+	/// Blocks until the queue accepts new messages, or until the timeout expires.
+	Status awaitWritable(const std::chrono::milliseconds& timeout);
+
+private:
+	struct Entry
+	{
+		grpc::ByteBuffer message;
+		std::chrono::steady_clock::time_point deadline; // time_point::max() if the message does not expire
+	};
+
+	static const size_t NO_LANE;
+
+	static std::shared_ptr<const StreamSettings> makeSettings(
+	    size_t highWatermark, size_t lowWatermark, size_t highWatermarkBytes, size_t lowWatermarkBytes,
+	    const std::chrono::microseconds& maxCoalescingDelay, const std::string& streamTypeUrl,
+	    const std::map<std::string, Priority>& priorities, size_t starvationLimit,
+	    const std::map<std::string, std::chrono::milliseconds>& timesToLive, bool sequenceNumbers);
+
+	/// @return the full name of the type of a type URL ("type.googleapis.com/name" or "name").
+	static std::string getTypeName(const std::string& typeUrl);
+
+	void enqueue(const grpc::ByteBuffer& message, Priority priority, const std::chrono::milliseconds& timeToLive);
+	/// Drops the expired messages at the front of the lanes, except the one returned by "front", and except the
+	/// last waiting message after a corked write.
+	void dropExpired();
+	void updateWritable();
+	/// @return the lane of the next message, NO_LANE if the queue is empty.
+	size_t nextLane() const;
+
+	const std::shared_ptr<const StreamSettings> _settings;
+	const size_t _lowWatermark;      // below the high watermark
+	const size_t _lowWatermarkBytes; // below the high watermark in bytes
+
+	mutable std::mutex _mutex;
+	std::condition_variable _writableCondition;
+	std::vector<std::deque<Entry>> _lanes; // indexed by priority class
+	std::vector<size_t> _skipped; // number of messages taken from higher lanes while the lane was waiting
+	size_t _selectedLane;         // lane of the message returned by "front", until it is popped
+	size_t _size;
+	size_t _bytes;
+	size_t _expired;
+	uint64_t _sequenceNumber; // last number stamped
+	bool _writable;
+	bool _sinkPending; // the last "fill" left messages in the sink because the queue was full
+	bool _coalescing;
+	std::chrono::steady_clock::time_point _coalescingStart;
+};
+} // namespace internal
+} // namespace ghost
+
+#endif // GHOST_INTERNAL_NETWORK_WRITERQUEUE_HPP
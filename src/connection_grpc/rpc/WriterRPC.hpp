@@ -17,11 +17,19 @@
 #ifndef GHOST_INTERNAL_NETWORK_WRITERRPC_HPP
 #define GHOST_INTERNAL_NETWORK_WRITERRPC_HPP
 
+#include <grpcpp/support/byte_buffer.h>
+
 #include <ghost/connection/WriterSink.hpp>
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
+#include <condition_variable>
 #include <ghost/module/ThreadPool.hpp>
 #include <memory>
+#include <mutex>
 
 #include "RPCWrite.hpp"
+#include "StreamSettings.hpp"
+#include "WriterPoller.hpp"
+#include "WriterQueue.hpp"
 
 namespace ghost
 {
@@ -31,39 +39,73 @@ namespace internal
  *	Base class for a writing connection (IncomingRPC and OutgoingRPC).
  *	Manages the RPCWrite calls and creates them when messages to be sent are received through
  *	the writerSink.
+ *	Messages are staged in a ghost::internal::WriterQueue bounded by the watermarks of the configuration:
+ *	when the queue is full, the writerSink is not emptied anymore until the pending writes complete.
+ *	The writerSink is checked periodically by the ghost::internal::WriterPoller shared by all the connections.
  */
 template <typename ReaderWriter, typename ContextType>
 class WriterRPC
 {
 public:
-	WriterRPC(const std::shared_ptr<ghost::ThreadPool>& threadPool);
-	virtual ~WriterRPC() = default;
+	WriterRPC(const std::shared_ptr<ghost::ThreadPool>& threadPool,
+		  const std::shared_ptr<const StreamSettings>& settings);
+	virtual ~WriterRPC();
 
 	void initWriter(std::shared_ptr<RPC<ReaderWriter, ContextType>> rpc,
 			const std::shared_ptr<ghost::WriterSink>& sink = nullptr);
 	void startWriter(const std::shared_ptr<ghost::WriterSink>& sink = nullptr);
+	/// Waits until the writes of the previous (finished) RPC completed, then writes to "rpc".
+	/// The messages of the writer queue and of the writerSink are kept.
+	void switchWriter(std::shared_ptr<RPC<ReaderWriter, ContextType>> rpc);
 	void drainWriter();
 	void stopWriter();
+	/// Stages the messages of the writerSink right away instead of waiting for the next periodic check.
+	void flushWriter();
+	/// Writes an already serialized message (raw mode, used by relays). The message bypasses the writerSink:
+	/// it can overtake the messages that are still in the sink. The writer queue applies its watermarks.
+	/// @return false if the writer queue is full, the caller can wait with "awaitWritable" and try again.
+	bool writeRaw(const grpc::ByteBuffer& message, WriterQueue::Priority priority = WriterQueue::Priority::NORMAL,
+		      const std::chrono::milliseconds& timeToLive = std::chrono::milliseconds(0));
+
+	/// Blocks until the writer queue accepts new messages, or until the timeout expires.
+	WriterQueue::Status awaitWritable(const std::chrono::milliseconds& timeout);
+	const std::shared_ptr<WriterQueue>& getWriterQueue() const;
 
 private:
+	/// Called by the poller: does nothing if the writer is busy, the poller is shared with other connections.
+	void pollWriter();
 	void startWriterTask();
+	/// Starts a write if none is in progress and messages are waiting, "_writerMutex" must be locked.
+	void startWriterOperation();
 	void restartWriter();
 
 	std::shared_ptr<RPC<ReaderWriter, ContextType>> _rpc;
 	std::shared_ptr<ghost::WriterSink> _writerSink;
+	std::shared_ptr<WriterQueue> _writerQueue;
 	std::shared_ptr<ghost::ThreadPool> _threadPool;
-	std::shared_ptr<ghost::ScheduledExecutor> _startWriterExecutor;
+	std::shared_ptr<WriterPoller> _poller;
+	size_t _pollerId;
 	std::mutex _writerMutex;
-	std::shared_ptr<RPCWrite<ReaderWriter, ContextType, google::protobuf::Any>> _activeWriterOperation;
-	std::shared_ptr<RPCWrite<ReaderWriter, ContextType, google::protobuf::Any>> _completedWriterOperation;
+	std::condition_variable _writerCondition; // notified when the active operation is reset
+	std::shared_ptr<RPCWrite<ReaderWriter, ContextType>> _activeWriterOperation;
+	std::shared_ptr<RPCWrite<ReaderWriter, ContextType>> _completedWriterOperation;
 };
 
 /// template definition
 
 template <typename ReaderWriter, typename ContextType>
-WriterRPC<ReaderWriter, ContextType>::WriterRPC(const std::shared_ptr<ghost::ThreadPool>& threadPool)
-    : _threadPool(threadPool)
+WriterRPC<ReaderWriter, ContextType>::WriterRPC(const std::shared_ptr<ghost::ThreadPool>& threadPool,
+						const std::shared_ptr<const StreamSettings>& settings)
+    : _writerQueue(std::make_shared<WriterQueue>(settings))
+    , _threadPool(threadPool)
+    , _pollerId(0)
+{
+}
+
+template <typename ReaderWriter, typename ContextType>
+WriterRPC<ReaderWriter, ContextType>::~WriterRPC()
 {
+	stopWriter();
 }
 
 template <typename ReaderWriter, typename ContextType>
@@ -79,43 +121,96 @@ void WriterRPC<ReaderWriter, ContextType>::startWriter(const std::shared_ptr<gho
 {
 	if (sink) _writerSink = sink;
 
-	if (_writerSink)
+	if (_writerSink && !_poller)
 	{
-		// Create an executor that checks that there is something to read, and create a RPCWrite if necessary
-		_startWriterExecutor = _threadPool->makeScheduledExecutor();
-		_startWriterExecutor->scheduleAtFixedRate(std::bind(&WriterRPC::startWriterTask, this),
-							  std::chrono::milliseconds(10));
+		// Periodically check that there is something to read, and create a RPCWrite if necessary
+		_poller = WriterPoller::get(_threadPool);
+		_pollerId = _poller->add(std::bind(&WriterRPC::pollWriter, this));
 	}
 }
 
+template <typename ReaderWriter, typename ContextType>
+void WriterRPC<ReaderWriter, ContextType>::switchWriter(std::shared_ptr<RPC<ReaderWriter, ContextType>> rpc)
+{
+	std::unique_lock<std::mutex> lock(_writerMutex);
+	// The last write of the previous RPC resets the active operation when its restart fails
+	_writerCondition.wait(lock, [this] { return !_activeWriterOperation; });
+	_rpc = rpc;
+}
+
 template <typename ReaderWriter, typename ContextType>
 void WriterRPC<ReaderWriter, ContextType>::drainWriter()
 {
 	if (_writerSink) _writerSink->drain();
+	_writerQueue->clear();
 }
 
 template <typename ReaderWriter, typename ContextType>
 void WriterRPC<ReaderWriter, ContextType>::stopWriter()
 {
-	if (_startWriterExecutor) _startWriterExecutor->stop();
+	if (_poller)
+	{
+		_poller->remove(_pollerId);
+		_poller.reset();
+	}
+}
+
+template <typename ReaderWriter, typename ContextType>
+void WriterRPC<ReaderWriter, ContextType>::flushWriter()
+{
+	if (_writerSink) startWriterTask();
+}
+
+template <typename ReaderWriter, typename ContextType>
+bool WriterRPC<ReaderWriter, ContextType>::writeRaw(const grpc::ByteBuffer& message,
+							WriterQueue::Priority priority,
+							const std::chrono::milliseconds& timeToLive)
+{
+	if (!_writerQueue->push(message, priority, timeToLive)) return false;
+
+	startWriterTask();
+	return true;
+}
+
+template <typename ReaderWriter, typename ContextType>
+WriterQueue::Status WriterRPC<ReaderWriter, ContextType>::awaitWritable(const std::chrono::milliseconds& timeout)
+{
+	return _writerQueue->awaitWritable(timeout);
+}
+
+template <typename ReaderWriter, typename ContextType>
+const std::shared_ptr<WriterQueue>& WriterRPC<ReaderWriter, ContextType>::getWriterQueue() const
+{
+	return _writerQueue;
+}
+
+template <typename ReaderWriter, typename ContextType>
+void WriterRPC<ReaderWriter, ContextType>::pollWriter()
+{
+	// a busy writer is starting or completing a write, which checks the queue by itself
+	std::unique_lock<std::mutex> lock(_writerMutex, std::try_to_lock);
+	if (lock) startWriterOperation();
 }
 
 template <typename ReaderWriter, typename ContextType>
 void WriterRPC<ReaderWriter, ContextType>::startWriterTask()
 {
 	std::unique_lock<std::mutex> lock(_writerMutex);
+	startWriterOperation();
+}
 
+template <typename ReaderWriter, typename ContextType>
+void WriterRPC<ReaderWriter, ContextType>::startWriterOperation()
+{
 	// Don't start anything if something is already in progress
 	if (_activeWriterOperation) return;
 
-	google::protobuf::Any message;
-
-	// Check if there are some messages to send
-	bool hasMessage = _writerSink->get(message, std::chrono::milliseconds(0));
+	// Check if there are some messages to send, and stage them as long as the queue is not full
+	bool hasMessage = _writerSink ? _writerQueue->fill(*_writerSink) : _writerQueue->size() > 0;
 	if (!hasMessage) return;
 
 	auto writerOperation =
-	    std::make_shared<RPCWrite<ReaderWriter, ContextType, google::protobuf::Any>>(_rpc, _writerSink);
+	    std::make_shared<RPCWrite<ReaderWriter, ContextType>>(_rpc, _writerQueue);
 
 	// Register a callback on completion, so that the operation can be restarted
 	writerOperation->onFinish(std::bind(&WriterRPC<ReaderWriter, ContextType>::restartWriter, this));
@@ -131,12 +226,18 @@ void WriterRPC<ReaderWriter, ContextType>::restartWriter()
 	std::unique_lock<std::mutex> lock(_writerMutex);
 	_completedWriterOperation = std::move(_activeWriterOperation);
 
+	// the completed write made room in the queue
+	if (_writerSink) _writerQueue->fill(*_writerSink);
+
 	auto writerOperation =
-	    std::make_shared<RPCWrite<ReaderWriter, ContextType, google::protobuf::Any>>(_rpc, _writerSink);
+	    std::make_shared<RPCWrite<ReaderWriter, ContextType>>(_rpc, _writerQueue);
 	writerOperation->onFinish(std::bind(&WriterRPC<ReaderWriter, ContextType>::restartWriter, this));
 
 	bool startResult = writerOperation->start();
-	if (startResult) _activeWriterOperation = writerOperation;
+	if (startResult)
+		_activeWriterOperation = writerOperation;
+	else
+		_writerCondition.notify_all();
 }
 
 } // namespace internal
@@ -20,12 +20,28 @@
 #include <ghost/connection/ConnectionManager.hpp>
 #include <ghost/connection/NetworkConnectionConfiguration.hpp>
 #include <ghost/connection/Writer.hpp>
+#include <ghost/connection_grpc/AsyncClientHandlerGRPC.hpp>
+#include <ghost/connection_grpc/BatchHandlerGRPC.hpp>
+#include <ghost/connection_grpc/CallClientGRPC.hpp>
+#include <ghost/connection_grpc/CallHandlerGRPC.hpp>
 #include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
+#include <ghost/connection_grpc/ConnectionControlGRPC.hpp>
 #include <ghost/connection_grpc/ConnectionGRPC.hpp>
+#include <ghost/connection_grpc/KeyedHandlerGRPC.hpp>
+#include <ghost/connection_grpc/RelayGRPC.hpp>
+#include <atomic>
+#include <future>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <thread>
 
+#include "../../src/connection_grpc/ClientGRPC.hpp"
+#include "../../src/connection_grpc/KeyedReaderSink.hpp"
 #include "../../src/connection_grpc/PublisherGRPC.hpp"
+#include "../../src/connection_grpc/ServerGRPC.hpp"
+#include "../../src/connection_grpc/SubscriberGRPC.hpp"
+#include "../../src/connection_grpc/rpc/OutgoingRPC.hpp"
 #include <ghost/module/ThreadPool.hpp>
 #include <ghost/module/ModuleBuilder.hpp>
 #include "../connection/ConnectionTestUtils.hpp"
@@ -179,7 +195,7 @@ protected:
 		}
 	}
 
-	void waitForSubscribers(int count)
+	void waitForSubscribers(size_t count)
 	{
 		auto now = std::chrono::steady_clock::now();
 		auto deadline = now + std::chrono::seconds(2);
@@ -208,6 +224,23 @@ protected:
 		}
 	}
 
+	void checkSubscribersReceivedMessages(int count, int messagesCount, const std::chrono::milliseconds& timeout)
+	{
+		auto now = std::chrono::steady_clock::now();
+		auto deadline = now + timeout;
+		for (int i = 0; i < count; ++i)
+		{
+			while (now < deadline &&
+			       (_doubleValueMessageWasHandledMap.find(i) == _doubleValueMessageWasHandledMap.end() ||
+				_doubleValueMessageWasHandledMap[i] < messagesCount))
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				now = std::chrono::steady_clock::now();
+			}
+			ASSERT_EQ(_doubleValueMessageWasHandledMap[i], messagesCount);
+		}
+	}
+
 	std::shared_ptr<ghost::ConnectionManager> _connectionManager;
 	std::shared_ptr<ghost::ThreadPool> _threadPool;
 	ghost::ConnectionConfigurationGRPC _config;
@@ -399,6 +432,190 @@ TEST_F(ConnectionGRPCTests, test_ServerGRPC_stops_When_clientHandlerReturnsFalse
 	ASSERT_TRUE(serverGrpc->isShutdown());
 }
 
+TEST_F(ConnectionGRPCTests, test_ClientGRPC_connectsConcurrently_When_startedAsynchronously)
+{
+	createServer(_config);
+	startServer();
+
+	int clientsCount = 10;
+	_clientsHandledExpected = clientsCount;
+	EXPECT_CALL(*_clientHandlerMock, configureClient(_)).Times(clientsCount);
+	EXPECT_CALL(*_clientHandlerMock, handle(_, _))
+	    .Times(clientsCount)
+	    .WillRepeatedly([&](std::shared_ptr<ghost::Client>, bool&) {
+		    _clientsHandledCount++;
+		    return true;
+	    });
+
+	// all the connections are dialed before any of them is awaited
+	std::atomic<int> callbacksCount{0};
+	std::vector<std::shared_future<bool>> results;
+	for (int i = 0; i < clientsCount; ++i)
+	{
+		auto client = _connectionManager->createClient(_config);
+		auto control = ghost::ConnectionControlGRPC::create(client);
+		ASSERT_TRUE(control);
+		results.push_back(control->startAsync([&](bool connected) {
+			if (connected) callbacksCount++;
+		}));
+		_clients.push_back(client);
+	}
+
+	for (int i = 0; i < clientsCount; ++i)
+	{
+		ASSERT_TRUE(results[i].get());
+		ASSERT_TRUE(_clients[i]->isRunning());
+	}
+	ASSERT_EQ(callbacksCount.load(), clientsCount);
+	waitForClientsHandled();
+}
+
+TEST_F(ConnectionGRPCTests, test_SubscriberGRPC_startAsyncFails_When_noServer)
+{
+	auto subscriber = _connectionManager->createSubscriber(_config);
+	auto control = ghost::ConnectionControlGRPC::create(subscriber);
+	ASSERT_TRUE(control);
+
+	std::promise<bool> callbackResult;
+	auto result = control->startAsync([&](bool connected) { callbackResult.set_value(connected); });
+	ASSERT_FALSE(result.get());
+	ASSERT_FALSE(callbackResult.get_future().get());
+	ASSERT_FALSE(subscriber->isRunning());
+}
+
+TEST_F(ConnectionGRPCTests, test_PublisherGRPC_starts_When_startedAsynchronously)
+{
+	createPublisher(_config);
+	auto control = ghost::ConnectionControlGRPC::create(_publisher);
+	ASSERT_TRUE(control);
+
+	bool callbackResult = false;
+	auto result = control->startAsync([&](bool started) { callbackResult = started; });
+	ASSERT_TRUE(result.get());
+	ASSERT_TRUE(callbackResult);
+	ASSERT_TRUE(_publisher->isRunning());
+}
+
+TEST_F(ConnectionGRPCTests, test_ServerGRPC_deletesClients_When_theirRPCFinished)
+{
+	createServer(_config);
+	startServer();
+
+	auto server = std::dynamic_pointer_cast<ghost::internal::ServerGRPC>(_server);
+	ASSERT_TRUE(server);
+	size_t idleClients = server->countClients();
+
+	startClients(_config, 5);
+	waitForClientsHandled();
+
+	// the handler did not keep the remote clients alive: they are deleted once their RPC finished
+	for (auto& client : _clients) client->stop();
+
+	auto now = std::chrono::steady_clock::now();
+	auto deadline = now + std::chrono::seconds(2);
+	while (server->countClients() > idleClients && now < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = std::chrono::steady_clock::now();
+	}
+	ASSERT_EQ(server->countClients(), idleClients);
+}
+
+/// Sends every received DoubleValue back to its client.
+class AsyncEchoHandler : public ghost::AsyncClientHandlerGRPC
+{
+public:
+	AsyncEchoHandler() : connected(0), messages(0), disconnected(0)
+	{
+	}
+
+	void onConnected(const std::shared_ptr<ghost::Client>& /*client*/) override
+	{
+		connected++;
+	}
+
+	void onMessage(const std::shared_ptr<ghost::Client>& client, const google::protobuf::Any& message) override
+	{
+		google::protobuf::DoubleValue value;
+		if (message.UnpackTo(&value)) client->getWriter<google::protobuf::DoubleValue>()->write(value);
+		messages++;
+	}
+
+	void onDisconnected(const std::shared_ptr<ghost::Client>& /*client*/) override
+	{
+		disconnected++;
+	}
+
+	std::atomic<int> connected;
+	std::atomic<int> messages;
+	std::atomic<int> disconnected;
+};
+
+TEST_F(ConnectionGRPCTests, test_ServerGRPC_handlesClientsPerMessage_When_asyncClientHandlerIsSet)
+{
+	_server = _connectionManager->createServer(_config);
+	ASSERT_TRUE(_server);
+	auto handler = std::make_shared<AsyncEchoHandler>();
+	_server->setClientHandler(handler);
+	startServer();
+
+	// more clients than threads in the pool: none of them reserves a thread
+	const int clientsCount = 64;
+	const int messagesCount = 10;
+	std::atomic<int> answers(0);
+	for (int i = 0; i < clientsCount; ++i)
+	{
+		auto client = _connectionManager->createClient(_config);
+		ASSERT_TRUE(client);
+		auto messageHandler = client->addMessageHandler();
+		messageHandler->addHandler<google::protobuf::DoubleValue>(
+		    [&answers](const google::protobuf::DoubleValue&) { answers++; });
+		ASSERT_TRUE(client->start());
+		_clients.push_back(client);
+	}
+
+	for (auto& client : _clients)
+	{
+		auto writer = client->getWriter<google::protobuf::DoubleValue>();
+		for (int i = 0; i < messagesCount; ++i)
+			writer->write(google::protobuf::DoubleValue::default_instance());
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	auto deadline = now + std::chrono::seconds(5);
+	while (answers < clientsCount * messagesCount && now < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = std::chrono::steady_clock::now();
+	}
+	ASSERT_EQ(handler->connected, clientsCount);
+	ASSERT_EQ(handler->messages, clientsCount * messagesCount);
+	ASSERT_EQ(answers, clientsCount * messagesCount);
+
+	for (auto& client : _clients) client->stop();
+
+	now = std::chrono::steady_clock::now();
+	deadline = now + std::chrono::seconds(2);
+	while (handler->disconnected < clientsCount && now < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = std::chrono::steady_clock::now();
+	}
+	ASSERT_EQ(handler->disconnected, clientsCount);
+
+	// the disconnected clients are deleted: only the posted connection requests remain
+	auto server = std::dynamic_pointer_cast<ghost::internal::ServerGRPC>(_server);
+	ASSERT_TRUE(server);
+	now = std::chrono::steady_clock::now();
+	deadline = now + std::chrono::seconds(2);
+	while (server->countClients() != server->getAcceptStatistics().outstanding && now < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = std::chrono::steady_clock::now();
+	}
+	ASSERT_EQ(server->countClients() - server->getAcceptStatistics().outstanding, 0u);
+}
+
 /* Subscriber / Publisher connections */
 
 TEST_F(ConnectionGRPCTests, test_SubscriberGRPC_connectsToPublisherGRPC)
@@ -436,6 +653,101 @@ TEST_F(ConnectionGRPCTests, test_PublisherGRPC_supportsMultipleClients)
 	checkSubscribersReceivedMessages(subscribersCount);
 }
 
+TEST_F(ConnectionGRPCTests, test_PublisherGRPC_sendsSerializedMessages_When_subscriberReadsInRawMode)
+{
+	createPublisher(_config);
+	startPublisher();
+
+	std::mutex receivedMutex;
+	std::vector<grpc::ByteBuffer> received;
+	auto subscriber = std::make_shared<ghost::internal::OutgoingRPC>(_threadPool, _config);
+	subscriber->setRawReaderHandler([&](const grpc::ByteBuffer& message) {
+		std::lock_guard<std::mutex> lock(receivedMutex);
+		received.push_back(message);
+		return true;
+	});
+	ASSERT_TRUE(subscriber->start());
+	waitForSubscribers(1);
+
+	google::protobuf::DoubleValue message;
+	message.set_value(3.5);
+	auto writer = _publisher->getWriter<google::protobuf::DoubleValue>();
+	ASSERT_TRUE(writer->write(message));
+
+	auto now = std::chrono::steady_clock::now();
+	auto deadline = now + std::chrono::seconds(1);
+	while (now < deadline)
+	{
+		{
+			std::lock_guard<std::mutex> lock(receivedMutex);
+			if (!received.empty()) break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = std::chrono::steady_clock::now();
+	}
+
+	subscriber->stop();
+
+	ASSERT_EQ(received.size(), 1u);
+	// the buffer holds the bytes of the published google.protobuf.Any
+	google::protobuf::Any anyMessage;
+	ASSERT_TRUE(grpc::SerializationTraits<google::protobuf::Any>::Deserialize(&received[0], &anyMessage).ok());
+	google::protobuf::DoubleValue receivedMessage;
+	ASSERT_TRUE(anyMessage.UnpackTo(&receivedMessage));
+	ASSERT_EQ(receivedMessage.value(), 3.5);
+}
+
+TEST_F(ConnectionGRPCTests, test_OutgoingRPC_pausesRawReads_When_handlerReturnsFalse)
+{
+	createPublisher(_config);
+	startPublisher();
+
+	std::atomic<size_t> received(0);
+	auto subscriber = std::make_shared<ghost::internal::OutgoingRPC>(_threadPool, _config);
+	subscriber->setRawReaderHandler([&](const grpc::ByteBuffer&) {
+		received++;
+		return false;
+	});
+	ASSERT_TRUE(subscriber->start());
+	waitForSubscribers(1);
+
+	auto writer = _publisher->getWriter<google::protobuf::DoubleValue>();
+	ASSERT_TRUE(writer->write(google::protobuf::DoubleValue::default_instance()));
+	ASSERT_TRUE(writer->write(google::protobuf::DoubleValue::default_instance()));
+
+	// the second message waits in the stream until the reads are resumed
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	ASSERT_EQ(received.load(), 1u);
+
+	subscriber->resumeReader();
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+	while (received < 2 && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	subscriber->stop();
+	ASSERT_EQ(received.load(), 2u);
+}
+
+TEST_F(ConnectionGRPCTests, test_StreamType_readsTypeUrl_When_messageIsSerialized)
+{
+	google::protobuf::Any message;
+	message.PackFrom(google::protobuf::DoubleValue::default_instance());
+	std::string streamTypeUrl = "type.googleapis.com/google.protobuf.StringValue";
+
+	grpc::ByteBuffer buffer;
+	ASSERT_TRUE(ghost::internal::serializeStreamMessage(message, streamTypeUrl, buffer));
+	std::string typeUrl;
+	ASSERT_TRUE(ghost::internal::readStreamTypeUrl(buffer, streamTypeUrl, typeUrl));
+	ASSERT_EQ(typeUrl, message.type_url());
+
+	// the messages of the stream's type are serialized without their type URL
+	google::protobuf::Any streamMessage;
+	streamMessage.PackFrom(google::protobuf::StringValue::default_instance());
+	ASSERT_TRUE(ghost::internal::serializeStreamMessage(streamMessage, streamTypeUrl, buffer));
+	ASSERT_TRUE(ghost::internal::readStreamTypeUrl(buffer, streamTypeUrl, typeUrl));
+	ASSERT_EQ(typeUrl, streamTypeUrl);
+}
+
 TEST_F(ConnectionGRPCTests, test_PublisherGRPC_continuesOperation_When_subscriberDies)
 {
 	createPublisher(_config);
@@ -454,7 +766,7 @@ TEST_F(ConnectionGRPCTests, test_PublisherGRPC_continuesOperation_When_subscribe
 	checkSubscribersReceivedMessages(subscribersCount);
 
 	// stop the last subscriber
-	bool stopResult = _subscribers[1]->stop();
+	_subscribers[1]->stop();
 
 	// Reset statistics and send another message
 	_doubleValueMessageWasHandledMap.clear();
@@ -483,9 +795,1177 @@ TEST_F(ConnectionGRPCTests, test_ServerGRPC_doesNotHang_When_remoteClientIsAdded
 	ASSERT_TRUE(stopResult);
 }
 
-/*TEST_F(ConnectionGRPCTests, test_SubscriberGRPC_continuesOperation_When_PublisherDies)
+TEST_F(ConnectionGRPCTests, test_PublisherGRPC_growsAcceptPool_When_manySubscribersConnectAtOnce)
+{
+	auto config = _config;
+	config.setAcceptPoolSize(2, 256);
+
+	createPublisher(config);
+	startPublisher();
+	auto publisher = ghost::ConnectionControlGRPC::create(_publisher);
+	ASSERT_TRUE(publisher);
+	ASSERT_EQ(publisher->getAcceptStatistics().target, 2u);
+
+	// a reconnection storm: all the subscribers dial at the same time
+	size_t subscribersCount = 64;
+	std::vector<std::shared_future<bool>> results;
+	for (size_t i = 0; i < subscribersCount; ++i)
+	{
+		auto subscriber = _connectionManager->createSubscriber(config);
+		auto control = ghost::ConnectionControlGRPC::create(subscriber);
+		ASSERT_TRUE(control);
+		results.push_back(control->startAsync());
+		_subscribers.push_back(subscriber);
+	}
+	for (auto& result : results) ASSERT_TRUE(result.get());
+	waitForSubscribers(subscribersCount);
+
+	auto statistics = publisher->getAcceptStatistics();
+	ASSERT_EQ(statistics.accepted, subscribersCount);
+	ASSERT_GT(statistics.target, 2u);
+	ASSERT_LE(statistics.target, 256u);
+}
+
+TEST_F(ConnectionGRPCTests, test_PublisherGRPC_retiresAcceptRequests_When_poolShrinksAfterIdle)
+{
+	auto config = _config;
+	config.setAcceptPoolSize(2, 256);
+
+	createPublisher(config);
+	startPublisher();
+	auto publisher = ghost::ConnectionControlGRPC::create(_publisher);
+	ASSERT_TRUE(publisher);
+
+	size_t subscribersCount = 64;
+	std::vector<std::shared_future<bool>> results;
+	for (size_t i = 0; i < subscribersCount; ++i)
+	{
+		auto subscriber = _connectionManager->createSubscriber(config);
+		results.push_back(ghost::ConnectionControlGRPC::create(subscriber)->startAsync());
+		_subscribers.push_back(subscriber);
+	}
+	for (auto& result : results) ASSERT_TRUE(result.get());
+	waitForSubscribers(subscribersCount);
+	auto grown = publisher->getAcceptStatistics();
+
+	// the target is halved after a second without connections
+	auto now = std::chrono::steady_clock::now();
+	auto deadline = now + std::chrono::seconds(3);
+	while (publisher->getAcceptStatistics().target >= grown.target && now < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		now = std::chrono::steady_clock::now();
+	}
+	auto shrunk = publisher->getAcceptStatistics();
+	ASSERT_LT(shrunk.target, grown.target);
+	ASSERT_GT(shrunk.outstanding, shrunk.target);
+
+	// the next connections consume the requests above the target without replacing them
+	size_t lateSubscribersCount = 2;
+	for (size_t i = 0; i < lateSubscribersCount; ++i)
+	{
+		auto subscriber = _connectionManager->createSubscriber(config);
+		ASSERT_TRUE(subscriber->start());
+		_subscribers.push_back(subscriber);
+	}
+	waitForSubscribers(subscribersCount + lateSubscribersCount);
+
+	auto statistics = publisher->getAcceptStatistics();
+	ASSERT_EQ(statistics.retired, shrunk.retired + lateSubscribersCount);
+	ASSERT_EQ(statistics.outstanding, shrunk.outstanding - lateSubscribersCount);
+}
+
+/* Writer backpressure */
+
+TEST_F(ConnectionGRPCTests, test_ConnectionConfigurationGRPC_writerWatermarksHaveDefaults_When_notSet)
+{
+	ghost::ConnectionConfigurationGRPC config;
+	ASSERT_EQ(config.getWriterHighWatermark(), 1024u);
+	ASSERT_EQ(config.getWriterLowWatermark(), 512u);
+	ASSERT_EQ(config.getWriterHighWatermarkBytes(), 0u);
+	ASSERT_EQ(config.getWriterLowWatermarkBytes(), 0u);
+
+	config.setWriterWatermarks(100, 10);
+	config.setWriterWatermarksBytes(1000, 500);
+	ASSERT_EQ(config.getWriterHighWatermark(), 100u);
+	ASSERT_EQ(config.getWriterLowWatermark(), 10u);
+	ASSERT_EQ(config.getWriterHighWatermarkBytes(), 1000u);
+	ASSERT_EQ(config.getWriterLowWatermarkBytes(), 500u);
+
+	auto copy = ghost::ConnectionConfigurationGRPC::initializeFrom(config);
+	ASSERT_EQ(copy.getWriterHighWatermark(), 100u);
+	ASSERT_EQ(copy.getWriterLowWatermarkBytes(), 500u);
+}
+
+TEST_F(ConnectionGRPCTests, test_ClientGRPC_becomesWritable_When_queuedMessagesAreSent)
+{
+	auto config = _config;
+	config.setWriterWatermarks(4, 1);
+
+	createServer(config);
+	startServer();
+	startClients(config, 1);
+	waitForClientsHandled();
+
+	auto control = ghost::ConnectionControlGRPC::create(_clients[0]);
+	ASSERT_TRUE(control);
+	ASSERT_EQ(control->awaitWritable(std::chrono::milliseconds(0)),
+		  ghost::ConnectionControlGRPC::WriterStatus::WRITABLE);
+
+	auto writer = _clients[0]->getWriter<google::protobuf::DoubleValue>();
+	for (int i = 0; i < 100; ++i)
+	{
+		auto status = control->awaitWritable(std::chrono::seconds(1));
+		ASSERT_EQ(status, ghost::ConnectionControlGRPC::WriterStatus::WRITABLE);
+		ASSERT_TRUE(writer->write(google::protobuf::DoubleValue::default_instance()));
+	}
+}
+
+TEST_F(ConnectionGRPCTests, test_PublisherGRPC_becomesWritable_When_subscribersReceivedTheMessages)
+{
+	auto config = _config;
+	config.setWriterWatermarks(4, 1);
+
+	createPublisher(config);
+	startPublisher();
+
+	int subscribersCount = 2;
+	startSubscribers(config, subscribersCount);
+	setupSubscribers(subscribersCount);
+	waitForSubscribers(subscribersCount);
+
+	auto control = ghost::ConnectionControlGRPC::create(_publisher);
+	ASSERT_TRUE(control);
+	auto writer = _publisher->getWriter<google::protobuf::DoubleValue>();
+	for (int i = 0; i < 100; ++i)
+	{
+		auto status = control->awaitWritable(std::chrono::seconds(1));
+		ASSERT_EQ(status, ghost::ConnectionControlGRPC::WriterStatus::WRITABLE);
+		ASSERT_TRUE(writer->write(google::protobuf::DoubleValue::default_instance()));
+	}
+
+	ASSERT_EQ(control->awaitWritable(std::chrono::seconds(1)),
+		  ghost::ConnectionControlGRPC::WriterStatus::WRITABLE);
+}
+
+TEST_F(ConnectionGRPCTests, test_ConnectionControlGRPC_isNull_When_connectionIsNotGRPC)
+{
+	ASSERT_TRUE(ghost::ConnectionControlGRPC::create(nullptr) == nullptr);
+	ASSERT_TRUE(ghost::ConnectionControlGRPC::create(std::make_shared<PublisherMock>(_config)) == nullptr);
+}
+
+TEST_F(ConnectionGRPCTests, test_PublisherGRPC_sendsManyMessagesWithoutWaitingForTheWriterPeriod_When_configIsDefault)
+{
+	createPublisher(_config);
+	startPublisher();
+
+	int subscribersCount = 2;
+	startSubscribers(_config, subscribersCount);
+	setupSubscribers(subscribersCount);
+	waitForSubscribers(subscribersCount);
+
+	int messagesCount = 1000;
+	auto writer = _publisher->getWriter<google::protobuf::DoubleValue>();
+	for (int i = 0; i < messagesCount; ++i)
+		ASSERT_TRUE(writer->write(google::protobuf::DoubleValue::default_instance()));
+
+	// one message per period of the writer (10ms) would take 10 seconds
+	checkSubscribersReceivedMessages(subscribersCount, messagesCount, std::chrono::seconds(2));
+}
+
+TEST_F(ConnectionGRPCTests, test_PublisherGRPC_resumesBeforeTheWriterPeriod_When_subscriberQueueDrains)
+{
+	auto config = _config;
+	config.setWriterWatermarks(1, 0);
+
+	createPublisher(config);
+	startPublisher();
+
+	int subscribersCount = 2;
+	startSubscribers(config, subscribersCount);
+	setupSubscribers(subscribersCount);
+	waitForSubscribers(subscribersCount);
+
+	int messagesCount = 500;
+	auto writer = _publisher->getWriter<google::protobuf::DoubleValue>();
+	for (int i = 0; i < messagesCount; ++i)
+		ASSERT_TRUE(writer->write(google::protobuf::DoubleValue::default_instance()));
+
+	// every message fills the queues: one message per period of the writer would take 5 seconds
+	checkSubscribersReceivedMessages(subscribersCount, messagesCount, std::chrono::seconds(2));
+
+	// the subscribers keep up: they are waited for instead of missing messages
+	auto control = ghost::ConnectionControlGRPC::create(_publisher);
+	ASSERT_TRUE(control);
+	ASSERT_EQ(control->countDroppedMessages(), 0u);
+}
+
+TEST_F(ConnectionGRPCTests, test_ConnectionConfigurationGRPC_laggingSubscribersAreWaitedFor_When_notSet)
+{
+	ghost::ConnectionConfigurationGRPC config;
+	ASSERT_EQ(config.getLaggingSubscriberTimeout().count(), 0);
+
+	config.setLaggingSubscriberTimeout(std::chrono::milliseconds(100));
+	ASSERT_EQ(config.getLaggingSubscriberTimeout().count(), 100);
+}
+
+TEST_F(ConnectionGRPCTests, test_ConnectionConfigurationGRPC_writerMaxCoalescingDelayIsDisabled_When_notSet)
+{
+	ghost::ConnectionConfigurationGRPC config;
+	ASSERT_EQ(config.getWriterMaxCoalescingDelay().count(), 0);
+
+	config.setWriterMaxCoalescingDelay(std::chrono::microseconds(500));
+	ASSERT_EQ(config.getWriterMaxCoalescingDelay().count(), 500);
+}
+
+TEST_F(ConnectionGRPCTests, test_ClientGRPC_deliversAllMessages_When_writesAreCoalesced)
 {
-	// stop publisher and then restart it
+	auto config = _config;
+	config.setWriterWatermarks(64, 16);
+	config.setWriterMaxCoalescingDelay(std::chrono::microseconds(200));
+
+	createServer(config);
+	startServer();
+
+	EXPECT_CALL(*_clientHandlerMock, configureClient(_))
+	    .Times(1)
+	    .WillRepeatedly([&](const std::shared_ptr<ghost::Client>& client) {
+		    auto handler = client->addMessageHandler();
+		    handler->addHandler<google::protobuf::DoubleValue>(
+			std::bind(&ConnectionGRPCTests::doubleMessageHandler, this, std::placeholders::_1));
+	    });
+	EXPECT_CALL(*_clientHandlerMock, handle(_, _))
+	    .Times(1)
+	    .WillRepeatedly([&](std::shared_ptr<ghost::Client> client, bool& keepClientAlive) {
+		    keepClientAlive = true;
+		    return true;
+	    });
+
+	startClients(config, 1, false);
+
+	// burst of messages: all of them are written before the stream is flushed
+	int messagesCount = 1000;
+	auto writer = _clients[0]->getWriter<google::protobuf::DoubleValue>();
+	for (int i = 0; i < messagesCount; ++i)
+		ASSERT_TRUE(writer->write(google::protobuf::DoubleValue::default_instance()));
+
+	auto now = std::chrono::steady_clock::now();
+	auto deadline = now + std::chrono::seconds(2);
+	while (_doubleValueMessageWasHandledCounter < messagesCount && now < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = std::chrono::steady_clock::now();
+	}
+	ASSERT_EQ(_doubleValueMessageWasHandledCounter, messagesCount);
+}
 
-	// That will not work!
-}*/
+/// Gives access to the writer sink of a client, to fill writer queues without a connection.
+class WriterSinkClient : public ClientMock
+{
+public:
+	WriterSinkClient(const ghost::ConnectionConfiguration& config) : ClientMock(config)
+	{
+	}
+
+	using ghost::WritableConnection::getWriterSink;
+};
+
+TEST_F(ConnectionGRPCTests, test_WriterQueue_buffersWrites_When_messagesWaitInTheSink)
+{
+	auto client = std::make_shared<WriterSinkClient>(_config);
+	auto writer = client->getWriter<google::protobuf::DoubleValue>();
+	auto sink = client->getWriterSink();
+	grpc::ByteBuffer message;
+	bool bufferHint;
+
+	// with the default configuration, all the waiting messages enter the queue
+	ghost::ConnectionConfigurationGRPC config;
+	ghost::internal::WriterQueue defaultQueue(config.getWriterHighWatermark(), config.getWriterLowWatermark(),
+						  config.getWriterHighWatermarkBytes(),
+						  config.getWriterLowWatermarkBytes());
+	for (int i = 0; i < 3; ++i) ASSERT_TRUE(writer->write(google::protobuf::DoubleValue::default_instance()));
+	ASSERT_TRUE(defaultQueue.fill(*sink));
+	ASSERT_EQ(defaultQueue.size(), 3u);
+	for (int i = 0; i < 3; ++i)
+	{
+		ASSERT_TRUE(defaultQueue.front(message, bufferHint));
+		ASSERT_EQ(bufferHint, i < 2); // the last message flushes the stream
+		defaultQueue.pop();
+	}
+
+	// a queue of one message still buffers the writes while the next messages wait in the sink
+	ghost::internal::WriterQueue queue(1, 0);
+	for (int i = 0; i < 3; ++i) ASSERT_TRUE(writer->write(google::protobuf::DoubleValue::default_instance()));
+	for (int i = 0; i < 3; ++i)
+	{
+		ASSERT_TRUE(queue.fill(*sink));
+		ASSERT_EQ(queue.size(), 1u);
+		ASSERT_TRUE(queue.front(message, bufferHint));
+		ASSERT_EQ(bufferHint, i < 2);
+		queue.pop();
+	}
+	ASSERT_FALSE(queue.fill(*sink));
+}
+
+TEST_F(ConnectionGRPCTests, test_WriterQueue_rejectsPushedMessages_When_full)
+{
+	using Priority = ghost::internal::WriterQueue::Priority;
+	ghost::internal::WriterQueue queue(2, 0);
+
+	std::string content("abc");
+	grpc::Slice slice(content);
+	grpc::ByteBuffer buffer(&slice, 1);
+	ASSERT_TRUE(queue.push(buffer));
+	ASSERT_TRUE(queue.push(buffer));
+	ASSERT_FALSE(queue.isWritable());
+
+	// raw writers are bound by the watermarks, except for the control messages
+	ASSERT_FALSE(queue.push(buffer));
+	ASSERT_TRUE(queue.push(buffer, Priority::CONTROL));
+	ASSERT_EQ(queue.size(), 3u);
+
+	// accepted again once the low watermark is reached
+	for (int i = 0; i < 3; ++i) queue.pop();
+	ASSERT_TRUE(queue.push(buffer));
+}
+
+TEST_F(ConnectionGRPCTests, test_WriterQueue_sendsControlMessagesFirst_When_bulkMessagesAreWaiting)
+{
+	using Priority = ghost::ConnectionConfigurationGRPC::MessagePriority;
+
+	ghost::ConnectionConfigurationGRPC config;
+	ASSERT_EQ(config.getMessagePriority("google.protobuf.StringValue"), Priority::NORMAL);
+	config.setMessagePriority("google.protobuf.BoolValue", Priority::CONTROL);
+	ASSERT_EQ(config.getMessagePriority("google.protobuf.BoolValue"), Priority::CONTROL);
+	config.setPriorityStarvationLimit(2);
+
+	ghost::internal::WriterQueue queue(0, 0, 0, 0, std::chrono::microseconds(0), "", config.getMessagePriorities(),
+					   config.getPriorityStarvationLimit());
+	ASSERT_EQ(queue.getPriority("type.googleapis.com/google.protobuf.BoolValue"), Priority::CONTROL);
+	ASSERT_EQ(queue.getPriority("type.googleapis.com/google.protobuf.StringValue"), Priority::NORMAL);
+
+	// the buffers are told apart by their length: bulk messages have 3 bytes, control messages 1
+	std::string bulk("abc");
+	std::string control("c");
+	for (int i = 0; i < 5; ++i)
+	{
+		grpc::Slice slice(bulk);
+		queue.push(grpc::ByteBuffer(&slice, 1), Priority::BULK);
+	}
+	for (int i = 0; i < 5; ++i)
+	{
+		grpc::Slice slice(control);
+		queue.push(grpc::ByteBuffer(&slice, 1), Priority::CONTROL);
+	}
+
+	// control messages overtake the bulk messages, but a bulk message is sent every 2 control messages
+	std::vector<size_t> lengths;
+	grpc::ByteBuffer message;
+	bool bufferHint;
+	while (queue.front(message, bufferHint))
+	{
+		lengths.push_back(message.Length());
+		queue.pop();
+	}
+	ASSERT_EQ(lengths, std::vector<size_t>({1, 1, 3, 1, 1, 3, 1, 3, 3, 3}));
+	ASSERT_EQ(queue.size(), 0u);
+}
+
+TEST_F(ConnectionGRPCTests, test_WriterQueue_dropsExpiredMessages_When_timeToLiveElapsed)
+{
+	ghost::ConnectionConfigurationGRPC config;
+	ASSERT_EQ(config.getMessageTimeToLive("google.protobuf.StringValue"), std::chrono::milliseconds(0));
+	config.setMessageTimeToLive("google.protobuf.DoubleValue", std::chrono::milliseconds(10));
+	ASSERT_EQ(config.getMessageTimeToLive("google.protobuf.DoubleValue"), std::chrono::milliseconds(10));
+
+	ghost::internal::WriterQueue queue(0, 0, 0, 0, std::chrono::microseconds(0), "", {}, 0,
+					   config.getMessageTimesToLive());
+	ASSERT_EQ(ghost::internal::WriterQueue::getTimeToLive(config.getMessageTimesToLive(),
+							      "type.googleapis.com/google.protobuf.DoubleValue"),
+		  std::chrono::milliseconds(10));
+
+	// the buffers are told apart by their length: stale messages have 3 bytes, the message without ttl 1
+	std::string stale("abc");
+	std::string fresh("f");
+	for (int i = 0; i < 5; ++i)
+	{
+		grpc::Slice slice(stale);
+		queue.push(grpc::ByteBuffer(&slice, 1), ghost::internal::WriterQueue::Priority::NORMAL,
+			   std::chrono::milliseconds(10));
+	}
+	grpc::Slice slice(fresh);
+	queue.push(grpc::ByteBuffer(&slice, 1));
+	ASSERT_EQ(queue.size(), 6u);
+
+	// after a stall, the backlog of stale messages is dropped at once
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	grpc::ByteBuffer message;
+	bool bufferHint;
+	ASSERT_TRUE(queue.front(message, bufferHint));
+	ASSERT_EQ(message.Length(), 1u);
+	ASSERT_FALSE(bufferHint);
+	ASSERT_EQ(queue.countExpired(), 5u);
+	queue.pop();
+	ASSERT_EQ(queue.size(), 0u);
+	ASSERT_EQ(queue.bytes(), 0u);
+}
+
+TEST_F(ConnectionGRPCTests, test_WriterQueue_flushesCorkedWrite_When_waitingMessagesExpired)
+{
+	// the time to live is shorter than the coalescing delay
+	ghost::internal::WriterQueue queue(0, 0, 0, 0, std::chrono::seconds(1));
+
+	std::string content("abc");
+	grpc::Slice slice(content);
+	grpc::ByteBuffer buffer(&slice, 1);
+	queue.push(buffer);
+	for (int i = 0; i < 2; ++i)
+		queue.push(buffer, ghost::internal::WriterQueue::Priority::NORMAL, std::chrono::milliseconds(10));
+
+	grpc::ByteBuffer message;
+	bool bufferHint;
+	ASSERT_TRUE(queue.front(message, bufferHint));
+	ASSERT_TRUE(bufferHint);
+	queue.pop();
+
+	// the last waiting message is written anyway to flush the corked one, the other one is dropped
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	ASSERT_TRUE(queue.front(message, bufferHint));
+	ASSERT_FALSE(bufferHint);
+	ASSERT_EQ(queue.countExpired(), 1u);
+	queue.pop();
+	ASSERT_FALSE(queue.front(message, bufferHint));
+}
+
+/* Automatic reconnection */
+
+TEST_F(ConnectionGRPCTests, test_ConnectionConfigurationGRPC_reconnectIsDisabled_When_notSet)
+{
+	ghost::ConnectionConfigurationGRPC config;
+	ASSERT_FALSE(config.isReconnectEnabled());
+	ASSERT_EQ(config.getReconnectInitialBackoff().count(), 50);
+	ASSERT_EQ(config.getReconnectMaxBackoff().count(), 5000);
+
+	config.setReconnectEnabled(true);
+	config.setReconnectBackoff(std::chrono::milliseconds(10), std::chrono::milliseconds(200));
+	ASSERT_TRUE(config.isReconnectEnabled());
+	ASSERT_EQ(config.getReconnectInitialBackoff().count(), 10);
+	ASSERT_EQ(config.getReconnectMaxBackoff().count(), 200);
+}
+
+TEST_F(ConnectionGRPCTests, test_SubscriberGRPC_continuesOperation_When_PublisherRestarts)
+{
+	auto config = _config;
+	config.setReconnectEnabled(true);
+	config.setReconnectBackoff(std::chrono::milliseconds(10), std::chrono::milliseconds(100));
+
+	createPublisher(config);
+	startPublisher();
+
+	int subscribersCount = 1;
+	startSubscribers(config, subscribersCount);
+	setupSubscribers(subscribersCount);
+	waitForSubscribers(subscribersCount);
+
+	// restart the publisher: the subscriber connects again by itself
+	bool stopResult = _publisher->stop();
+	ASSERT_TRUE(stopResult);
+	createPublisher(config);
+	startPublisher();
+	waitForSubscribers(subscribersCount);
+	ASSERT_TRUE(_subscribers[0]->isRunning());
+
+	auto writer = _publisher->getWriter<google::protobuf::DoubleValue>();
+	bool writeResult = writer->write(google::protobuf::DoubleValue::default_instance());
+	ASSERT_TRUE(writeResult);
+	checkSubscribersReceivedMessages(subscribersCount);
+
+	auto control = ghost::ConnectionControlGRPC::create(_subscribers[0]);
+	ASSERT_TRUE(control);
+	auto statistics = control->getReconnectStatistics();
+	ASSERT_EQ(statistics.reconnections, 1u);
+	ASSERT_FALSE(statistics.reconnecting);
+	ASSERT_GT(statistics.lastOutage.count(), 0);
+	ASSERT_EQ(statistics.lastOutage, statistics.totalOutage);
+}
+
+TEST_F(ConnectionGRPCTests, test_ClientGRPC_sendsQueuedMessages_When_reconnected)
+{
+	auto config = _config;
+	config.setReconnectEnabled(true);
+	config.setReconnectBackoff(std::chrono::milliseconds(10), std::chrono::milliseconds(100));
+
+	auto acceptClients = [&]() {
+		EXPECT_CALL(*_clientHandlerMock, configureClient(_))
+		    .Times(testing::AnyNumber())
+		    .WillRepeatedly([&](const std::shared_ptr<ghost::Client>& client) {
+			    auto handler = client->addMessageHandler();
+			    handler->addHandler<google::protobuf::DoubleValue>(
+				std::bind(&ConnectionGRPCTests::doubleMessageHandler, this, std::placeholders::_1));
+		    });
+		EXPECT_CALL(*_clientHandlerMock, handle(_, _))
+		    .Times(testing::AnyNumber())
+		    .WillRepeatedly([&](std::shared_ptr<ghost::Client> client, bool& keepClientAlive) {
+			    keepClientAlive = true;
+			    return true;
+		    });
+	};
+
+	createServer(config);
+	acceptClients();
+	startServer();
+	startClients(config, 1, false);
+
+	auto client = _clients[0];
+	auto control = ghost::ConnectionControlGRPC::create(client);
+	ASSERT_TRUE(control);
+
+	// lose the server, and wait until the client noticed it
+	bool stopResult = _server->stop();
+	ASSERT_TRUE(stopResult);
+	auto now = std::chrono::steady_clock::now();
+	auto deadline = now + std::chrono::seconds(2);
+	while (!control->getReconnectStatistics().reconnecting && now < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = std::chrono::steady_clock::now();
+	}
+	ASSERT_TRUE(control->getReconnectStatistics().reconnecting);
+	ASSERT_TRUE(client->isRunning());
+
+	// the messages written during the outage are kept until the server is back
+	int messagesCount = 10;
+	auto writer = client->getWriter<google::protobuf::DoubleValue>();
+	for (int i = 0; i < messagesCount; ++i)
+		ASSERT_TRUE(writer->write(google::protobuf::DoubleValue::default_instance()));
+
+	createServer(config);
+	acceptClients();
+	startServer();
+
+	now = std::chrono::steady_clock::now();
+	deadline = now + std::chrono::seconds(2);
+	while (_doubleValueMessageWasHandledCounter < messagesCount && now < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = std::chrono::steady_clock::now();
+	}
+	ASSERT_EQ(_doubleValueMessageWasHandledCounter, messagesCount);
+	ASSERT_EQ(control->getReconnectStatistics().reconnections, 1u);
+}
+
+TEST_F(ConnectionGRPCTests, test_ClientGRPC_countsExpiredMessages_When_theyWaitedLongerThanTheirTimeToLive)
+{
+	auto config = _config;
+	config.setReconnectEnabled(true);
+	config.setReconnectBackoff(std::chrono::milliseconds(10), std::chrono::milliseconds(100));
+	config.setMessageTimeToLive("google.protobuf.DoubleValue", std::chrono::milliseconds(10));
+
+	createServer(config);
+	EXPECT_CALL(*_clientHandlerMock, configureClient(_)).Times(testing::AnyNumber());
+	EXPECT_CALL(*_clientHandlerMock, handle(_, _))
+	    .Times(testing::AnyNumber())
+	    .WillRepeatedly([&](std::shared_ptr<ghost::Client> client, bool& keepClientAlive) {
+		    keepClientAlive = true;
+		    return true;
+	    });
+	startServer();
+	startClients(config, 1, false);
+
+	auto control = ghost::ConnectionControlGRPC::create(_clients[0]);
+	ASSERT_TRUE(control);
+	ASSERT_EQ(control->countExpiredMessages(), 0u);
+
+	// the messages written while the server is lost wait in the writer queue until they expire
+	bool stopResult = _server->stop();
+	ASSERT_TRUE(stopResult);
+	auto now = std::chrono::steady_clock::now();
+	auto deadline = now + std::chrono::seconds(2);
+	while (!control->getReconnectStatistics().reconnecting && now < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = std::chrono::steady_clock::now();
+	}
+	ASSERT_TRUE(control->getReconnectStatistics().reconnecting);
+
+	size_t messagesCount = 10;
+	auto writer = _clients[0]->getWriter<google::protobuf::DoubleValue>();
+	for (size_t i = 0; i < messagesCount; ++i)
+		ASSERT_TRUE(writer->write(google::protobuf::DoubleValue::default_instance()));
+
+	now = std::chrono::steady_clock::now();
+	deadline = now + std::chrono::seconds(2);
+	while (control->countExpiredMessages() < messagesCount && now < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = std::chrono::steady_clock::now();
+	}
+	ASSERT_EQ(control->countExpiredMessages(), messagesCount);
+}
+
+/* Transport settings */
+
+TEST_F(ConnectionGRPCTests, test_ConnectionConfigurationGRPC_transportSettingsKeepGRPCDefaults_When_notSet)
+{
+	ghost::ConnectionConfigurationGRPC config;
+	ASSERT_EQ(config.getKeepaliveTime().count(), 0);
+	ASSERT_EQ(config.getKeepaliveTimeout().count(), 0);
+	ASSERT_EQ(config.getMaxSendMessageSize(), 0u);
+	ASSERT_EQ(config.getMaxReceiveMessageSize(), 0u);
+	ASSERT_EQ(config.getHTTP2InitialWindowSize(), 0u);
+	ASSERT_TRUE(config.isHTTP2BDPProbeEnabled());
+	ASSERT_EQ(config.getMaxConcurrentStreams(), 0u);
+	ASSERT_EQ(config.getWriteBufferSize(), 0u);
+
+	config.setKeepalive(std::chrono::milliseconds(10000), std::chrono::milliseconds(2000));
+	config.setMaxMessageSize(16 * 1024 * 1024, 32 * 1024 * 1024);
+	config.setHTTP2InitialWindowSize(1024 * 1024);
+	config.setHTTP2BDPProbeEnabled(false);
+	config.setMaxConcurrentStreams(100);
+	config.setWriteBufferSize(64 * 1024);
+
+	auto copy = ghost::ConnectionConfigurationGRPC::initializeFrom(config);
+	ASSERT_EQ(copy.getKeepaliveTime().count(), 10000);
+	ASSERT_EQ(copy.getKeepaliveTimeout().count(), 2000);
+	ASSERT_EQ(copy.getMaxSendMessageSize(), 16u * 1024 * 1024);
+	ASSERT_EQ(copy.getMaxReceiveMessageSize(), 32u * 1024 * 1024);
+	ASSERT_EQ(copy.getHTTP2InitialWindowSize(), 1024u * 1024);
+	ASSERT_FALSE(copy.isHTTP2BDPProbeEnabled());
+	ASSERT_EQ(copy.getMaxConcurrentStreams(), 100u);
+	ASSERT_EQ(copy.getWriteBufferSize(), 64u * 1024);
+}
+
+TEST_F(ConnectionGRPCTests, test_ConnectionConfigurationGRPC_acceptPoolFollowsThreadPool_When_notSet)
+{
+	ghost::ConnectionConfigurationGRPC config;
+	ASSERT_EQ(config.getAcceptPoolMinSize(), 0u);
+	ASSERT_EQ(config.getAcceptPoolMaxSize(), 1024u);
+
+	config.setAcceptPoolSize(16, 128);
+	ASSERT_EQ(config.getAcceptPoolMinSize(), 16u);
+	ASSERT_EQ(config.getAcceptPoolMaxSize(), 128u);
+}
+
+TEST_F(ConnectionGRPCTests, test_ClientGRPC_sendsLargeMessages_When_maxMessageSizeIsRaised)
+{
+	auto config = _config;
+	config.setMaxMessageSize(16 * 1024 * 1024, 16 * 1024 * 1024);
+	config.setHTTP2InitialWindowSize(4 * 1024 * 1024);
+	config.setKeepalive(std::chrono::milliseconds(10000), std::chrono::milliseconds(2000));
+
+	createServer(config);
+	startServer();
+
+	// larger than the default limit of 4 MB
+	std::string payload(6 * 1024 * 1024, 'x');
+	std::atomic<size_t> receivedSize{0};
+	EXPECT_CALL(*_clientHandlerMock, configureClient(_))
+	    .Times(1)
+	    .WillRepeatedly([&](const std::shared_ptr<ghost::Client>& client) {
+		    auto handler = client->addMessageHandler();
+		    handler->addHandler<google::protobuf::StringValue>(
+			[&](const google::protobuf::StringValue& message) { receivedSize = message.value().size(); });
+	    });
+	EXPECT_CALL(*_clientHandlerMock, handle(_, _))
+	    .Times(1)
+	    .WillRepeatedly([&](std::shared_ptr<ghost::Client> client, bool& keepClientAlive) {
+		    keepClientAlive = true;
+		    return true;
+	    });
+
+	startClients(config, 1, false);
+
+	google::protobuf::StringValue message;
+	message.set_value(payload);
+	auto writer = _clients[0]->getWriter<google::protobuf::StringValue>();
+	ASSERT_TRUE(writer->write(message));
+
+	auto now = std::chrono::steady_clock::now();
+	auto deadline = now + std::chrono::seconds(5);
+	while (receivedSize == 0 && now < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = std::chrono::steady_clock::now();
+	}
+	ASSERT_EQ(receivedSize.load(), payload.size());
+}
+
+TEST_F(ConnectionGRPCTests, test_ClientGRPC_restoresMessageTypes_When_streamMessageTypeIsSet)
+{
+	auto config = _config;
+	config.setStreamMessageType(google::protobuf::DoubleValue::descriptor()->full_name());
+	ASSERT_EQ(config.getStreamMessageType(), "google.protobuf.DoubleValue");
+
+	createServer(config);
+	startServer();
+
+	std::atomic<int> doubleCount{0};
+	std::atomic<int> stringCount{0};
+	EXPECT_CALL(*_clientHandlerMock, configureClient(_))
+	    .Times(1)
+	    .WillRepeatedly([&](const std::shared_ptr<ghost::Client>& client) {
+		    auto handler = client->addMessageHandler();
+		    handler->addHandler<google::protobuf::DoubleValue>(
+			[&](const google::protobuf::DoubleValue& message) {
+				if (message.value() == 42.0) doubleCount++;
+			});
+		    handler->addHandler<google::protobuf::StringValue>(
+			[&](const google::protobuf::StringValue& message) {
+				if (message.value() == "other type") stringCount++;
+			});
+	    });
+	EXPECT_CALL(*_clientHandlerMock, handle(_, _))
+	    .Times(1)
+	    .WillRepeatedly([&](std::shared_ptr<ghost::Client> client, bool& keepClientAlive) {
+		    keepClientAlive = true;
+		    return true;
+	    });
+
+	startClients(config, 1, false);
+
+	// messages of the declared type are sent without type URL, the other types keep it
+	google::protobuf::DoubleValue doubleMessage;
+	doubleMessage.set_value(42.0);
+	google::protobuf::StringValue stringMessage;
+	stringMessage.set_value("other type");
+	auto doubleWriter = _clients[0]->getWriter<google::protobuf::DoubleValue>();
+	auto stringWriter = _clients[0]->getWriter<google::protobuf::StringValue>();
+	for (int i = 0; i < 10; ++i)
+	{
+		ASSERT_TRUE(doubleWriter->write(doubleMessage));
+		ASSERT_TRUE(stringWriter->write(stringMessage));
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	auto deadline = now + std::chrono::seconds(5);
+	while ((doubleCount < 10 || stringCount < 10) && now < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = std::chrono::steady_clock::now();
+	}
+	ASSERT_EQ(doubleCount.load(), 10);
+	ASSERT_EQ(stringCount.load(), 10);
+}
+
+TEST_F(ConnectionGRPCTests, test_RelayGRPC_forwardsMessagesToItsSubscribers_When_relaysAreChained)
+{
+	createPublisher(_config);
+	startPublisher();
+
+	// publisher -> relay1 -> relay2 -> subscribers
+	ghost::ConnectionConfigurationGRPC relay1Config = _config;
+	relay1Config.setServerPortNumber(TEST_PORT + 1);
+	ghost::ConnectionConfigurationGRPC relay2Config = _config;
+	relay2Config.setServerPortNumber(TEST_PORT + 2);
+
+	auto relay1 = ghost::RelayGRPC::create(_config, relay1Config, _threadPool);
+	auto relay2 = ghost::RelayGRPC::create(relay1Config, relay2Config, _threadPool);
+	ASSERT_TRUE(relay1->start());
+	ASSERT_TRUE(relay2->start());
+	waitForSubscribers(1);
+
+	int subscribersCount = 3;
+	startSubscribers(relay2Config, subscribersCount);
+	setupSubscribers(subscribersCount);
+
+	auto now = std::chrono::steady_clock::now();
+	auto deadline = now + std::chrono::seconds(2);
+	while ((relay1->countSubscribers() < 1 || relay2->countSubscribers() < static_cast<size_t>(subscribersCount)) &&
+	       now < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = std::chrono::steady_clock::now();
+	}
+	ASSERT_EQ(relay1->countSubscribers(), 1u);
+	ASSERT_EQ(relay2->countSubscribers(), static_cast<size_t>(subscribersCount));
+
+	auto writer = _publisher->getWriter<google::protobuf::DoubleValue>();
+	bool writeResult = writer->write(google::protobuf::DoubleValue::default_instance());
+	ASSERT_TRUE(writeResult);
+
+	checkSubscribersReceivedMessages(subscribersCount);
+
+	for (auto& subscriber : _subscribers) subscriber->stop();
+	relay2->stop();
+	relay1->stop();
+	ASSERT_FALSE(relay1->isRunning());
+}
+
+TEST_F(ConnectionGRPCTests, test_ConnectionConfigurationGRPC_serverHasOneShard_When_notSet)
+{
+	ghost::ConnectionConfigurationGRPC config;
+	ASSERT_EQ(config.getServerShards(), 1u);
+
+	config.setServerShards(0);
+	ASSERT_EQ(config.getServerShards(), 1u);
+}
+
+TEST_F(ConnectionGRPCTests, test_PublisherGRPC_sendsToAllSubscribers_When_serverIsSharded)
+{
+	_config.setServerShards(4);
+	createPublisher(_config);
+	startPublisher();
+
+	int subscribersCount = 10;
+	startSubscribers(_config, subscribersCount);
+	setupSubscribers(subscribersCount);
+	waitForSubscribers(subscribersCount);
+
+	auto writer = _publisher->getWriter<google::protobuf::DoubleValue>();
+	bool writeResult = writer->write(google::protobuf::DoubleValue::default_instance());
+	ASSERT_TRUE(writeResult);
+
+	checkSubscribersReceivedMessages(subscribersCount);
+}
+
+TEST_F(ConnectionGRPCTests, test_SubscriberGRPC_spreadsOverEndpoints_When_roundRobinIsSet)
+{
+	createPublisher(_config);
+	startPublisher();
+
+	ghost::ConnectionConfigurationGRPC secondConfig = _config;
+	secondConfig.setServerPortNumber(TEST_PORT + 1);
+	auto secondPublisher = std::dynamic_pointer_cast<ghost::internal::PublisherGRPC>(
+	    _connectionManager->createPublisher(secondConfig));
+	ASSERT_TRUE(secondPublisher);
+	ASSERT_TRUE(secondPublisher->start());
+
+	ghost::ConnectionConfigurationGRPC subscriberConfig = _config;
+	subscriberConfig.setServerEndpoints(
+	    {"127.0.0.1:" + std::to_string(TEST_PORT), "127.0.0.1:" + std::to_string(TEST_PORT + 1)});
+	subscriberConfig.setLoadBalancingPolicy(ghost::ConnectionConfigurationGRPC::LoadBalancingPolicy::ROUND_ROBIN);
+
+	startSubscribers(subscriberConfig, 4);
+
+	auto now = std::chrono::steady_clock::now();
+	auto deadline = now + std::chrono::seconds(2);
+	while ((getSubscribersCount() < 2 || secondPublisher->countSubscribers() < 2) && now < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		now = std::chrono::steady_clock::now();
+	}
+	ASSERT_EQ(getSubscribersCount(), 2u);
+	ASSERT_EQ(secondPublisher->countSubscribers(), 2u);
+
+	for (auto& subscriber : _subscribers) subscriber->stop();
+	secondPublisher->stop();
+}
+
+TEST_F(ConnectionGRPCTests, test_SubscriberGRPC_failsOverToNextEndpoint_When_firstEndpointIsUnreachable)
+{
+	createPublisher(_config);
+	startPublisher();
+
+	// nothing listens on the first endpoint
+	ghost::ConnectionConfigurationGRPC subscriberConfig = _config;
+	subscriberConfig.setServerEndpoints(
+	    {"127.0.0.1:" + std::to_string(TEST_PORT + 3), "127.0.0.1:" + std::to_string(TEST_PORT)});
+	subscriberConfig.setLoadBalancingPolicy(ghost::ConnectionConfigurationGRPC::LoadBalancingPolicy::PICK_FIRST);
+
+	int subscribersCount = 1;
+	startSubscribers(subscriberConfig, subscribersCount);
+	setupSubscribers(subscribersCount);
+	waitForSubscribers(subscribersCount);
+
+	auto writer = _publisher->getWriter<google::protobuf::DoubleValue>();
+	bool writeResult = writer->write(google::protobuf::DoubleValue::default_instance());
+	ASSERT_TRUE(writeResult);
+
+	checkSubscribersReceivedMessages(subscribersCount);
+}
+
+TEST_F(ConnectionGRPCTests, test_CallClientGRPC_matchesResponses_When_manyCallsAreInFlight)
+{
+	_config.setWriterWatermarks(0, 0);
+	auto server = _connectionManager->createServer(_config);
+	ASSERT_TRUE(server);
+	auto callHandler = ghost::CallHandlerGRPC::create();
+	callHandler->addHandler<google::protobuf::DoubleValue, google::protobuf::DoubleValue>(
+	    [](const google::protobuf::DoubleValue& request, google::protobuf::DoubleValue& response) {
+		    response.set_value(request.value() * 2);
+		    return true;
+	    });
+	server->setClientHandler(callHandler);
+	ASSERT_TRUE(server->start());
+
+	auto client = _connectionManager->createClient(_config);
+	ASSERT_TRUE(client);
+	auto callClient = ghost::CallClientGRPC::create(client);
+	ASSERT_TRUE(client->start());
+
+	// all the requests are sent before the first response is awaited
+	std::vector<std::future<std::shared_ptr<google::protobuf::DoubleValue>>> responses;
+	for (int i = 0; i < 1000; ++i)
+	{
+		google::protobuf::DoubleValue request;
+		request.set_value(i);
+		responses.push_back(
+		    callClient->call<google::protobuf::DoubleValue, google::protobuf::DoubleValue>(request));
+	}
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		ASSERT_EQ(responses[i].wait_for(std::chrono::seconds(2)), std::future_status::ready);
+		auto response = responses[i].get();
+		ASSERT_TRUE(response);
+		ASSERT_EQ(response->value(), i * 2);
+	}
+
+	// requests without handler are answered without response
+	auto unhandled = callClient->call<google::protobuf::StringValue, google::protobuf::StringValue>(
+	    google::protobuf::StringValue::default_instance());
+	ASSERT_EQ(unhandled.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+	ASSERT_FALSE(unhandled.get());
+	ASSERT_EQ(callClient->countPendingCalls(), 0u);
+
+	client->stop();
+	server->stop();
+}
+
+TEST_F(ConnectionGRPCTests, test_CallClientGRPC_failsPendingCalls_When_serverStops)
+{
+	createServer(_config);
+	startServer();
+
+	// the server keeps the client but never answers
+	std::atomic<bool> handled(false);
+	EXPECT_CALL(*_clientHandlerMock, handle(_, _))
+	    .Times(1)
+	    .WillRepeatedly([&](std::shared_ptr<ghost::Client> client, bool& keepClientAlive) {
+		    keepClientAlive = true;
+		    handled = true;
+		    return true;
+	    });
+
+	auto client = _connectionManager->createClient(_config);
+	ASSERT_TRUE(client);
+	auto callClient = ghost::CallClientGRPC::create(client);
+	ASSERT_TRUE(client->start());
+
+	std::vector<std::future<std::shared_ptr<google::protobuf::DoubleValue>>> responses;
+	for (int i = 0; i < 10; ++i)
+		responses.push_back(callClient->call<google::protobuf::DoubleValue, google::protobuf::DoubleValue>(
+		    google::protobuf::DoubleValue::default_instance()));
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+	while (!handled && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	ASSERT_TRUE(handled);
+	ASSERT_EQ(callClient->countPendingCalls(), 10u);
+
+	_server->stop();
+
+	// the responses cannot arrive anymore, the calls complete without waiting for the call client to be destroyed
+	for (auto& response : responses)
+	{
+		ASSERT_EQ(response.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+		ASSERT_FALSE(response.get());
+	}
+	ASSERT_EQ(callClient->countPendingCalls(), 0u);
+
+	client->stop();
+}
+
+TEST_F(ConnectionGRPCTests, test_CallClientGRPC_expiresCall_When_responseDoesNotArriveInTime)
+{
+	createServer(_config);
+	startServer();
+
+	EXPECT_CALL(*_clientHandlerMock, handle(_, _))
+	    .Times(1)
+	    .WillRepeatedly([&](std::shared_ptr<ghost::Client> client, bool& keepClientAlive) {
+		    keepClientAlive = true;
+		    return true;
+	    });
+
+	auto client = _connectionManager->createClient(_config);
+	ASSERT_TRUE(client);
+	auto callClient = ghost::CallClientGRPC::create(client);
+	ASSERT_TRUE(client->start());
+
+	auto expiring = callClient->call<google::protobuf::DoubleValue, google::protobuf::DoubleValue>(
+	    google::protobuf::DoubleValue::default_instance(), std::chrono::milliseconds(50));
+	auto pending = callClient->call<google::protobuf::DoubleValue, google::protobuf::DoubleValue>(
+	    google::protobuf::DoubleValue::default_instance());
+
+	ASSERT_EQ(expiring.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+	ASSERT_FALSE(expiring.get());
+	// the call without timeout is still waiting for its response
+	ASSERT_EQ(pending.wait_for(std::chrono::milliseconds(0)), std::future_status::timeout);
+	ASSERT_EQ(callClient->countPendingCalls(), 1u);
+
+	client->stop();
+}
+
+TEST_F(ConnectionGRPCTests, test_SubscriberGRPC_checksSequenceNumbers_When_sequenceNumbersAreEnabled)
+{
+	_config.setSequenceNumbersEnabled(true);
+	createPublisher(_config);
+	startPublisher();
+
+	int subscribersCount = 2;
+	startSubscribers(_config, subscribersCount);
+	setupSubscribers(subscribersCount);
+	waitForSubscribers(subscribersCount);
+
+	auto writer = _publisher->getWriter<google::protobuf::DoubleValue>();
+	bool writeResult = writer->write(google::protobuf::DoubleValue::default_instance());
+	ASSERT_TRUE(writeResult);
+
+	// the number is removed before the message reaches the handlers
+	checkSubscribersReceivedMessages(subscribersCount);
+	for (int i = 0; i < subscribersCount; ++i)
+	{
+		auto control = ghost::ConnectionControlGRPC::create(_subscribers[i]);
+		ASSERT_TRUE(control);
+		auto statistics = control->getSequenceStatistics();
+		ASSERT_EQ(statistics.received, 1u);
+		ASSERT_EQ(statistics.gaps, 0u);
+	}
+
+	ghost::internal::SequenceChecker checker;
+	for (uint64_t sequenceNumber : {5, 6, 9, 9, 8, 1, 2}) checker.check(sequenceNumber);
+	auto statistics = checker.getStatistics();
+	ASSERT_EQ(statistics.received, 7u);
+	ASSERT_EQ(statistics.gaps, 2u);
+	ASSERT_EQ(statistics.duplicates, 1u);
+	ASSERT_EQ(statistics.outOfOrder, 1u);
+	ASSERT_EQ(statistics.restarts, 1u);
+}
+
+TEST_F(ConnectionGRPCTests, test_BatchHandlerGRPC_deliversMessagesInBatches_When_subscriberIsBatched)
+{
+	createPublisher(_config);
+	startPublisher();
+
+	auto subscriber = _connectionManager->createSubscriber(_config);
+	ASSERT_TRUE(subscriber);
+	auto batchHandler = ghost::BatchHandlerGRPC::create(subscriber, 4, std::chrono::milliseconds(20));
+	ASSERT_TRUE(batchHandler);
+
+	std::mutex batchesMutex;
+	std::vector<std::vector<double>> batches;
+	batchHandler->addHandler<google::protobuf::DoubleValue>(
+	    [&](const std::vector<google::protobuf::DoubleValue>& messages) {
+		    std::vector<double> values;
+		    for (const auto& message : messages) values.push_back(message.value());
+		    std::lock_guard<std::mutex> lock(batchesMutex);
+		    batches.push_back(values);
+	    });
+
+	ASSERT_TRUE(subscriber->start());
+	_subscribers.push_back(subscriber);
+	waitForSubscribers(1);
+
+	auto writer = _publisher->getWriter<google::protobuf::DoubleValue>();
+	for (int i = 0; i < 10; ++i)
+	{
+		google::protobuf::DoubleValue message;
+		message.set_value(i);
+		ASSERT_TRUE(writer->write(message));
+	}
+
+	// the last, incomplete batch is delivered after the maximum delay
+	std::vector<double> received;
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+	while (received.size() < 10 && std::chrono::steady_clock::now() < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		std::lock_guard<std::mutex> lock(batchesMutex);
+		received.clear();
+		for (const auto& batch : batches)
+		{
+			ASSERT_LE(batch.size(), 4u);
+			received.insert(received.end(), batch.begin(), batch.end());
+		}
+	}
+
+	ASSERT_EQ(received.size(), 10u);
+	for (int i = 0; i < 10; ++i) ASSERT_EQ(received[i], i);
+
+	// only the gRPC subscribers can deliver batches
+	ASSERT_TRUE(ghost::BatchHandlerGRPC::create(nullptr, 4, std::chrono::milliseconds(20)) == nullptr);
+}
+
+TEST_F(ConnectionGRPCTests, test_KeyedHandlerGRPC_keepsOrderPerKey_When_messagesAreHandledConcurrently)
+{
+	createPublisher(_config);
+	startPublisher();
+
+	auto subscriber = _connectionManager->createSubscriber(_config);
+	ASSERT_TRUE(subscriber);
+	auto keyedHandler = ghost::KeyedHandlerGRPC::create(subscriber, 4);
+	ASSERT_TRUE(keyedHandler);
+
+	// the key of a message is its value modulo 3
+	std::mutex receivedMutex;
+	std::map<int, std::vector<double>> received;
+	std::atomic<int> receivedCount(0);
+	keyedHandler->addHandler<google::protobuf::DoubleValue, int>(
+	    [&](const google::protobuf::DoubleValue& message) {
+		    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		    std::lock_guard<std::mutex> lock(receivedMutex);
+		    received[static_cast<int>(message.value()) % 3].push_back(message.value());
+		    receivedCount++;
+	    },
+	    [](const google::protobuf::DoubleValue& message) { return static_cast<int>(message.value()) % 3; });
+
+	ASSERT_TRUE(subscriber->start());
+	_subscribers.push_back(subscriber);
+	waitForSubscribers(1);
+
+	auto writer = _publisher->getWriter<google::protobuf::DoubleValue>();
+	for (int i = 0; i < 30; ++i)
+	{
+		google::protobuf::DoubleValue message;
+		message.set_value(i);
+		ASSERT_TRUE(writer->write(message));
+	}
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+	while (receivedCount < 30 && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+	ASSERT_EQ(receivedCount, 30);
+	std::lock_guard<std::mutex> lock(receivedMutex);
+	for (int key = 0; key < 3; ++key)
+	{
+		ASSERT_EQ(received[key].size(), 10u);
+		for (size_t i = 0; i < 10; ++i) ASSERT_EQ(received[key][i], key + 3 * i);
+	}
+
+	// only the gRPC subscribers can dispatch messages to lanes
+	ASSERT_TRUE(ghost::KeyedHandlerGRPC::create(nullptr, 4) == nullptr);
+}
+
+TEST_F(ConnectionGRPCTests, test_KeyedReaderSink_blocksPut_When_laneIsFull)
+{
+	// the first task blocks the lane, the second one fills it
+	std::promise<void> release;
+	std::shared_future<void> released = release.get_future().share();
+	auto sink = std::make_shared<ghost::internal::KeyedReaderSink>(
+	    _threadPool, 1, 1, [released](const google::protobuf::Any&, size_t& keyHash, std::function<void()>& task) {
+		    keyHash = 0;
+		    task = [released] { released.wait(); };
+		    return true;
+	    });
+	sink->start();
+
+	auto message = google::protobuf::Any::default_instance();
+	ASSERT_TRUE(sink->put(message));
+	ASSERT_TRUE(sink->put(message));
+
+	std::atomic<bool> putReturned(false);
+	std::thread reader([&] {
+		sink->put(message);
+		putReturned = true;
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	EXPECT_FALSE(putReturned);
+
+	release.set_value();
+	reader.join();
+	ASSERT_TRUE(putReturned);
+	sink->stop();
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../../src/connection_grpc/rpc/RPCStateMachine.hpp"
+
+using namespace ghost::internal;
+
+/**
+ *	Checks the transition rules of the RPC state machine, and that concurrent transitions
+ *	from the same state cannot both succeed.
+ */
+class RPCStateMachineTests : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		_callbackCount = 0;
+		_stateMachine.setStateChangedCallback([this](RPCStateMachine::State state) {
+			_callbackCount++;
+			_lastCallbackState = state;
+		});
+	}
+
+	static const std::vector<RPCStateMachine::State> ALL_STATES;
+
+	RPCStateMachine _stateMachine;
+	std::atomic<int> _callbackCount;
+	RPCStateMachine::State _lastCallbackState;
+};
+
+const std::vector<RPCStateMachine::State> RPCStateMachineTests::ALL_STATES = {
+    RPCStateMachine::CREATED,  RPCStateMachine::INITIALIZING, RPCStateMachine::EXECUTING,
+    RPCStateMachine::INACTIVE, RPCStateMachine::DISPOSING,    RPCStateMachine::FINISHED};
+
+TEST_F(RPCStateMachineTests, test_RPCStateMachine_isCreated_When_constructed)
+{
+	ASSERT_EQ(_stateMachine.getState(), RPCStateMachine::CREATED);
+}
+
+TEST_F(RPCStateMachineTests, test_RPCStateMachine_followsTransitionRules)
+{
+	ASSERT_TRUE(RPCStateMachine::isTransitionAllowed(RPCStateMachine::CREATED, RPCStateMachine::INITIALIZING));
+	ASSERT_TRUE(RPCStateMachine::isTransitionAllowed(RPCStateMachine::CREATED, RPCStateMachine::FINISHED));
+	ASSERT_FALSE(RPCStateMachine::isTransitionAllowed(RPCStateMachine::CREATED, RPCStateMachine::EXECUTING));
+	ASSERT_FALSE(RPCStateMachine::isTransitionAllowed(RPCStateMachine::CREATED, RPCStateMachine::INACTIVE));
+
+	ASSERT_TRUE(RPCStateMachine::isTransitionAllowed(RPCStateMachine::INITIALIZING, RPCStateMachine::EXECUTING));
+	ASSERT_FALSE(RPCStateMachine::isTransitionAllowed(RPCStateMachine::INITIALIZING, RPCStateMachine::CREATED));
+
+	ASSERT_TRUE(RPCStateMachine::isTransitionAllowed(RPCStateMachine::EXECUTING, RPCStateMachine::INACTIVE));
+	ASSERT_TRUE(RPCStateMachine::isTransitionAllowed(RPCStateMachine::EXECUTING, RPCStateMachine::DISPOSING));
+	ASSERT_FALSE(RPCStateMachine::isTransitionAllowed(RPCStateMachine::EXECUTING, RPCStateMachine::INITIALIZING));
+	ASSERT_TRUE(RPCStateMachine::isTransitionAllowed(RPCStateMachine::INACTIVE, RPCStateMachine::FINISHED));
+	ASSERT_FALSE(RPCStateMachine::isTransitionAllowed(RPCStateMachine::INACTIVE, RPCStateMachine::EXECUTING));
+
+	ASSERT_TRUE(RPCStateMachine::isTransitionAllowed(RPCStateMachine::DISPOSING, RPCStateMachine::FINISHED));
+	ASSERT_FALSE(RPCStateMachine::isTransitionAllowed(RPCStateMachine::DISPOSING, RPCStateMachine::INACTIVE));
+
+	for (auto state : ALL_STATES)
+		ASSERT_FALSE(RPCStateMachine::isTransitionAllowed(RPCStateMachine::FINISHED, state));
+}
+
+TEST_F(RPCStateMachineTests, test_RPCStateMachine_keepsState_When_transitionIsNotAllowed)
+{
+	ASSERT_TRUE(_stateMachine.setState(RPCStateMachine::INITIALIZING));
+	ASSERT_TRUE(_stateMachine.setState(RPCStateMachine::EXECUTING));
+	ASSERT_TRUE(_stateMachine.setState(RPCStateMachine::DISPOSING));
+	int callbacks = _callbackCount;
+
+	ASSERT_FALSE(_stateMachine.setState(RPCStateMachine::INACTIVE));
+	ASSERT_FALSE(_stateMachine.setState(RPCStateMachine::EXECUTING));
+	ASSERT_EQ(_stateMachine.getState(), RPCStateMachine::DISPOSING);
+	ASSERT_EQ(_callbackCount, callbacks);
+
+	ASSERT_TRUE(_stateMachine.setState(RPCStateMachine::FINISHED));
+	ASSERT_EQ(_callbackCount, callbacks + 1);
+	ASSERT_EQ(_lastCallbackState, RPCStateMachine::FINISHED);
+}
+
+TEST_F(RPCStateMachineTests, test_RPCStateMachine_appliesTransitionFromExpectedStateOnly)
+{
+	ASSERT_FALSE(_stateMachine.setState(RPCStateMachine::INITIALIZING, RPCStateMachine::EXECUTING));
+	ASSERT_EQ(_stateMachine.getState(), RPCStateMachine::CREATED);
+
+	ASSERT_TRUE(_stateMachine.setState(RPCStateMachine::CREATED, RPCStateMachine::INITIALIZING));
+	ASSERT_FALSE(_stateMachine.setState(RPCStateMachine::CREATED, RPCStateMachine::INITIALIZING));
+	ASSERT_EQ(_stateMachine.getState(), RPCStateMachine::INITIALIZING);
+	ASSERT_EQ(_callbackCount, 1);
+}
+
+TEST_F(RPCStateMachineTests, test_RPCStateMachine_rejectsDisallowedTransition_When_expectedStateMatches)
+{
+	ASSERT_FALSE(_stateMachine.setState(RPCStateMachine::CREATED, RPCStateMachine::EXECUTING));
+	ASSERT_EQ(_stateMachine.getState(), RPCStateMachine::CREATED);
+	ASSERT_EQ(_callbackCount, 0);
+}
+
+TEST_F(RPCStateMachineTests, test_RPCStateMachine_appliesOneTransition_When_calledConcurrently)
+{
+	for (int round = 0; round < 100; ++round)
+	{
+		RPCStateMachine stateMachine;
+		std::atomic<int> callbacks(0);
+		stateMachine.setStateChangedCallback([&callbacks](RPCStateMachine::State) { callbacks++; });
+		ASSERT_TRUE(stateMachine.setState(RPCStateMachine::INITIALIZING));
+		ASSERT_TRUE(stateMachine.setState(RPCStateMachine::EXECUTING));
+
+		// several threads try to dispose the RPC while it becomes inactive
+		std::atomic<int> disposed(0);
+		std::atomic_bool go(false);
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 4; ++i)
+		{
+			threads.emplace_back([&] {
+				while (!go) std::this_thread::yield();
+				if (stateMachine.setState(RPCStateMachine::EXECUTING, RPCStateMachine::DISPOSING) ||
+				    stateMachine.setState(RPCStateMachine::INACTIVE, RPCStateMachine::DISPOSING))
+					disposed++;
+			});
+		}
+		threads.emplace_back([&] {
+			while (!go) std::this_thread::yield();
+			stateMachine.setState(RPCStateMachine::INACTIVE);
+		});
+
+		go = true;
+		for (auto& thread : threads) thread.join();
+
+		ASSERT_EQ(disposed, 1);
+		ASSERT_EQ(stateMachine.getState(), RPCStateMachine::DISPOSING);
+	}
+}
+
+TEST_F(RPCStateMachineTests, test_RPCStateMachine_wakesWaiters_When_stateChanges)
+{
+	auto finished = [this] { return _stateMachine.getState() == RPCStateMachine::FINISHED; };
+	ASSERT_FALSE(_stateMachine.await(finished, std::chrono::milliseconds(1)));
+
+	std::thread finisher([this] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		_stateMachine.setState(RPCStateMachine::FINISHED);
+	});
+
+	// the timeout is much longer than the transition: returning true means the waiter was notified
+	auto start = std::chrono::steady_clock::now();
+	bool result = _stateMachine.await(finished, std::chrono::seconds(10));
+	auto waited = std::chrono::steady_clock::now() - start;
+	finisher.join();
+
+	ASSERT_TRUE(result);
+	ASSERT_LT(waited, std::chrono::seconds(5));
+}
+
+TEST_F(RPCStateMachineTests, test_RPCStateMachine_wakesWaitersWithoutTimeout_When_notified)
+{
+	std::atomic_int operations{1};
+	auto finished = [&] { return operations == 0; };
+
+	std::thread finisher([&] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		operations--;
+		_stateMachine.notify();
+	});
+
+	// would block forever if the notification was lost
+	_stateMachine.await(finished);
+	finisher.join();
+
+	ASSERT_EQ(operations, 0);
+}
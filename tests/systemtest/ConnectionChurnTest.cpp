@@ -0,0 +1,254 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ConnectionChurnTest.hpp"
+
+#include <future>
+#include <ghost/connection_grpc/ConnectionGRPC.hpp>
+#include <thread>
+#include <vector>
+
+#include "../../src/connection_grpc/ServerGRPC.hpp"
+
+const std::string ConnectionChurnTest::TEST_NAME = "ConnectionChurn";
+const int ConnectionChurnTest::PORT = 17300;
+
+bool ConnectionChurnTest::GreetingHandler::handle(std::shared_ptr<ghost::Client> client, bool& keepClientAlive)
+{
+	auto greeting = google::protobuf::StringValue::default_instance();
+	greeting.set_value("hello");
+	client->getWriter<google::protobuf::StringValue>()->write(greeting);
+
+	// the client decides when the connection ends
+	keepClientAlive = true;
+	return true;
+}
+
+ConnectionChurnTest::ConnectionChurnTest(const std::shared_ptr<ghost::ThreadPool>& threadPool,
+					 const std::shared_ptr<ghost::Logger>& logger)
+    : Systemtest(threadPool, logger)
+    , _idleServerClients(0)
+    , _clientsCount(2000)
+    , _concurrency(8)
+    , _lingeringCount(500)
+    , _nextClient(0)
+    , _connectedClients(0)
+    , _failedClients(0)
+    , _connectionRate(0.0)
+    , _cleanupTime(0)
+    , _remainingServerClients(0)
+    , _serverStopTime(0)
+{
+}
+
+bool ConnectionChurnTest::setUp()
+{
+	_connectionManager = ghost::ConnectionManager::create();
+	ghost::ConnectionGRPC::initialize(_connectionManager, _threadPool);
+
+	_nextClient = 0;
+	_connectedClients = 0;
+	_failedClients = 0;
+	_connectionRate = 0.0;
+	_connectLatencies.reset();
+	_firstMessageLatencies.reset();
+	_disconnectLatencies.reset();
+	_cleanupTime = std::chrono::microseconds(0);
+	_remainingServerClients = 0;
+	_serverStopTime = std::chrono::microseconds(0);
+
+	// "clients=<count> concurrency=<threads> lingering=<count>"
+	const auto& commandLine = getParameter().commandLine;
+	_clientsCount = 2000;
+	if (commandLine.hasParameter("clients")) _clientsCount = commandLine.getParameter<long long>("clients");
+	_concurrency = 8;
+	if (commandLine.hasParameter("concurrency"))
+		_concurrency = static_cast<size_t>(commandLine.getParameter<long long>("concurrency"));
+	_lingeringCount = 500;
+	if (commandLine.hasParameter("lingering"))
+		_lingeringCount = static_cast<size_t>(commandLine.getParameter<long long>("lingering"));
+	require(_clientsCount > 0 && _concurrency > 0);
+	if (_clientsCount <= 0 || _concurrency == 0) return false;
+
+	_configuration = ghost::ConnectionConfigurationGRPC();
+	_configuration.setServerIpAddress("127.0.0.1");
+	_configuration.setServerPortNumber(PORT);
+
+	_server = _connectionManager->createServer(_configuration);
+	require(_server.operator bool());
+	if (!_server) return false;
+
+	_server->setClientHandler(std::make_shared<GreetingHandler>());
+	bool serverStartResult = _server->start();
+	require(serverStartResult);
+
+	// the server keeps a few clients waiting for a connection, they are not leftovers of the churn
+	_idleServerClients = std::dynamic_pointer_cast<ghost::internal::ServerGRPC>(_server)->countClients();
+
+	return serverStartResult;
+}
+
+void ConnectionChurnTest::tearDown()
+{
+	if (_server) _server->stop();
+	_server.reset();
+	_connectionManager.reset();
+}
+
+bool ConnectionChurnTest::run()
+{
+	return runChurn() && runCleanup() && runShutdown();
+}
+
+bool ConnectionChurnTest::runChurn()
+{
+	GHOST_INFO(_logger) << "Churn: connecting and disconnecting " << _clientsCount << " clients from "
+			    << _concurrency << " threads.";
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < _concurrency; ++i) threads.emplace_back(&ConnectionChurnTest::churnThread, this);
+
+	auto nextLog = start + std::chrono::seconds(1);
+	while (_connectedClients + _failedClients < _clientsCount && getState() == State::EXECUTING)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		if (nextLog < std::chrono::steady_clock::now())
+		{
+			GHOST_INFO(_logger) << "Churned clients: " << _connectedClients << " (" << _failedClients
+					    << " failed)";
+			nextLog = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+		}
+	}
+	for (auto& thread : threads) thread.join();
+
+	auto elapsed =
+	    std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start).count();
+	if (elapsed > 0.0) _connectionRate = _connectedClients / elapsed;
+
+	require(_failedClients == 0);
+	return true;
+}
+
+bool ConnectionChurnTest::runCleanup()
+{
+	// the disconnected clients are released by the server's client manager, measure how long it takes
+	auto serverGRPC = std::dynamic_pointer_cast<ghost::internal::ServerGRPC>(_server);
+	auto start = std::chrono::steady_clock::now();
+	auto deadline = start + std::chrono::seconds(30);
+	while (serverGRPC->countClients() > _idleServerClients && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	_cleanupTime =
+	    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	size_t serverClients = serverGRPC->countClients();
+	_remainingServerClients = serverClients > _idleServerClients ? serverClients - _idleServerClients : 0;
+	require(_remainingServerClients == 0);
+	return true;
+}
+
+bool ConnectionChurnTest::runShutdown()
+{
+	GHOST_INFO(_logger) << "Shutdown: stopping the server with " << _lingeringCount << " connected clients.";
+
+	std::vector<std::shared_ptr<ghost::Client>> lingeringClients;
+	for (size_t i = 0; i < _lingeringCount && getState() == State::EXECUTING; ++i)
+	{
+		std::chrono::steady_clock::duration connectTime, firstMessageTime;
+		auto client = connectClient(connectTime, firstMessageTime);
+		require(client.operator bool());
+		if (!client) return false;
+		lingeringClients.push_back(client);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	bool stopResult = _server->stop();
+	_serverStopTime =
+	    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	require(stopResult);
+
+	for (auto& client : lingeringClients) client->stop();
+	return true;
+}
+
+void ConnectionChurnTest::churnThread()
+{
+	while (_nextClient++ < _clientsCount && getState() == State::EXECUTING)
+	{
+		std::chrono::steady_clock::duration connectTime, firstMessageTime;
+		auto client = connectClient(connectTime, firstMessageTime);
+		if (!client)
+		{
+			_failedClients++;
+			continue;
+		}
+
+		auto stopStart = std::chrono::steady_clock::now();
+		client->stop();
+		auto stopTime = std::chrono::steady_clock::now() - stopStart;
+
+		_connectLatencies.record(std::chrono::duration_cast<std::chrono::microseconds>(connectTime));
+		_firstMessageLatencies.record(std::chrono::duration_cast<std::chrono::microseconds>(firstMessageTime));
+		_disconnectLatencies.record(std::chrono::duration_cast<std::chrono::microseconds>(stopTime));
+		_connectedClients++;
+	}
+}
+
+std::shared_ptr<ghost::Client> ConnectionChurnTest::connectClient(std::chrono::steady_clock::duration& connectTime,
+								  std::chrono::steady_clock::duration& firstMessageTime)
+{
+	auto client = _connectionManager->createClient(_configuration);
+	if (!client) return nullptr;
+
+	// the greeting is the only message, the promise is only set once
+	auto greeting = std::make_shared<std::promise<std::chrono::steady_clock::time_point>>();
+	auto greetingReceived = greeting->get_future();
+	auto messageHandler = client->addMessageHandler();
+	messageHandler->addHandler<google::protobuf::StringValue>(
+	    [greeting](const google::protobuf::StringValue&) { greeting->set_value(std::chrono::steady_clock::now()); });
+
+	auto start = std::chrono::steady_clock::now();
+	bool startResult = client->start();
+	connectTime = std::chrono::steady_clock::now() - start;
+	if (!startResult) return nullptr;
+
+	if (greetingReceived.wait_for(std::chrono::seconds(5)) != std::future_status::ready)
+	{
+		client->stop();
+		return nullptr;
+	}
+	firstMessageTime = greetingReceived.get() - start;
+
+	return client;
+}
+
+void ConnectionChurnTest::onPrintSummary() const
+{
+	GHOST_INFO(_logger) << "Churned " << _connectedClients << " clients (" << _failedClients
+			    << " failed) at " << static_cast<long long>(_connectionRate) << " connections/s.";
+	_connectLatencies.print(_logger, "Connection time");
+	_firstMessageLatencies.print(_logger, "Time to first message");
+	_disconnectLatencies.print(_logger, "Disconnection time");
+	GHOST_INFO(_logger) << "Server released the disconnected clients after " << _cleanupTime.count() << " us ("
+			    << _remainingServerClients << " left).";
+	GHOST_INFO(_logger) << "Server stopped with " << _lingeringCount << " connected clients in "
+			    << _serverStopTime.count() << " us.";
+}
+
+std::string ConnectionChurnTest::getName() const
+{
+	return TEST_NAME;
+}
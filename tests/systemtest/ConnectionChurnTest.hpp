@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GHOST_TESTS_CONNECTIONCHURNTEST_HPP
+#define GHOST_TESTS_CONNECTIONCHURNTEST_HPP
+
+#include <google/protobuf/wrappers.pb.h>
+
+#include <atomic>
+#include <ghost/connection/Client.hpp>
+#include <ghost/connection/ClientHandler.hpp>
+#include <ghost/connection/ConnectionManager.hpp>
+#include <ghost/connection/Server.hpp>
+#include <ghost/connection_grpc/ConnectionConfigurationGRPC.hpp>
+#include <memory>
+
+#include "LatencyHistogram.hpp"
+#include "Systemtest.hpp"
+
+/**
+ *	Connects and disconnects many short-lived clients to a single server, as it happens during rolling
+ *	deploys. The server greets every client with one message.
+ *	The test runs in three phases:
+ *	- churn: "clients" clients (default 2000) are connected, wait for the greeting and disconnect, from
+ *	"concurrency" threads (default 8). Measures the connection rate, the connection time, the
+ *	time-to-first-message and the disconnection time.
+ *	- cleanup: measures how long the server needs to release the disconnected clients.
+ *	- shutdown: connects "lingering" clients (default 500) that stay connected and measures how long the
+ *	server needs to stop.
+ */
+class ConnectionChurnTest : public Systemtest
+{
+public:
+	ConnectionChurnTest(const std::shared_ptr<ghost::ThreadPool>& threadPool,
+			    const std::shared_ptr<ghost::Logger>& logger);
+
+	std::string getName() const override;
+
+private:
+	/// Sends one greeting message to every connected client and keeps it alive until it disconnects.
+	class GreetingHandler : public ghost::ClientHandler
+	{
+	public:
+		bool handle(std::shared_ptr<ghost::Client> client, bool& keepClientAlive) override;
+	};
+
+	bool setUp() override;
+	void tearDown() override;
+	bool run() override;
+	void onPrintSummary() const override;
+
+	bool runChurn();
+	bool runCleanup();
+	bool runShutdown();
+	void churnThread();
+	/// Starts a client and waits for the greeting of the server. Returns nullptr if one of them failed.
+	std::shared_ptr<ghost::Client> connectClient(std::chrono::steady_clock::duration& connectTime,
+						     std::chrono::steady_clock::duration& firstMessageTime);
+
+	static const std::string TEST_NAME;
+	static const int PORT;
+
+	std::shared_ptr<ghost::ConnectionManager> _connectionManager;
+	std::shared_ptr<ghost::Server> _server;
+	ghost::ConnectionConfigurationGRPC _configuration;
+	size_t _idleServerClients;
+
+	// configuration read from the command line
+	long long _clientsCount;
+	size_t _concurrency;
+	size_t _lingeringCount;
+
+	// statistics
+	std::atomic<long long> _nextClient;
+	std::atomic<long long> _connectedClients;
+	std::atomic<long long> _failedClients;
+	double _connectionRate;
+	LatencyHistogram _connectLatencies;
+	LatencyHistogram _firstMessageLatencies;
+	LatencyHistogram _disconnectLatencies;
+	std::chrono::microseconds _cleanupTime;
+	size_t _remainingServerClients;
+	std::chrono::microseconds _serverStopTime;
+};
+
+#endif // GHOST_TESTS_CONNECTIONCHURNTEST_HPP
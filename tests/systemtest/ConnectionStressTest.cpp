@@ -16,13 +16,20 @@
 
 #include "ConnectionStressTest.hpp"
 
+#include <algorithm>
 #include <thread>
 
 const std::string ConnectionStressTest::TEST_NAME = "ConnectionStress";
+const long long ConnectionStressTest::DEFAULT_OPEN_LOOP_RATE = 10'000;
 
 ConnectionStressTest::ConnectionStressTest(const std::shared_ptr<ghost::ThreadPool>& threadPool,
 					   const std::shared_ptr<ghost::Logger>& logger)
-    : Systemtest(threadPool, logger), _messageSentIndex(0)
+    : Systemtest(threadPool, logger)
+    , _messageSentIndex(0)
+    , _openLoop(false)
+    , _openLoopRate(DEFAULT_OPEN_LOOP_RATE)
+    , _maxSendLag(0)
+    , _achievedRate(0.0)
 {
 }
 
@@ -32,11 +39,22 @@ bool ConnectionStressTest::setUp()
 	ghost::ConnectionGRPC::initialize(_connectionManager, _threadPool);
 	_messageSentIndex = 0;
 	_messageReceivedIndex.clear();
+	_maxSendLag = std::chrono::steady_clock::duration::zero();
+	_achievedRate = 0.0;
+	_latencies.reset();
+
+	// read the load mode from the command line: "mode=open rate=<messages per second>"
+	const auto& commandLine = getParameter().commandLine;
+	_openLoop = commandLine.hasParameter("mode") && commandLine.getParameter<std::string>("mode") == "open";
+	_openLoopRate = DEFAULT_OPEN_LOOP_RATE;
+	if (commandLine.hasParameter("rate")) _openLoopRate = commandLine.getParameter<long long>("rate");
+	if (_openLoopRate <= 0) return false;
 
 	// set up the configuration to use for the static pubsub
 	ghost::ConnectionConfigurationGRPC configuration;
 	configuration.setServerPortNumber(17000);
 	configuration.setOperationBlocking(false);
+	_configuration = configuration;
 
 	// create a publisher to send test messages
 	auto publisher = _connectionManager->createPublisher(configuration);
@@ -83,6 +101,13 @@ void ConnectionStressTest::tearDown()
 }
 
 bool ConnectionStressTest::run()
+{
+	if (_openLoop) return runOpenLoop();
+
+	return runClosedLoop();
+}
+
+bool ConnectionStressTest::runClosedLoop()
 {
 	auto state = getState();
 	auto nextLog = std::chrono::steady_clock::now();
@@ -121,17 +146,107 @@ bool ConnectionStressTest::run()
 	return true;
 }
 
+bool ConnectionStressTest::runOpenLoop()
+{
+	GHOST_INFO(_logger) << "Open-loop mode: sending " << _openLoopRate << " messages per second.";
+	printConfiguration();
+
+	auto start = std::chrono::steady_clock::now();
+	auto now = start;
+	auto nextLog = start;
+
+	auto state = getState();
+	while (state == State::EXECUTING && checkTestDuration())
+	{
+		// The schedule is fixed in advance and never waits for the subscriber: if the writer stalls, the
+		// following messages are sent as fast as possible, and their latency includes the stall.
+		auto intended = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					    std::chrono::nanoseconds(_messageSentIndex * 1'000'000'000LL / _openLoopRate));
+		now = std::chrono::steady_clock::now();
+		if (now < intended)
+			std::this_thread::sleep_until(intended);
+		else
+			_maxSendLag = std::max(_maxSendLag, now - intended);
+
+		auto msg = google::protobuf::StringValue::default_instance();
+		msg.set_value(std::to_string(_messageSentIndex) + ":" +
+			      std::to_string(
+				  std::chrono::duration_cast<std::chrono::nanoseconds>(intended.time_since_epoch()).count()));
+		bool writeResult = _publisherWriter->write(msg);
+		_messageSentIndex++;
+		require(writeResult);
+
+		if (nextLog < std::chrono::steady_clock::now())
+		{
+			GHOST_INFO(_logger) << "Sending messages: " << _messageSentIndex
+					    << ", current p99 latency: " << _latencies.percentile(99.0).count() << " us";
+			nextLog = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+		}
+
+		state = getState();
+	}
+
+	now = std::chrono::steady_clock::now();
+	auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(now - start).count();
+	if (elapsed > 0.0) _achievedRate = _messageSentIndex / elapsed;
+
+	// Give the messages in flight a chance to arrive so that they are part of the distribution.
+	auto drainDeadline = now + std::chrono::seconds(2);
+	while (_messageReceivedIndex[0] < _messageSentIndex && std::chrono::steady_clock::now() < drainDeadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	return true;
+}
+
 void ConnectionStressTest::onPrintSummary() const
 {
 	GHOST_INFO(_logger) << "Sent " << _messageSentIndex << " and received " << _messageReceivedIndex[0]
 			    << " messages.";
+
+	if (_openLoop)
+	{
+		GHOST_INFO(_logger) << "Open-loop target rate: " << _openLoopRate
+				    << " msg/s, achieved rate: " << static_cast<long long>(_achievedRate)
+				    << " msg/s, max send lag: "
+				    << std::chrono::duration_cast<std::chrono::microseconds>(_maxSendLag).count()
+				    << " us.";
+		printConfiguration();
+		_latencies.print(_logger, "Latency from intended send time");
+	}
+}
+
+void ConnectionStressTest::printConfiguration() const
+{
+	GHOST_INFO(_logger) << "Configuration:";
+	GHOST_INFO(_logger) << "  blocking operations: " << (_configuration.isOperationBlocking() ? "on" : "off");
+	// a high watermark of 0 means that the writers never wait for the subscribers
+	GHOST_INFO(_logger) << "  writer watermarks: " << _configuration.getWriterHighWatermark() << "/"
+			    << _configuration.getWriterLowWatermark() << " messages, "
+			    << _configuration.getWriterHighWatermarkBytes() << "/"
+			    << _configuration.getWriterLowWatermarkBytes() << " bytes";
+	GHOST_INFO(_logger) << "  max coalescing delay: " << _configuration.getWriterMaxCoalescingDelay().count()
+			    << " us";
+	GHOST_INFO(_logger) << "  server shards: " << _configuration.getServerShards();
+	GHOST_INFO(_logger) << "  sequence numbers: " << (_configuration.isSequenceNumbersEnabled() ? "on" : "off");
 }
 
 bool ConnectionStressTest::messageHandler(const google::protobuf::StringValue& message, size_t subscriberId)
 {
-	long long newIndex = std::stoll(message.value());
+	const std::string& value = message.value();
+	long long newIndex = std::stoll(value);
 	require(newIndex >= _messageReceivedIndex[subscriberId]);
 	_messageReceivedIndex[subscriberId]++;
+
+	// open-loop messages carry their intended send time after the index
+	auto separator = value.find(':');
+	if (separator != std::string::npos)
+	{
+		std::chrono::steady_clock::time_point intended(
+		    std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::nanoseconds(std::stoll(value.substr(separator + 1)))));
+		_latencies.record(
+		    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - intended));
+	}
 	return true;
 }
 
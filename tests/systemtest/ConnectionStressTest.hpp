@@ -24,8 +24,18 @@
 #include <ghost/connection/Writer.hpp>
 #include <ghost/connection_grpc/ConnectionGRPC.hpp>
 
+#include "LatencyHistogram.hpp"
 #include "Systemtest.hpp"
 
+/**
+ *	Sends as many messages as possible from a publisher to a subscriber.
+ *	Two load modes are available through the command line parameter "mode":
+ *	- "closed" (default): the sender pauses every 100'000 messages until the subscriber caught up.
+ *	- "open": messages are scheduled at a fixed rate (parameter "rate", in messages per second) and the
+ *	latency is measured from the intended send time, which accounts for coordinated omission: a message
+ *	that could not be sent on time because the sender was stalled is reported with the full delay.
+ *	The summary records the settings of the configuration, which shape the measured latencies.
+ */
 class ConnectionStressTest : public Systemtest
 {
 public:
@@ -40,15 +50,28 @@ private:
 	bool run() override;
 	void onPrintSummary() const override;
 
+	bool runClosedLoop();
+	bool runOpenLoop();
+	void printConfiguration() const;
+
 	static const std::string TEST_NAME;
+	static const long long DEFAULT_OPEN_LOOP_RATE;
 
 	bool messageHandler(const google::protobuf::StringValue& message, size_t subscriberId);
 
 	std::shared_ptr<ghost::ConnectionManager> _connectionManager;
+	ghost::ConnectionConfigurationGRPC _configuration;
 
 	std::shared_ptr<ghost::Writer<google::protobuf::StringValue>> _publisherWriter;
 	long long _messageSentIndex;
 	std::vector<long long> _messageReceivedIndex;
+
+	// open-loop statistics
+	bool _openLoop;
+	long long _openLoopRate;
+	std::chrono::steady_clock::duration _maxSendLag;
+	double _achievedRate;
+	LatencyHistogram _latencies;
 };
 
 #endif // GHOST_TESTS_CONNECTIONSTRESSTEST_HPP
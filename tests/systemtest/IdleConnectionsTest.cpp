@@ -0,0 +1,209 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "IdleConnectionsTest.hpp"
+
+#include <fstream>
+#include <future>
+#include <ghost/connection_grpc/ConnectionGRPC.hpp>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include "../../src/connection_grpc/ClientGRPC.hpp"
+#include "../../src/connection_grpc/RemoteClientGRPC.hpp"
+#include "../../src/connection_grpc/ServerGRPC.hpp"
+
+const std::string IdleConnectionsTest::TEST_NAME = "IdleConnections";
+const int IdleConnectionsTest::PORT = 17400;
+
+IdleConnectionsTest::IdleConnectionsTest(const std::shared_ptr<ghost::ThreadPool>& threadPool,
+					 const std::shared_ptr<ghost::Logger>& logger)
+    : Systemtest(threadPool, logger), _clientsCount(10000), _holdDuration(10), _connectedClients(0)
+{
+}
+
+void IdleConnectionsTest::IdleHandler::onMessage(const std::shared_ptr<ghost::Client>& /*client*/,
+						 const google::protobuf::Any& /*message*/)
+{
+}
+
+bool IdleConnectionsTest::setUp()
+{
+	_usages.clear();
+	_connectedClients = 0;
+
+	const auto& commandLine = getParameter().commandLine;
+
+	_clientsCount = 10000;
+	if (commandLine.hasParameter("clients"))
+		_clientsCount = static_cast<size_t>(commandLine.getParameter<long long>("clients"));
+
+	_holdDuration = std::chrono::seconds(10);
+	if (commandLine.hasParameter("holdDuration"))
+		_holdDuration = std::chrono::seconds(commandLine.getParameter<long long>("holdDuration"));
+
+	recordUsage("baseline");
+
+	_connectionManager = ghost::ConnectionManager::create();
+	ghost::ConnectionGRPC::initialize(_connectionManager, _threadPool);
+
+	ghost::ConnectionConfigurationGRPC configuration;
+	configuration.setServerIpAddress("127.0.0.1");
+	configuration.setServerPortNumber(PORT);
+	configuration.setOperationBlocking(false);
+
+	_server = _connectionManager->createServer(configuration);
+	require(_server.operator bool());
+	if (!_server) return false;
+	_server->setClientHandler(std::make_shared<IdleHandler>());
+
+	bool startResult = _server->start();
+	require(startResult);
+	if (startResult) recordUsage("server started");
+	return startResult;
+}
+
+void IdleConnectionsTest::tearDown()
+{
+	if (_server) _server->stop();
+	_server.reset();
+	_connectionManager.reset();
+}
+
+bool IdleConnectionsTest::run()
+{
+	ghost::ConnectionConfigurationGRPC configuration;
+	configuration.setServerIpAddress("127.0.0.1");
+	configuration.setServerPortNumber(PORT);
+	configuration.setOperationBlocking(false);
+
+	GHOST_INFO(_logger) << "Connecting " << _clientsCount << " clients.";
+
+	// the clients connect concurrently, by batches so that the accept queue of the server does not overflow
+	const size_t batchSize = 500;
+	std::vector<std::shared_ptr<ghost::Client>> clients;
+	clients.reserve(_clientsCount);
+	auto connectStart = std::chrono::steady_clock::now();
+	while (clients.size() < _clientsCount && getState() == State::EXECUTING)
+	{
+		std::vector<std::shared_future<bool>> connections;
+		for (size_t i = 0; i < batchSize && clients.size() < _clientsCount; ++i)
+		{
+			auto client = _connectionManager->createClient(configuration);
+			auto clientGRPC = std::dynamic_pointer_cast<ghost::internal::ClientGRPC>(client);
+			require(clientGRPC.operator bool());
+			if (!clientGRPC) return false;
+
+			connections.push_back(clientGRPC->startAsync());
+			clients.push_back(client);
+		}
+
+		for (auto& connection : connections)
+		{
+			if (connection.get()) _connectedClients++;
+		}
+		GHOST_INFO(_logger) << "Connected clients: " << _connectedClients << "/" << clients.size();
+	}
+	auto connectTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+										  connectStart);
+	require(_connectedClients == _clientsCount);
+
+	// wait until the server accepted all the connections
+	auto serverGRPC = std::dynamic_pointer_cast<ghost::internal::ServerGRPC>(_server);
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+	while (serverGRPC->countClients() < _connectedClients && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	GHOST_INFO(_logger) << _connectedClients << " clients connected in " << connectTime.count() << " ms.";
+	recordUsage("clients connected");
+
+	auto holdEnd = std::chrono::steady_clock::now() + _holdDuration;
+	while (std::chrono::steady_clock::now() < holdEnd && getState() == State::EXECUTING)
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	recordUsage("end of hold");
+
+	size_t stillRunning = 0;
+	for (const auto& client : clients)
+	{
+		if (client->isRunning()) stillRunning++;
+	}
+	require(stillRunning == _connectedClients);
+
+	for (auto& client : clients) client->stop();
+	return true;
+}
+
+void IdleConnectionsTest::onPrintSummary() const
+{
+	GHOST_INFO(_logger) << "Process usage with " << _connectedClients << " idle connections:";
+	GHOST_INFO(_logger) << std::setw(20) << "" << std::setw(12) << "RSS kB" << std::setw(10) << "threads";
+	for (const auto& usage : _usages)
+		GHOST_INFO(_logger) << std::setw(20) << usage.label << std::setw(12) << usage.residentBytes / 1024
+				    << std::setw(10) << usage.threads;
+
+	// the server's own footprint is excluded: the difference is what the connections cost
+	if (_usages.size() >= 3 && _connectedClients > 0)
+	{
+		const auto& started = _usages[1];
+		const auto& connected = _usages[2];
+		long long bytes = static_cast<long long>(connected.residentBytes) - started.residentBytes;
+		long long threads = static_cast<long long>(connected.threads) - started.threads;
+		GHOST_INFO(_logger) << "Per connection (client and server ends): "
+				    << bytes / static_cast<long long>(_connectedClients) << " bytes, " << threads
+				    << " additional threads in total.";
+	}
+
+	// the objects held by every connection, without the settings shared by the server and the buffers of gRPC
+	size_t serverEnd = sizeof(ghost::internal::RemoteClientGRPC) + sizeof(ghost::internal::IncomingRPC) +
+			   sizeof(ghost::internal::WriterQueue);
+	size_t clientEnd = sizeof(ghost::internal::ClientGRPC) + sizeof(ghost::internal::WriterQueue);
+	GHOST_INFO(_logger) << "Connection objects: " << serverEnd << " bytes at the server end (RemoteClientGRPC "
+			    << sizeof(ghost::internal::RemoteClientGRPC) << ", IncomingRPC "
+			    << sizeof(ghost::internal::IncomingRPC) << ", WriterQueue "
+			    << sizeof(ghost::internal::WriterQueue) << "), " << clientEnd
+			    << " bytes at the client end.";
+}
+
+void IdleConnectionsTest::recordUsage(const std::string& label)
+{
+	ProcessUsage usage{label, 0, 0};
+
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line))
+	{
+		std::istringstream fields(line);
+		std::string key;
+		fields >> key;
+		if (key == "VmRSS:")
+		{
+			size_t kilobytes = 0;
+			fields >> kilobytes;
+			usage.residentBytes = kilobytes * 1024;
+		}
+		else if (key == "Threads:")
+			fields >> usage.threads;
+	}
+
+	_usages.push_back(usage);
+}
+
+std::string IdleConnectionsTest::getName() const
+{
+	return TEST_NAME;
+}
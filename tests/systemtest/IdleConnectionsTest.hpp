@@ -0,0 +1,89 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_TESTS_IDLECONNECTIONSTEST_HPP
+#define GHOST_TESTS_IDLECONNECTIONSTEST_HPP
+
+#include <google/protobuf/any.pb.h>
+
+#include <ghost/connection/ConnectionManager.hpp>
+#include <ghost/connection/Server.hpp>
+#include <ghost/connection_grpc/AsyncClientHandlerGRPC.hpp>
+#include <memory>
+#include <vector>
+
+#include "Systemtest.hpp"
+
+/**
+ *	Measures the cost of idle connections: a server and "clients" clients (default 10000) are started in
+ *	this process and held connected without exchanging messages during "holdDuration" seconds (default 10).
+ *	The resident memory and the number of threads of the process are reported before the server starts,
+ *	once the server started, once all the clients are connected and at the end of the hold, together
+ *	with the memory used per connection (both ends included) and the size of the objects that every connection
+ *	holds.
+ *	The server uses a ghost::AsyncClientHandlerGRPC, so that no thread is reserved per client.
+ *	Each connection uses two file descriptors in this process, the limit of open files must be raised
+ *	accordingly (e.g. "ulimit -n 32768").
+ */
+class IdleConnectionsTest : public Systemtest
+{
+public:
+	IdleConnectionsTest(const std::shared_ptr<ghost::ThreadPool>& threadPool,
+			    const std::shared_ptr<ghost::Logger>& logger);
+
+	std::string getName() const override;
+
+private:
+	/// Accepts the clients and ignores their messages.
+	class IdleHandler : public ghost::AsyncClientHandlerGRPC
+	{
+	public:
+		void onMessage(const std::shared_ptr<ghost::Client>& client,
+			       const google::protobuf::Any& message) override;
+	};
+
+	struct ProcessUsage
+	{
+		std::string label;
+		size_t residentBytes;
+		size_t threads;
+	};
+
+	bool setUp() override;
+	void tearDown() override;
+	bool run() override;
+	void onPrintSummary() const override;
+
+	/// Reads the resident memory and the thread count of this process from /proc/self/status (Linux only,
+	/// zeros elsewhere).
+	void recordUsage(const std::string& label);
+
+	static const std::string TEST_NAME;
+	static const int PORT;
+
+	std::shared_ptr<ghost::ConnectionManager> _connectionManager;
+	std::shared_ptr<ghost::Server> _server;
+
+	// configuration read from the command line
+	size_t _clientsCount;
+	std::chrono::seconds _holdDuration;
+
+	size_t _connectedClients;
+	std::vector<ProcessUsage> _usages;
+};
+
+#endif // GHOST_TESTS_IDLECONNECTIONSTEST_HPP
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <limits>
+
+const size_t LatencyHistogram::SUB_BUCKET_BITS = 7;
+const size_t LatencyHistogram::SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+const size_t LatencyHistogram::LINEAR_BUCKETS = 2 * SUB_BUCKETS;
+const size_t LatencyHistogram::MAX_SHIFT = 34;
+
+LatencyHistogram::LatencyHistogram()
+    : _counts(LINEAR_BUCKETS + MAX_SHIFT * SUB_BUCKETS, 0)
+    , _count(0)
+    , _sum(0)
+    , _min(std::numeric_limits<uint64_t>::max())
+    , _max(0)
+{
+}
+
+LatencyHistogram::LatencyHistogram(const LatencyHistogram& other) : LatencyHistogram()
+{
+	merge(other);
+}
+
+LatencyHistogram& LatencyHistogram::operator=(const LatencyHistogram& other)
+{
+	if (this != &other)
+	{
+		reset();
+		merge(other);
+	}
+	return *this;
+}
+
+void LatencyHistogram::record(const std::chrono::microseconds& latency)
+{
+	uint64_t value = latency.count() > 0 ? static_cast<uint64_t>(latency.count()) : 0;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_counts[indexOf(value)]++;
+	_count++;
+	_sum += value;
+	_min = std::min(_min, value);
+	_max = std::max(_max, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+	if (this == &other) return;
+
+	std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+	std::unique_lock<std::mutex> otherLock(other._mutex, std::defer_lock);
+	std::lock(lock, otherLock);
+
+	for (size_t i = 0; i < _counts.size(); ++i) _counts[i] += other._counts[i];
+	_count += other._count;
+	_sum += other._sum;
+	_min = std::min(_min, other._min);
+	_max = std::max(_max, other._max);
+}
+
+void LatencyHistogram::reset()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	std::fill(_counts.begin(), _counts.end(), 0);
+	_count = 0;
+	_sum = 0;
+	_min = std::numeric_limits<uint64_t>::max();
+	_max = 0;
+}
+
+uint64_t LatencyHistogram::count() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _count;
+}
+
+std::chrono::microseconds LatencyHistogram::min() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return std::chrono::microseconds(_count == 0 ? 0 : _min);
+}
+
+std::chrono::microseconds LatencyHistogram::max() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return std::chrono::microseconds(_max);
+}
+
+std::chrono::microseconds LatencyHistogram::mean() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return std::chrono::microseconds(_count == 0 ? 0 : _sum / _count);
+}
+
+std::chrono::microseconds LatencyHistogram::percentile(double percentile) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_count == 0) return std::chrono::microseconds(0);
+
+	percentile = std::max(0.0, std::min(100.0, percentile));
+	uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * _count + 0.5);
+	rank = std::max<uint64_t>(1, std::min(rank, _count));
+
+	uint64_t accumulated = 0;
+	for (size_t i = 0; i < _counts.size(); ++i)
+	{
+		accumulated += _counts[i];
+		// the bucket's lower bound may be below the smallest value actually recorded
+		if (accumulated >= rank) return std::chrono::microseconds(std::min(std::max(valueAt(i), _min), _max));
+	}
+	return std::chrono::microseconds(_max);
+}
+
+void LatencyHistogram::print(const std::shared_ptr<ghost::Logger>& logger, const std::string& label) const
+{
+	if (!logger) return;
+
+	GHOST_INFO(logger) << label << ": count=" << count() << " mean=" << mean().count()
+			   << " us p50=" << percentile(50.0).count() << " us p90=" << percentile(90.0).count()
+			   << " us p99=" << percentile(99.0).count() << " us p99.9=" << percentile(99.9).count()
+			   << " us max=" << max().count() << " us";
+}
+
+size_t LatencyHistogram::indexOf(uint64_t value)
+{
+	if (value < LINEAR_BUCKETS) return static_cast<size_t>(value);
+
+	// position of the most significant bit, greater than SUB_BUCKET_BITS since value >= LINEAR_BUCKETS
+	size_t msb = 0;
+	for (uint64_t v = value; v > 1; v >>= 1) msb++;
+
+	// keeps the SUB_BUCKET_BITS + 1 most significant bits, i.e. a mantissa in [SUB_BUCKETS, 2 * SUB_BUCKETS[
+	size_t shift = msb - SUB_BUCKET_BITS;
+	if (shift > MAX_SHIFT) return LINEAR_BUCKETS + MAX_SHIFT * SUB_BUCKETS - 1;
+
+	size_t mantissa = static_cast<size_t>(value >> shift);
+	return LINEAR_BUCKETS + (shift - 1) * SUB_BUCKETS + (mantissa - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::valueAt(size_t index)
+{
+	if (index < LINEAR_BUCKETS) return index;
+
+	size_t offset = index - LINEAR_BUCKETS;
+	size_t shift = offset / SUB_BUCKETS + 1;
+	uint64_t mantissa = offset % SUB_BUCKETS + SUB_BUCKETS;
+	return mantissa << shift;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GHOST_TESTS_LATENCYHISTOGRAM_HPP
+#define GHOST_TESTS_LATENCYHISTOGRAM_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ghost/module/Logger.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ *	Log-linear histogram of latencies with microsecond resolution.
+ *	Values below 256 us are recorded exactly, larger values keep 8 significant bits
+ *	(relative error below 0.8%). The memory footprint is fixed and small (~36 kB), which allows
+ *	recording millions of samples during long running system tests, and keeping one histogram
+ *	per connection when hundreds of connections are measured.
+ */
+class LatencyHistogram
+{
+public:
+	LatencyHistogram();
+	LatencyHistogram(const LatencyHistogram& other);
+	LatencyHistogram& operator=(const LatencyHistogram& other);
+
+	void record(const std::chrono::microseconds& latency);
+	void merge(const LatencyHistogram& other);
+	void reset();
+
+	uint64_t count() const;
+	std::chrono::microseconds min() const;
+	std::chrono::microseconds max() const;
+	std::chrono::microseconds mean() const;
+	/// @param percentile value between 0 and 100.
+	std::chrono::microseconds percentile(double percentile) const;
+
+	/// Logs count, mean, p50, p90, p99, p99.9 and max on one line.
+	void print(const std::shared_ptr<ghost::Logger>& logger, const std::string& label) const;
+
+private:
+	static size_t indexOf(uint64_t value);
+	static uint64_t valueAt(size_t index);
+
+	static const size_t SUB_BUCKET_BITS;
+	static const size_t SUB_BUCKETS;
+	static const size_t LINEAR_BUCKETS;
+	static const size_t MAX_SHIFT;
+
+	std::vector<uint64_t> _counts;
+	uint64_t _count;
+	uint64_t _sum;
+	uint64_t _min;
+	uint64_t _max;
+	mutable std::mutex _mutex;
+};
+
+#endif // GHOST_TESTS_LATENCYHISTOGRAM_HPP
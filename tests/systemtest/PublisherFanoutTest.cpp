@@ -0,0 +1,269 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PublisherFanoutTest.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <ghost/connection_grpc/ConnectionGRPC.hpp>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include "../../src/connection_grpc/PublisherGRPC.hpp"
+
+const std::string PublisherFanoutTest::TEST_NAME = "PublisherFanout";
+const int PublisherFanoutTest::BASE_PORT = 17100;
+
+PublisherFanoutTest::PublisherFanoutTest(const std::shared_ptr<ghost::ThreadPool>& threadPool,
+					 const std::shared_ptr<ghost::Logger>& logger)
+    : Systemtest(threadPool, logger), _rate(1000), _stepDuration(5)
+{
+}
+
+bool PublisherFanoutTest::setUp()
+{
+	_connectionManager = ghost::ConnectionManager::create();
+	ghost::ConnectionGRPC::initialize(_connectionManager, _threadPool);
+	_results.clear();
+
+	const auto& commandLine = getParameter().commandLine;
+
+	// "steps=1,8,64,512"
+	_steps.clear();
+	std::string steps = "1,8,64,512";
+	if (commandLine.hasParameter("steps")) steps = commandLine.getParameter<std::string>("steps");
+	std::istringstream stepsStream(steps);
+	std::string step;
+	while (std::getline(stepsStream, step, ','))
+	{
+		if (!step.empty()) _steps.push_back(std::stoul(step));
+	}
+
+	_rate = 1000;
+	if (commandLine.hasParameter("rate")) _rate = commandLine.getParameter<long long>("rate");
+
+	_stepDuration = std::chrono::seconds(5);
+	if (commandLine.hasParameter("stepDuration"))
+		_stepDuration = std::chrono::seconds(commandLine.getParameter<long long>("stepDuration"));
+
+	require(!_steps.empty() && _rate > 0 && _stepDuration.count() > 0);
+	return !_steps.empty() && _rate > 0 && _stepDuration.count() > 0;
+}
+
+void PublisherFanoutTest::tearDown()
+{
+	_connectionManager.reset();
+	_subscriberStatistics.clear();
+}
+
+bool PublisherFanoutTest::run()
+{
+	for (size_t i = 0; i < _steps.size() && getState() == State::EXECUTING; ++i)
+	{
+		GHOST_INFO(_logger) << "Fanout step " << i + 1 << "/" << _steps.size() << ": " << _steps[i]
+				    << " subscribers.";
+		// every step uses a fresh publisher so that stale subscribers of the previous step are not counted
+		bool stepResult = runStep(_steps[i], BASE_PORT + static_cast<int>(i));
+		require(stepResult);
+		if (!stepResult) return false;
+	}
+
+	return true;
+}
+
+bool PublisherFanoutTest::runStep(size_t subscribersCount, int port)
+{
+	ghost::ConnectionConfigurationGRPC configuration;
+	configuration.setServerIpAddress("127.0.0.1");
+	configuration.setServerPortNumber(port);
+	configuration.setOperationBlocking(false);
+
+	auto publisher = _connectionManager->createPublisher(configuration);
+	require(publisher.operator bool());
+	if (!publisher) return false;
+
+	auto writer = publisher->getWriter<google::protobuf::StringValue>();
+	bool publisherStartResult = publisher->start();
+	require(publisherStartResult);
+	if (!publisherStartResult) return false;
+
+	_subscriberStatistics.clear();
+	std::vector<std::shared_ptr<ghost::Subscriber>> subscribers;
+	for (size_t i = 0; i < subscribersCount; ++i)
+	{
+		_subscriberStatistics.emplace_back(new SubscriberStatistics());
+
+		auto subscriber = _connectionManager->createSubscriber(configuration);
+		require(subscriber.operator bool());
+		if (!subscriber) return false;
+
+		auto messageHandler = subscriber->addMessageHandler();
+		messageHandler->addHandler<google::protobuf::StringValue>(
+		    std::bind(&PublisherFanoutTest::messageHandler, this, std::placeholders::_1, i));
+
+		bool subscriberStartResult = subscriber->start();
+		require(subscriberStartResult);
+		if (!subscriberStartResult) return false;
+		subscribers.push_back(subscriber);
+	}
+
+	// wait until the publisher knows all its subscribers
+	auto publisherGRPC = std::dynamic_pointer_cast<ghost::internal::PublisherGRPC>(publisher);
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+	while (publisherGRPC->countSubscribers() < subscribersCount && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	require(publisherGRPC->countSubscribers() == subscribersCount);
+
+	// publish at a fixed rate, latencies are measured from the intended send time
+	long long sent = 0;
+	auto start = std::chrono::steady_clock::now();
+	auto end = start + _stepDuration;
+	std::clock_t cpuStart = std::clock();
+	while (getState() == State::EXECUTING)
+	{
+		auto intended = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					    std::chrono::nanoseconds(sent * 1'000'000'000LL / _rate));
+		if (intended >= end) break;
+		if (std::chrono::steady_clock::now() < intended) std::this_thread::sleep_until(intended);
+
+		auto msg = google::protobuf::StringValue::default_instance();
+		msg.set_value(std::to_string(sent) + ":" +
+			      std::to_string(
+				  std::chrono::duration_cast<std::chrono::nanoseconds>(intended.time_since_epoch()).count()));
+		bool writeResult = writer->write(msg);
+		require(writeResult);
+		sent++;
+	}
+	auto sendEnd = std::chrono::steady_clock::now();
+
+	// let the subscribers receive what is still in flight
+	auto totalDelivered = [this]() {
+		long long delivered = 0;
+		for (const auto& statistics : _subscriberStatistics) delivered += statistics->received;
+		return delivered;
+	};
+	auto drainDeadline = sendEnd + std::chrono::seconds(5);
+	while (totalDelivered() < sent * static_cast<long long>(subscribersCount) &&
+	       std::chrono::steady_clock::now() < drainDeadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	auto deliveryEnd = std::chrono::steady_clock::now();
+	std::clock_t cpuEnd = std::clock();
+
+	// compute the step's statistics
+	StepResult result;
+	result.subscribers = subscribersCount;
+	result.sent = sent;
+	result.delivered = totalDelivered();
+
+	double sendSeconds = std::chrono::duration_cast<std::chrono::duration<double>>(sendEnd - start).count();
+	double deliverySeconds =
+	    std::chrono::duration_cast<std::chrono::duration<double>>(deliveryEnd - start).count();
+	result.sendRate = sendSeconds > 0.0 ? sent / sendSeconds : 0.0;
+	result.deliveredRate = deliverySeconds > 0.0 ? result.delivered / deliverySeconds : 0.0;
+	// process-wide: the subscribers run in this process too, they are part of the measured CPU time
+	result.cpuUsage =
+	    deliverySeconds > 0.0 ? (double(cpuEnd - cpuStart) / CLOCKS_PER_SEC) / deliverySeconds : 0.0;
+
+	std::vector<long long> p99s;
+	long long fastestMean = 0;
+	long long slowestMean = 0;
+	for (size_t i = 0; i < _subscriberStatistics.size(); ++i)
+	{
+		const auto& latencies = _subscriberStatistics[i]->latencies;
+		p99s.push_back(latencies.percentile(99.0).count());
+
+		long long mean = latencies.mean().count();
+		if (i == 0 || mean < fastestMean) fastestMean = mean;
+		if (i == 0 || mean > slowestMean) slowestMean = mean;
+	}
+	std::sort(p99s.begin(), p99s.end());
+	result.p99Fastest = p99s.empty() ? 0 : p99s.front();
+	result.p99Median = p99s.empty() ? 0 : p99s[p99s.size() / 2];
+	result.p99Slowest = p99s.empty() ? 0 : p99s.back();
+	result.meanSpread = slowestMean - fastestMean;
+	_results.push_back(result);
+
+	GHOST_INFO(_logger) << "Step with " << subscribersCount << " subscribers: delivered " << result.delivered
+			    << " of " << sent * static_cast<long long>(subscribersCount) << " messages, p99 "
+			    << result.p99Fastest << "/" << result.p99Median << "/" << result.p99Slowest
+			    << " us (fastest/median/slowest).";
+
+	for (auto& subscriber : subscribers) subscriber->stop();
+	publisher->stop();
+	_subscriberStatistics.clear();
+
+	return true;
+}
+
+void PublisherFanoutTest::onPrintSummary() const
+{
+	GHOST_INFO(_logger) << "Fanout scaling curve (target rate " << _rate << " msg/s, " << _stepDuration.count()
+			    << " s per step):";
+	GHOST_INFO(_logger) << std::setw(12) << "subscribers" << std::setw(12) << "sent/s" << std::setw(14)
+			    << "delivered/s" << std::setw(10) << "cpu" << std::setw(12) << "p99 min" << std::setw(12)
+			    << "p99 median" << std::setw(12) << "p99 max" << std::setw(14) << "mean spread";
+
+	for (const auto& result : _results)
+	{
+		std::ostringstream cpu;
+		cpu << std::fixed << std::setprecision(2) << result.cpuUsage;
+
+		GHOST_INFO(_logger) << std::setw(12) << result.subscribers << std::setw(12)
+				    << static_cast<long long>(result.sendRate) << std::setw(14)
+				    << static_cast<long long>(result.deliveredRate) << std::setw(10) << cpu.str()
+				    << std::setw(12) << result.p99Fastest << std::setw(12) << result.p99Median
+				    << std::setw(12) << result.p99Slowest << std::setw(14) << result.meanSpread;
+	}
+	GHOST_INFO(_logger) << "Latencies in us, cpu in cores used by the whole process.";
+
+	// the first step that did not deliver (almost) every message is where the fanout stops scaling
+	for (const auto& result : _results)
+	{
+		long long expected = result.sent * static_cast<long long>(result.subscribers);
+		if (expected > 0 && result.delivered < expected * 95 / 100)
+		{
+			GHOST_INFO(_logger) << "Fanout stops keeping up at " << result.subscribers << " subscribers ("
+					    << result.delivered << " of " << expected << " messages delivered).";
+			break;
+		}
+	}
+}
+
+void PublisherFanoutTest::messageHandler(const google::protobuf::StringValue& message, size_t subscriberId)
+{
+	if (subscriberId >= _subscriberStatistics.size()) return;
+
+	auto& statistics = *_subscriberStatistics[subscriberId];
+	statistics.received++;
+
+	const std::string& value = message.value();
+	auto separator = value.find(':');
+	if (separator != std::string::npos)
+	{
+		std::chrono::steady_clock::time_point intended(
+		    std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::nanoseconds(std::stoll(value.substr(separator + 1)))));
+		statistics.latencies.record(
+		    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - intended));
+	}
+}
+
+std::string PublisherFanoutTest::getName() const
+{
+	return TEST_NAME;
+}
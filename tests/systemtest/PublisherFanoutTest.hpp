@@ -0,0 +1,95 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GHOST_TESTS_PUBLISHERFANOUTTEST_HPP
+#define GHOST_TESTS_PUBLISHERFANOUTTEST_HPP
+
+#include <google/protobuf/wrappers.pb.h>
+
+#include <atomic>
+#include <ghost/connection/ConnectionManager.hpp>
+#include <ghost/connection/Writer.hpp>
+#include <memory>
+#include <vector>
+
+#include "LatencyHistogram.hpp"
+#include "Systemtest.hpp"
+
+/**
+ *	Measures how one publisher scales with the number of subscribers.
+ *	For each step of the ramp (parameter "steps", default: 1,8,64,512), a new publisher is started with
+ *	that many subscribers and messages are published at a fixed rate (parameter "rate", default 1000 msg/s)
+ *	during "stepDuration" seconds (default 5).
+ *	Each step records the process CPU usage, the aggregated delivered throughput, the p99 latency of every
+ *	subscriber and the spread between the fastest and the slowest subscriber. The summary prints the
+ *	resulting scaling curve.
+ */
+class PublisherFanoutTest : public Systemtest
+{
+public:
+	PublisherFanoutTest(const std::shared_ptr<ghost::ThreadPool>& threadPool,
+			    const std::shared_ptr<ghost::Logger>& logger);
+
+	std::string getName() const override;
+
+private:
+	struct SubscriberStatistics
+	{
+		SubscriberStatistics() : received(0)
+		{
+		}
+
+		std::atomic<long long> received;
+		LatencyHistogram latencies;
+	};
+
+	struct StepResult
+	{
+		size_t subscribers;
+		long long sent;
+		long long delivered;
+		double sendRate;
+		double deliveredRate;
+		double cpuUsage;
+		long long p99Fastest;
+		long long p99Median;
+		long long p99Slowest;
+		long long meanSpread;
+	};
+
+	bool setUp() override;
+	void tearDown() override;
+	bool run() override;
+	void onPrintSummary() const override;
+
+	bool runStep(size_t subscribersCount, int port);
+	void messageHandler(const google::protobuf::StringValue& message, size_t subscriberId);
+
+	static const std::string TEST_NAME;
+	static const int BASE_PORT;
+
+	std::shared_ptr<ghost::ConnectionManager> _connectionManager;
+
+	// configuration read from the command line
+	std::vector<size_t> _steps;
+	long long _rate;
+	std::chrono::seconds _stepDuration;
+
+	std::vector<std::unique_ptr<SubscriberStatistics>> _subscriberStatistics;
+	std::vector<StepResult> _results;
+};
+
+#endif // GHOST_TESTS_PUBLISHERFANOUTTEST_HPP
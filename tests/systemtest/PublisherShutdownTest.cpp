@@ -0,0 +1,178 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "PublisherShutdownTest.hpp"
+
+#include <algorithm>
+#include <future>
+#include <ghost/connection_grpc/ConnectionGRPC.hpp>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include "../../src/connection_grpc/PublisherGRPC.hpp"
+#include "../../src/connection_grpc/SubscriberGRPC.hpp"
+
+const std::string PublisherShutdownTest::TEST_NAME = "PublisherShutdown";
+const int PublisherShutdownTest::BASE_PORT = 17300;
+
+PublisherShutdownTest::PublisherShutdownTest(const std::shared_ptr<ghost::ThreadPool>& threadPool,
+					     const std::shared_ptr<ghost::Logger>& logger)
+    : Systemtest(threadPool, logger)
+{
+}
+
+bool PublisherShutdownTest::setUp()
+{
+	_connectionManager = ghost::ConnectionManager::create();
+	ghost::ConnectionGRPC::initialize(_connectionManager, _threadPool);
+	_results.clear();
+
+	const auto& commandLine = getParameter().commandLine;
+
+	// "steps=100,500,1000,2000"
+	_steps.clear();
+	std::string steps = "100,500,1000,2000";
+	if (commandLine.hasParameter("steps")) steps = commandLine.getParameter<std::string>("steps");
+	std::istringstream stepsStream(steps);
+	std::string step;
+	while (std::getline(stepsStream, step, ','))
+	{
+		if (!step.empty()) _steps.push_back(std::stoul(step));
+	}
+
+	require(!_steps.empty());
+	return !_steps.empty();
+}
+
+void PublisherShutdownTest::tearDown()
+{
+	_connectionManager.reset();
+}
+
+bool PublisherShutdownTest::run()
+{
+	for (size_t i = 0; i < _steps.size() && getState() == State::EXECUTING; ++i)
+	{
+		GHOST_INFO(_logger) << "Shutdown step " << i + 1 << "/" << _steps.size() << ": " << _steps[i]
+				    << " subscribers.";
+		// every step uses a fresh publisher and port, the previous one may still be in TIME_WAIT
+		bool stepResult = runStep(_steps[i], BASE_PORT + static_cast<int>(i));
+		require(stepResult);
+		if (!stepResult) return false;
+	}
+
+	return true;
+}
+
+bool PublisherShutdownTest::runStep(size_t subscribersCount, int port)
+{
+	ghost::ConnectionConfigurationGRPC configuration;
+	configuration.setServerIpAddress("127.0.0.1");
+	configuration.setServerPortNumber(port);
+	configuration.setOperationBlocking(false);
+
+	auto publisher = _connectionManager->createPublisher(configuration);
+	require(publisher.operator bool());
+	if (!publisher) return false;
+
+	bool publisherStartResult = publisher->start();
+	require(publisherStartResult);
+	if (!publisherStartResult) return false;
+
+	// the subscribers connect concurrently, the connection time is not what is measured here
+	auto connectStart = std::chrono::steady_clock::now();
+	std::vector<std::shared_ptr<ghost::Subscriber>> subscribers;
+	std::vector<std::shared_future<bool>> connections;
+	for (size_t i = 0; i < subscribersCount; ++i)
+	{
+		auto subscriber = _connectionManager->createSubscriber(configuration);
+		auto subscriberGRPC = std::dynamic_pointer_cast<ghost::internal::SubscriberGRPC>(subscriber);
+		require(subscriberGRPC.operator bool());
+		if (!subscriberGRPC) return false;
+
+		connections.push_back(subscriberGRPC->startAsync());
+		subscribers.push_back(subscriber);
+	}
+	size_t connected = 0;
+	for (auto& connection : connections)
+	{
+		if (connection.get()) connected++;
+	}
+	require(connected == subscribersCount);
+
+	// wait until the publisher knows all its subscribers
+	auto publisherGRPC = std::dynamic_pointer_cast<ghost::internal::PublisherGRPC>(publisher);
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+	while (publisherGRPC->countSubscribers() < subscribersCount && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	require(publisherGRPC->countSubscribers() == subscribersCount);
+	auto connectEnd = std::chrono::steady_clock::now();
+
+	// the measured operation
+	auto stopStart = std::chrono::steady_clock::now();
+	bool stopResult = publisher->stop();
+	auto stopEnd = std::chrono::steady_clock::now();
+	require(stopResult);
+
+	// the subscribers notice the end of their streams once the publisher finished them
+	auto disconnectDeadline = stopEnd + std::chrono::seconds(30);
+	auto countRunning = [&subscribers]() {
+		return std::count_if(subscribers.begin(), subscribers.end(),
+				     [](const std::shared_ptr<ghost::Subscriber>& s) { return s->isRunning(); });
+	};
+	while (countRunning() > 0 && std::chrono::steady_clock::now() < disconnectDeadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	auto disconnectEnd = std::chrono::steady_clock::now();
+	require(countRunning() == 0);
+
+	StepResult result;
+	result.subscribers = subscribersCount;
+	result.connectTime = std::chrono::duration_cast<std::chrono::microseconds>(connectEnd - connectStart);
+	result.stopTime = std::chrono::duration_cast<std::chrono::microseconds>(stopEnd - stopStart);
+	result.disconnectTime = std::chrono::duration_cast<std::chrono::microseconds>(disconnectEnd - stopStart);
+	_results.push_back(result);
+
+	GHOST_INFO(_logger) << "Publisher with " << subscribersCount << " subscribers stopped in "
+			    << result.stopTime.count() / 1000 << " ms, subscribers disconnected after "
+			    << result.disconnectTime.count() / 1000 << " ms.";
+
+	for (auto& subscriber : subscribers) subscriber->stop();
+	return true;
+}
+
+void PublisherShutdownTest::onPrintSummary() const
+{
+	GHOST_INFO(_logger) << "Publisher stop time:";
+	GHOST_INFO(_logger) << std::setw(12) << "subscribers" << std::setw(14) << "connect ms" << std::setw(12)
+			    << "stop ms" << std::setw(18) << "disconnected ms" << std::setw(20) << "stop us/subscriber";
+
+	for (const auto& result : _results)
+	{
+		long long perSubscriber =
+		    result.subscribers > 0 ? result.stopTime.count() / static_cast<long long>(result.subscribers) : 0;
+		GHOST_INFO(_logger) << std::setw(12) << result.subscribers << std::setw(14)
+				    << result.connectTime.count() / 1000 << std::setw(12)
+				    << result.stopTime.count() / 1000 << std::setw(18)
+				    << result.disconnectTime.count() / 1000 << std::setw(20) << perSubscriber;
+	}
+}
+
+std::string PublisherShutdownTest::getName() const
+{
+	return TEST_NAME;
+}
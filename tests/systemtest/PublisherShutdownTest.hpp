@@ -0,0 +1,70 @@
+/*
+ * Copyright 2020 Mathieu Nassar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GHOST_TESTS_PUBLISHERSHUTDOWNTEST_HPP
+#define GHOST_TESTS_PUBLISHERSHUTDOWNTEST_HPP
+
+#include <chrono>
+#include <ghost/connection/ConnectionManager.hpp>
+#include <memory>
+#include <vector>
+
+#include "Systemtest.hpp"
+
+/**
+ *	Measures how the time needed to stop a publisher grows with the number of its subscribers.
+ *	For each step of the ramp (parameter "steps", default: 100,500,1000,2000), a new publisher is
+ *	started, that many subscribers connect to it, and the duration of the publisher's "stop" call is
+ *	recorded, as well as the time the subscribers need to notice it. The summary prints the resulting
+ *	curve.
+ */
+class PublisherShutdownTest : public Systemtest
+{
+public:
+	PublisherShutdownTest(const std::shared_ptr<ghost::ThreadPool>& threadPool,
+			      const std::shared_ptr<ghost::Logger>& logger);
+
+	std::string getName() const override;
+
+private:
+	struct StepResult
+	{
+		size_t subscribers;
+		std::chrono::microseconds connectTime;
+		std::chrono::microseconds stopTime;
+		std::chrono::microseconds disconnectTime;
+	};
+
+	bool setUp() override;
+	void tearDown() override;
+	bool run() override;
+	void onPrintSummary() const override;
+
+	bool runStep(size_t subscribersCount, int port);
+
+	static const std::string TEST_NAME;
+	static const int BASE_PORT;
+
+	std::shared_ptr<ghost::ConnectionManager> _connectionManager;
+
+	// configuration read from the command line
+	std::vector<size_t> _steps;
+
+	std::vector<StepResult> _results;
+};
+
+#endif // GHOST_TESTS_PUBLISHERSHUTDOWNTEST_HPP
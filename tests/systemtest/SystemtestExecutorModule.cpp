@@ -18,8 +18,12 @@
 
 #include <gtest/gtest.h>
 
+#include "ConnectionChurnTest.hpp"
+#include "IdleConnectionsTest.hpp"
 #include "ConnectionMonkeyTest.hpp"
 #include "ConnectionStressTest.hpp"
+#include "PublisherFanoutTest.hpp"
+#include "PublisherShutdownTest.hpp"
 #include "StopSystemtestCommand.hpp"
 #include "SystemtestCommand.hpp"
 
@@ -33,6 +37,10 @@ bool SystemtestExecutorModule::initialize(const ghost::Module& module)
 
 	registerSystemtest(std::make_shared<ConnectionStressTest>(module.getThreadPool(), _logger));
 	registerSystemtest(std::make_shared<ConnectionMonkeyTest>(module.getThreadPool(), _logger));
+	registerSystemtest(std::make_shared<PublisherFanoutTest>(module.getThreadPool(), _logger));
+	registerSystemtest(std::make_shared<ConnectionChurnTest>(module.getThreadPool(), _logger));
+	registerSystemtest(std::make_shared<PublisherShutdownTest>(module.getThreadPool(), _logger));
+	registerSystemtest(std::make_shared<IdleConnectionsTest>(module.getThreadPool(), _logger));
 
 	GHOST_INFO(_logger) << "Systemtest executor initialized";
 	return true;